@@ -0,0 +1,106 @@
+/**
+ * @file  checkpoint.h
+ *
+ * @brief Save and restore the complete simulator state as one flat, versioned
+ *        image so a long run can continue from where it stopped instead of
+ *        re-simulating from cycle 0.
+ *
+ *        Image layout (native endianness, written with a single fwrite):
+ *          CheckpointHeader_t
+ *          MemoryRequest_t   parser's pending request  (if has_next_request)
+ *          TraceImporter_t   importer                   (the rest of the record the pending request came from)
+ *          MemoryRequest_t   pending[num_pending]       (taken from the parser, awaiting admission)
+ *          MemoryRequest_t   queue[queue_size]          (index 0 is the oldest)
+ *          Channel_t         channels[NUM_CHANNELS]     (banks and timers)
+ *          Stats_t           stats
+ *          HazardTable_t     hazards                    (the queued requests' sequence numbers)
+ *          Prefetcher_t      prefetcher                 (if has_prefetcher)
+ *          CoreModel_t       cores                      (if has_core_model)
+ *          HotRows_t         run counts, up to the file (if hot_rows; the interval starts over)
+ *          RowHammer_t       rowhammer                  (if has_rowhammer)
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef __CHECKPOINT_H__
+#define __CHECKPOINT_H__
+
+#include "common.h"
+#include "config.h"
+#include "simulator.h"
+
+/*** macro(s), enum(s), struct(s) ***/
+#define CHECKPOINT_MAGIC "DDR5CKPT"
+#define CHECKPOINT_VERSION 18
+
+typedef struct __attribute__((__packed__)) CheckpointHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t request_size;  // sizeof(MemoryRequest_t), guards against layout changes
+  uint32_t channel_size;  // sizeof(Channel_t)
+  uint32_t stats_size;    // sizeof(Stats_t)
+  uint32_t checksum;      // FNV-1a over everything after the header
+  uint64_t image_size;    // header + payload
+  uint64_t clock_cycle;
+  uint64_t parser_offset;  // input file position right after the pending request's line or record
+  uint64_t output_offsets[MAX_OUTPUT_SINKS];  // bytes each sink has written so far
+  uint64_t admitted_requests;
+  uint32_t cpu_mhz;        // the clock ratio decides which cycles are DIMM cycles
+  uint32_t data_rate;
+  uint32_t queue_size;
+  uint8_t scheduling_policy;
+  uint8_t dimms_per_channel;  // the address mapping depends on the ranks, tRTRS on the DIMMs they sit on
+  uint8_t ranks_per_dimm;
+  uint8_t command_rate;    // the command and data bus timing
+  uint8_t burst_length;
+  uint8_t burst_chop;
+  uint8_t parser_status;
+  uint8_t trace_format;    // the parser offset only means something in the same format
+  uint8_t has_next_request;
+  uint8_t num_pending;
+  uint8_t admit_width;
+  uint8_t has_prefetcher;
+  uint8_t has_core_model;
+  uint8_t hot_rows;        // rows tracked, 0 = off
+  uint8_t has_rowhammer;
+  uint8_t num_outputs;
+  uint8_t output_kinds[MAX_OUTPUT_SINKS];  // the offsets only fit the same sinks in the same order
+} CheckpointHeader_t;
+
+/*** function declaration(s) ***/
+/**
+ * @brief Write the simulator state to a checkpoint file. The image is written
+ *        to a temporary file first and renamed, so an interrupted write never
+ *        clobbers the previous checkpoint.
+ *
+ * @param sim        The simulator
+ * @param file_name  The checkpoint file name
+ */
+void checkpoint_save(Simulator_t *sim, char *file_name);
+
+/**
+ * @brief Rebuild a simulator from a checkpoint. Each command output continues
+ *        at its saved offset when its file still holds that much, otherwise a
+ *        new file is started from the checkpoint cycle.
+ *
+ * @param config  The simulation parameters; restore_file names the checkpoint
+ * @return Simulator_t*  The simulator, ready to continue
+ */
+Simulator_t *checkpoint_restore(Config_t *config);
+
+/**
+ * @brief Request a checkpoint on the next cycle whenever SIGUSR1 arrives.
+ *
+ * @param accept  false ignores SIGUSR1 instead, for runs that cannot be checkpointed
+ */
+void checkpoint_install_signal_handler(bool accept);
+
+/**
+ * @brief Check (and clear) a pending on-demand checkpoint request.
+ *
+ * @return true  if SIGUSR1 was received since the last call
+ */
+bool checkpoint_requested(void);
+
+#endif
@@ -21,6 +21,8 @@
 #endif
 
 
+#define NUM_CORES 12
+
 enum SchedulingAlgorithms {
   LEVEL_0,
   LEVEL_1,
@@ -0,0 +1,108 @@
+/**
+ * @file  config.h
+ *
+ * @brief Simulation parameters collected from the command line.
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef __CONFIG_H__
+#define __CONFIG_H__
+
+#include "common.h"
+#include "output.h"
+
+/*** macro(s), enum(s), struct(s) ***/
+#define MAX_QUEUE_SIZE 16
+#define MAX_ADMIT_WIDTH MAX_QUEUE_SIZE  // more could never be admitted in one cycle
+#define DEFAULT_INPUT_FILE "trace.txt"
+#define DEFAULT_OUTPUT_FILE "dram.txt"
+#define DEFAULT_CHECKPOINT_FILE "simulator.ckpt"
+#define MAX_LOAD_SCALES 16  // intensities of one load curve
+#define MAX_DUEL_POLICIES 4  // candidates of the set-dueling selector
+
+typedef struct Config {
+  char *input_file;
+  uint8_t trace_format;    // TraceFormat_t
+  uint8_t address_policy;  // AddressPolicy_t, NUM_ADDRESS_POLICIES = the format's default
+  char *output_file;
+  uint8_t num_outputs;                        // sinks of the command output
+  uint8_t output_kinds[MAX_OUTPUT_SINKS];     // SinkKind_t
+  char *output_files[MAX_OUTPUT_SINKS];       // NULL for the null sink and a stats sink on stdout
+  uint8_t scheduling_policy;
+  int8_t preset;         // PresetId_t given with --preset, -1 = none
+  bool generic_engine;   // do not hand a preset run to its specialized build
+  uint32_t cpu_mhz;      // CPU clock, trace times are in its cycles
+  uint32_t data_rate;    // DRAM MT/s, the command clock and the output run at half of it
+  uint8_t command_rate;  // 1N or 2N command timing
+  uint8_t admit_width;   // trace requests admitted to the queue per CPU cycle
+  bool print_stats;      // print a statistics summary at the end of the run
+  uint8_t burst_length;  // BL16 or BL32
+  bool burst_chop;       // BC8 transfers within a BL16 slot
+  uint8_t dimms_per_channel;  // 1DPC or 2DPC
+  uint8_t ranks_per_dimm;     // dimms_per_channel * ranks_per_dimm is 1, 2 or 4 ranks per channel
+  bool prefetch;              // memory-side stream prefetcher
+  uint8_t prefetch_degree;    // lines fetched ahead of a confirmed stream
+
+  // closed-loop core model
+  bool closed_loop;           // trace times become per-core compute gaps
+  uint16_t core_mlp;          // outstanding reads per core
+  uint8_t dependency;         // DependencyModel_t
+
+  // checkpoint / restore
+  char *checkpoint_file;         // where checkpoints are written
+  uint64_t checkpoint_interval;  // cpu cycles between periodic checkpoints, 0 = on demand only
+  char *restore_file;            // checkpoint to resume from, NULL = start at cycle 0
+
+  // sampled simulation
+  bool sample;              // fast-forward between detailed windows instead of simulating every request
+  uint64_t sample_period;   // requests from one window start to the next
+  uint64_t sample_warmup;   // detailed requests before measuring
+  uint64_t sample_window;   // detailed requests measured per window
+
+  // trace-event export
+  char *timeline_file;      // Chrome trace-event JSON, NULL = no export
+  uint64_t timeline_start;  // first DIMM cycle exported
+  uint64_t timeline_end;    // DIMM cycle the export stops before, UINT64_MAX = end of the run
+
+  // interval statistics
+  uint64_t interval_cycles;  // DIMM cycles per interval, 0 = off
+  char *interval_file;       // NULL = intervals.csv or intervals.bin by format
+  uint8_t interval_format;   // IntervalFormat_t
+
+  // hot-row tracking
+  uint8_t hot_rows;            // rows reported, 0 = off
+  uint64_t hot_rows_interval;  // DIMM cycles per CSV interval, 0 = summary only
+  char *hot_rows_file;         // CSV of the hot rows of each interval
+
+  // RowHammer mitigation
+  uint8_t rfm_mode;         // RfmMode_t
+  uint16_t raa_imt;         // RAA that makes an RFM due
+  uint16_t raa_mmt;         // RAA that holds new requests until the RFM, 0 = RAA_MMT_FACTOR x raa_imt
+  uint16_t prac_threshold;  // PRAC back-off threshold, 0 = no PRAC
+  uint8_t prac_rfms;        // RFMab per PRAC back-off
+
+  // set-dueling policy selection
+  uint8_t num_duel_policies;                   // candidates, 0 = the level given with -s throughout
+  uint8_t duel_policies[MAX_DUEL_POLICIES];    // scheduling levels, the first one starts live
+  uint64_t duel_epoch;                         // CPU cycles between decisions
+  uint8_t duel_sample;                         // the shadows follow one bank in duel_sample
+
+  // load-latency curve
+  uint8_t num_load_scales;  // intensities replayed, 0 = off
+  double load_scales[MAX_LOAD_SCALES]; // offered load relative to the trace, increasing
+  uint64_t latency_slo;     // average CPU cycles a sustainable load stays under
+  uint16_t load_threads;    // simulations run at once, 0 = one per online CPU
+  char *load_curve_file;    // CSV of every point simulated
+
+  // epoch-parallel simulation
+  uint64_t epochs;        // time epochs simulated on their own threads, 1 = sequential
+  uint64_t epoch_warmup;  // cpu cycles replayed before each boundary
+} Config_t;
+
+/*** function declaration(s) ***/
+void config_init(Config_t *config);
+uint8_t config_rank_bits(Config_t *config);
+
+#endif
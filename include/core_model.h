@@ -0,0 +1,93 @@
+/**
+ * @file  core_model.h
+ *
+ * @brief Closed-loop driver for the 12 cores. Instead of replaying the trace
+ *        at its timestamps, each core turns the time between two of its own
+ *        requests into a compute gap and releases the next request only once
+ *        that gap has elapsed, it has a free miss slot (MLP limit) and no
+ *        earlier request it depends on is still outstanding. A faster
+ *        controller therefore lets the cores issue sooner.
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef __CORE_MODEL_H__
+#define __CORE_MODEL_H__
+
+#include "common.h"
+#include "memory_request.h"
+#include "parser.h"
+
+/*** macro(s), enum(s), struct(s) ***/
+#define CORE_LOOKAHEAD 64   // trace requests buffered per core
+#define DEFAULT_CORE_MLP 8  // outstanding reads per core
+
+typedef enum DependencyModel {
+  DEPENDENCY_NONE,    // only the MLP limit holds a core back
+  DEPENDENCY_IFETCH,  // an instruction fetch stalls the core until it returns
+  DEPENDENCY_LOADS    // every read stalls the core until it returns (pointer chasing)
+} DependencyModel_t;
+
+typedef struct Core {
+  MemoryRequest_t pending[CORE_LOOKAHEAD];  // ring of trace requests not yet released
+  uint64_t gaps[CORE_LOOKAHEAD];            // compute cycles before each pending request
+  uint8_t head;
+  uint8_t count;
+  uint64_t last_trace_time;   // trace time of the last request read for this core
+  uint64_t resume_cycle;      // cycle the core last issued or was unblocked
+  uint16_t outstanding;       // reads released and not yet completed
+  bool blocked;               // waiting for a request it depends on
+
+  // statistics
+  uint64_t released;
+  uint64_t completed;
+  uint64_t total_latency;
+  uint64_t compute_cycles;     // sum of the compute gaps
+  uint64_t issue_stall_cycles;  // compute done, waiting for a miss slot or the controller
+  uint64_t dependency_stall_cycles;
+} Core_t;
+
+typedef struct CoreModel {
+  Core_t cores[NUM_CORES];
+  uint16_t mlp;
+  DependencyModel_t dependency;
+  uint8_t next_core;  // round-robin start for the next release
+} CoreModel_t;
+
+/*** function declaration(s) ***/
+void core_model_init(CoreModel_t *model, uint16_t mlp, DependencyModel_t dependency);
+
+/**
+ * @brief Release the next request of a core that is ready to issue. Takes the
+ *        place of parser_next_request() in closed-loop runs.
+ *
+ * @param model   The core model
+ * @param parser  The parser, read ahead to keep every core's buffer filled
+ * @param cycle   The current cpu cycle
+ * @param request Filled with the released request (time set to cycle)
+ * @return true  if a core released a request
+ */
+bool core_model_next_request(CoreModel_t *model, Parser_t *parser, uint64_t cycle, MemoryRequest_t *request);
+
+/**
+ * @brief Free the miss slot of a completed request and unblock its core.
+ */
+void core_model_complete(CoreModel_t *model, MemoryRequest_t *request, uint64_t cycle);
+
+/**
+ * @brief The earliest cycle a core could release a request without waiting
+ *        for a completion, UINT64_MAX if none can.
+ */
+uint64_t core_model_next_release(CoreModel_t *model);
+
+/**
+ * @brief true once every buffered request has been released.
+ */
+bool core_model_is_drained(CoreModel_t *model);
+
+DependencyModel_t core_model_parse_dependency(char *name);
+const char *core_model_dependency_name(DependencyModel_t dependency);
+void core_model_print_stats(CoreModel_t *model, FILE *stream);
+
+#endif
@@ -1,7 +1,8 @@
 /**
  * @file  dram.h
  *
- * @note the following timing constrains are actually one dimm cycle longer:
+ * @note the following timing constrains are actually one dimm cycle longer
+ *       (DIMM cycles at DDR5-4800):
  *            tRC -> 115
  *            tRP -> 39
  *            tRRD_L -> 12, tRRD_S -> 8
@@ -19,49 +20,69 @@
 #define __DIMM_H__
 
 #include "common.h"
+#include "hazard.h"
 #include "memory_request.h"
+#include "output.h"
+#include "preset.h"
 #include "queue.h"
+#include "stats.h"
+#include "time_base.h"
 
 /*** macro(s), enum(s), struct(s) ***/
-#define TRC       114 // time interval between successive ACT commands to the same bank
-#define TRAS       76 // time interval between a bank ACT command and issuing the PRE command
-#define TRP        38 // time interval between a PRE command and a ACT command
-#define TRFC      708 // 295ns; time it takes to complete a refresh command
-#define TCWL       38 // aka tCWD; time interval between a WR command and the output of the first bit of data
-#define TCL        40 // aka tCAS; time interval between a RD command and the output of the first bit of data
-#define TRCD       38 // time interval between a ACT command and a RD/WR command
-#define TWR        30 // time interval between writing data and issuing a PRE command
-#define TRTP       18 // delay between internal RD command to PRE command within the same bank
-#define TBURST      8 // delay between the start and end of RD/WR data 
+// timing constraints in picoseconds; dimm_set_time_base() turns them into DIMM cycles of the run's
+// data rate, rounded up. Each is its DDR5-4800 cycle count times 416.67 ps, rounded down.
+#define TRC_PS        47500 // time interval between successive ACT commands to the same bank
+#define TRAS_PS       31666 // time interval between a bank ACT command and issuing the PRE command
+#define TRP_PS        15833 // time interval between a PRE command and a ACT command
+#define TRFC_PS      295000 // time it takes to complete a refresh command
+#define TCWL_PS       15833 // aka tCWD; time interval between a WR command and the output of the first bit of data
+#define TCL_PS        16666 // aka tCAS; time interval between a RD command and the output of the first bit of data
+#define TRCD_PS       15833 // time interval between a ACT command and a RD/WR command
+#define TWR_PS        12500 // time interval between writing data and issuing a PRE command
+#define TRTP_PS        7500 // delay between internal RD command to PRE command within the same bank
 #define NUM_TIMING_CONSTRAINTS 10 
 
-#define TRRD_L     11 // time interval between consecutive ACT commands to the same bank group
+#define TRRD_L_PS      4583 // time interval between consecutive ACT commands to the same bank group
+#define TCCD_L_PS      4583 // time interval between consecutive RD commands between different banks in the same bank group
+#define TCCD_L_WR_PS  19583 // time interval between consecutive WR commands between different banks in the same bank group
+#define TCCD_L_RTW_PS  6250 // READ -> WRITE in the same bank group
+#define TCCD_S_RTW_PS  6250 // READ -> WRITE in different bank group
+#define TCCD_L_WTR_PS 28750 // WRITE -> READ in the same bank group
+#define TCCD_S_WTR_PS 21250 // WRITE -> READ in different bank group
+
+// constraints JEDEC gives in clocks stay the same number of DIMM cycles at every data rate
+#define TBURST      8 // delay between the start and end of RD/WR data 
 #define TRRD_S      7 // time interval between consecutive ACT commands to different bank group
-#define TCCD_L     11 // time interval between consecutive RD commands between different banks in the same bank group
 #define TCCD_S      7 // time interval between consecutive RD commands between different banks in different bank group
-#define TCCD_L_WR  47 // time interval between consecutive WR commands between different banks in the same bank group
 #define TCCD_S_WR   7 // time interval between consecutive WR commands between different banks in different bank group
-#define TCCD_L_RTW 15 // READ -> WRITE in the same bank group
-#define TCCD_S_RTW 15 // READ -> WRITE in different bank group
-#define TCCD_L_WTR 69 // WRITE -> READ in the same bank group
-#define TCCD_S_WTR 51 // WRITE -> READ in different bank group
-#define NUM_CONSECUTIVE_CMD_CONSTRAINTS 10
+#define NUM_SPACED_COMMANDS 3  // ACTIVATE, READ and WRITE are spaced per rank and bank group
+#define TIMING_CYCLE_ORIGIN 256 // first channel timing cycle, past the longest spacing so unused entries never block
 
-#define TFAW       32 // time window where there can be at most four ACT commands
+#define TFAW_PS 13333 // time window where there can be at most four ACT commands,
+#define TFAW       32 // but never less than 32 clocks
 #define NUM_TFAW_COUNTERS 4
 
+#define TRTRS       2 // data bus turnaround between bursts from different ranks on the same DIMM
+#define TRTRS_DIMM  3 // data bus turnaround between bursts from ranks on different DIMMs (ODT switch)
+
 #define NUM_BANKS 32
 #define NUM_BANK_GROUPS 8
 #define NUM_BANKS_PER_GROUP (NUM_BANKS / NUM_BANK_GROUPS)
 #define NUM_CHANNELS 2
-#define NUM_CHIPS_PER_CHANNEL 4
+#define MAX_RANKS_PER_CHANNEL 4
+#define MAX_DIMMS_PER_CHANNEL 2
+
+#define CHANNEL_WIDTH_BYTES 4            // 32-bit DDR5 subchannel
+#define CHANNEL_PEAK_GBPS(data_rate) ((data_rate) * CHANNEL_WIDTH_BYTES / 1e3)  // MT/s x 4 bytes
+#define DIMM_PEAK_GBPS(data_rate) (CHANNEL_PEAK_GBPS(data_rate) * NUM_CHANNELS)
+#define MAX_DATA_BUS_RESERVATIONS 32  // bursts scheduled on one channel and not over yet, see Timings_t
+// bursts start up to 2N + latency cycles after their command and the shortest burst slot is a BL16 one;
+// one more for the burst ending as the next is scheduled
+#define DATA_BUS_RESERVATIONS(latency) ((COMMAND_RATE_2N + (latency) + TBURST - 1) / TBURST + 2)
 
 #define CACHE_LINE_BOUNDARY 64
 #define BANK_ALIGN 8
 
-extern uint16_t timing_attribute[NUM_TIMING_CONSTRAINTS];
-extern uint8_t consecutive_cmd_attribute[NUM_CONSECUTIVE_CMD_CONSTRAINTS];
-
 typedef enum TimingConstraints {
   tRC,
   tRAS,
@@ -75,25 +96,26 @@ typedef enum TimingConstraints {
   tBURST
 } TimingConstraints_t;
 
-typedef enum ConsecutiveCmdConstraints {
-  tRRD_L,
-  tRRD_S,
-  tCCD_L,
-  tCCD_S,
-  tCCD_L_WR,
-  tCCD_S_WR,
-  tCCD_L_RTW,
-  tCCD_S_RTW,
-  tCCD_L_WTR,
-  tCCD_S_WTR
-} ConsecutiveCmdConstraints_t;
 
 
+// the timing constraints in DIMM cycles of the run's data rate, see dimm_set_time_base()
+typedef struct Timings {
+  uint16_t constraints[NUM_TIMING_CONSTRAINTS];  // indexed by TimingConstraints_t
+  // from the second half of a command to the first half of the next one on the same rank,
+  // [previous][next][other bank group, same bank group]; same-bank constraints are bank timers
+  uint16_t spacing[NUM_SPACED_COMMANDS][NUM_SPACED_COMMANDS][2];
+  uint8_t tfaw;
+  // bursts on one channel can be scheduled up to 2N + max(tCL, tCWL) ahead and never overlap,
+  // so at most this many of them are not over yet whichever ranks drive them
+  uint8_t data_bus_reservations;
+} Timings_t;
+
+// one bit per bank of a rank, bank group major: bit bank_group * NUM_BANKS_PER_GROUP + bank
+typedef uint32_t BankMask_t;
+#define BANK_BIT(bank_group, bank) ((BankMask_t)1 << ((bank_group) * NUM_BANKS_PER_GROUP + (bank)))
+_Static_assert(NUM_BANKS <= 32, "a BankMask_t holds one bit per bank of a rank");
+
 typedef struct __attribute__((__packed__)) Bank {
-  bool is_precharged;
-  bool is_active;
-  bool in_progress;
-  Operation_t last_request_operation;
   uint32_t active_row;
 } Bank_t;
 
@@ -103,27 +125,153 @@ typedef struct __attribute__((aligned(CACHE_LINE_BOUNDARY))) BankGroup {
 
 typedef struct DRAM {
   BankGroup_t bank_groups[NUM_BANK_GROUPS];
+  BankMask_t open_banks;        // holding a row
+  BankMask_t precharged_banks;
+  BankMask_t busy_banks;        // a request has started a command and its data is not through yet
+  BankMask_t write_banks;       // the last request to the bank was a write, PRE waits for tWR
+  uint8_t pins[NUM_BANK_GROUPS][NUM_BANKS_PER_GROUP];  // requests still to read or write the open row, which no PRE closes
+  BankMask_t armed[NUM_TIMING_CONSTRAINTS];  // banks whose timer of that constraint is still running
   uint16_t timing_constraints[NUM_BANK_GROUPS][NUM_BANKS_PER_GROUP][NUM_TIMING_CONSTRAINTS];
   uint8_t tFAW_timers[NUM_TFAW_COUNTERS];
-  uint8_t consecutive_cmd_timers[NUM_CONSECUTIVE_CMD_CONSTRAINTS];
-  uint8_t last_bank_group;
-  Commands_t last_interface_cmd;
+  uint64_t last_issue[NUM_SPACED_COMMANDS][NUM_BANK_GROUPS];  // timing cycle of the last ACT/RD/WR to each bank group
+  uint64_t last_issue_any[NUM_SPACED_COMMANDS];                // and to any bank group
+  uint16_t timers_running;  // cycles until every timer of the rank has expired, idle ranks are not ticked
 } DRAM_t;
 
+typedef enum CommandRate {
+  COMMAND_RATE_1N = 1,  // one command slot per DIMM cycle
+  COMMAND_RATE_2N = 2   // every command half is held on the bus for two DIMM cycles
+} CommandRate_t;
+
+typedef struct CommandBus {
+  uint8_t busy_timer;         // cycles until the bus takes a new command
+  uint8_t second_half_timer;  // cycles until the reserved second half of ACT/RD/WR is due
+  uint64_t busy_cycles;       // cycles the bus carried a command
+  uint64_t elapsed_cycles;    // cycles the bus was simulated (requests were pending)
+  uint64_t commands;          // ACT, RD, WR and PRE commands issued
+} CommandBus_t;
+
+typedef struct DataBus {
+  uint64_t reservation_start[MAX_DATA_BUS_RESERVATIONS];  // DIMM cycle the burst starts on DQ
+  uint64_t reservation_end[MAX_DATA_BUS_RESERVATIONS];    // first DIMM cycle after the burst
+  uint8_t reservation_rank[MAX_DATA_BUS_RESERVATIONS];    // rank driving the burst
+  uint64_t last_burst_end;    // end of the latest burst, to find idle gaps
+  uint8_t last_burst_rank;
+  uint64_t rank_switches;     // consecutive bursts from different ranks
+  uint64_t bursts;
+  uint64_t busy_cycles;       // cycles data was actually transferred
+  uint64_t bytes;
+  uint64_t idle_gaps;         // gaps between consecutive bursts
+  uint64_t idle_gap_cycles;
+  uint64_t max_idle_gap;
+} DataBus_t;
+
+// one DRAM_t per rank: the chips of a rank act in lockstep, so they share bank and timer state
 typedef struct Channel {
-  DRAM_t DDR5_chip[NUM_CHIPS_PER_CHANNEL];
+  DRAM_t ranks[MAX_RANKS_PER_CHANNEL];
+  uint64_t timing_cycle;  // DIMM cycles the timers have advanced (requests were pending)
+  CommandBus_t command_bus;
+  DataBus_t data_bus;
 } Channel_t;
 
+typedef enum BurstLength {
+  BL16 = 16,
+  BL32 = 32
+} BurstLength_t;
+
+struct Prefetcher;
+struct CoreModel;
+struct Timeline;
+struct IntervalStats;
+struct HotRows;
+struct RowHammer;
+struct Dueling;
+struct Scheduler;
+
 typedef struct DIMM {
   Channel_t channels[NUM_CHANNELS];
-  FILE *output_file;
+  Stats_t stats;
+  HazardTable_t hazards;  // same-line ordering of the queued reads and writes
+  CommandRate_t command_rate;
+  BurstLength_t burst_length;
+  bool burst_chop;     // BC8: half the data of a BL16 burst in the same slot
+  uint8_t dimms_per_channel;
+  uint8_t ranks_per_dimm;
+  uint8_t num_ranks;   // ranks per channel, dimms_per_channel * ranks_per_dimm
+  TimeBase_t time_base;  // CPU to DIMM clock ratio, the output is in DIMM cycles
+  Timings_t timings;     // timing constraints at the time base's data rate, read through DIMM_TIMINGS()
+  const struct Scheduler *scheduler;  // picks the request that gets the command bus
+  struct Prefetcher *prefetcher;  // receives completed prefetches, NULL when prefetching is off
+  struct CoreModel *cores;        // frees the core's miss slot on completion, NULL in open-loop runs
+  Output_t output;                // sinks the issued commands go to
+  struct Timeline *timeline;      // trace-event export of commands, bursts and requests, NULL when off
+  struct IntervalStats *intervals;  // statistics every N DIMM cycles, NULL when off
+  struct HotRows *hot_rows;       // row activation tracking, NULL when off
+  struct RowHammer *rowhammer;    // RFM and PRAC mitigation, NULL when off
+  struct Dueling *dueling;        // set-dueling policy selection, reported with the statistics, NULL when off
 } DIMM_t;
 
+// the setup read on every DIMM cycle, folded to constants in a FIXED_PRESET build
+#ifdef FIXED_PRESET
+#define DIMM_NUM_RANKS(dimm) (FIXED_PRESET_ENTRY.dimms_per_channel * FIXED_PRESET_ENTRY.ranks_per_dimm)
+#define DIMM_COMMAND_RATE(dimm) ((CommandRate_t)FIXED_PRESET_ENTRY.command_rate)
+#define DIMM_BURST_LENGTH(dimm) ((BurstLength_t)FIXED_PRESET_ENTRY.burst_length)
+#define DIMM_BURST_CHOP(dimm) (FIXED_PRESET_ENTRY.burst_chop)
+#else
+#define DIMM_NUM_RANKS(dimm) ((dimm)->num_ranks)
+#define DIMM_COMMAND_RATE(dimm) ((dimm)->command_rate)
+#define DIMM_BURST_LENGTH(dimm) ((dimm)->burst_length)
+#define DIMM_BURST_CHOP(dimm) ((dimm)->burst_chop)
+#endif
+
 /*** function declaration(s) ***/
-void dimm_create(DIMM_t **dimm, char *output_file_name);
+void dimm_create(DIMM_t **dimm);
+void dimm_set_command_rate(DIMM_t *dimm, CommandRate_t command_rate);
+void dimm_set_burst_length(DIMM_t *dimm, BurstLength_t burst_length, bool burst_chop);
+void dimm_set_ranks(DIMM_t *dimm, uint8_t dimms_per_channel, uint8_t ranks_per_dimm);
+void dimm_set_time_base(DIMM_t *dimm, uint32_t cpu_mhz, uint32_t data_rate);
+void dimm_set_scheduler(DIMM_t *dimm, const struct Scheduler *scheduler);
 void dimm_destroy(DIMM_t **dimm);
-void process_request(DIMM_t **dimm, Queue_t **q, uint64_t dimm_cycle, uint8_t scheduling_algorithm);
-void check_requests_age(Queue_t *global_queue);
+void process_request(DIMM_t **dimm, Queue_t **q, uint64_t clock);
+void dimm_functional_access(DIMM_t *dimm, MemoryRequest_t *request);
+void dimm_clear_timers(DIMM_t *dimm);
+bool dimm_is_page_miss(DIMM_t *dimm, MemoryRequest_t *request);
+
+/**
+ * @brief Banks of a rank whose timers allow the command a request in this
+ *        state issues next. Only the per-bank and tFAW timers are covered;
+ *        the command spacing and the buses are still checked at issue. AND
+ *        with open_banks or precharged_banks to pick by page state.
+ *
+ * @param dram   The rank
+ * @param state  ACT0, RD0, WR0 or PRE; every other state gives all banks
+ * @return BankMask_t  one bit per ready bank, see BANK_BIT()
+ */
+BankMask_t dram_ready_banks(DRAM_t *dram, MemoryRequestState_t state);
+void dimm_print_stats(DIMM_t *dimm, uint64_t clock_cycle, FILE *stream);
+
+/**
+ * @brief Write the statistics summary to every stats sink of the output.
+ */
+void dimm_report_stats(DIMM_t *dimm, uint64_t clock_cycle);
 void increment_aging_in_queue(Queue_t *global_queue);
 
+/**
+ * @brief Advance a request by at most one command under the closed or open
+ *        page policy, if the timing and the buses allow it. Used by the
+ *        schedulers, which decide the order requests are offered in.
+ *
+ * @return true  if a command was issued
+ */
+bool closed_page(DIMM_t **dimm, MemoryRequest_t *request, uint64_t clock);
+bool open_page(DIMM_t **dimm, MemoryRequest_t *request, uint64_t cycle);
+
+/**
+ * @brief Hand a finished request to the statistics, the core model or the
+ *        prefetch buffer. The scheduler removes it from the queue.
+ */
+void complete_request(DIMM_t *dimm, MemoryRequest_t *request, uint64_t clock);
+bool is_second_half(MemoryRequestState_t state);
+bool is_column_command(MemoryRequestState_t state);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,112 @@
+/**
+ * @file  dueling.h
+ *
+ * @brief Set-dueling policy selection (--duel): the live run switches
+ *        between candidate scheduling levels at epoch boundaries, picking
+ *        the level that did best in the epoch that just ended.
+ *
+ *        Every candidate has a shadow model, a simulator of its own that
+ *        replays the same trace with that level but reads only the requests
+ *        to one bank in N, with a queue scaled down by the same factor. The
+ *        shadows run in step with the live clock and write no output. At a
+ *        boundary the shadow that completed the most requests in the epoch
+ *        wins; when the completions are within DUEL_TIE of each other, the
+ *        lower average latency wins. The live policy changes only for a gain
+ *        of at least DUEL_MIN_GAIN, and only on a DIMM cycle with no command
+ *        half-issued, so the new policy never inherits a reserved bus slot.
+ *
+ *        The candidates must share their page policy: a closed-page level
+ *        cannot take over the open rows of an open-page one.
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef __DUELING_H__
+#define __DUELING_H__
+
+#include "common.h"
+#include "config.h"
+#include "dimm.h"
+#include "queue.h"
+#include "stats.h"
+
+/*** macro(s), enum(s), struct(s) ***/
+#define DEFAULT_DUEL_EPOCH 500000  // CPU cycles
+#define DEFAULT_DUEL_SAMPLE 4      // one bank in 4 is followed by the shadows
+#define DUEL_TIE 0.01              // completions this close are decided by latency
+#define DUEL_MIN_GAIN 0.02         // smaller gains keep the live policy
+#define MAX_REPORTED_SWITCHES 16
+
+typedef struct DuelSwitch {
+  uint64_t cycle;  // CPU cycle the new policy went live
+  uint8_t from;    // scheduling levels
+  uint8_t to;
+  double gain;     // estimated gain in the deciding metric, 0.05 = 5%
+  bool by_latency; // completions tied, decided on average latency
+} DuelSwitch_t;
+
+struct Simulator;
+
+typedef struct Dueling {
+  uint8_t num_policies;
+  uint8_t policies[MAX_DUEL_POLICIES];        // scheduling levels of the candidates
+  struct Simulator *shadows[MAX_DUEL_POLICIES];
+  Stats_t epoch_start[MAX_DUEL_POLICIES];     // shadow statistics at the start of the epoch
+  uint8_t bank_sample;
+  uint64_t epoch_cycles;
+  uint64_t epoch_end;  // CPU cycle
+  uint8_t live;        // candidate the live run follows
+  int8_t pending;      // candidate waiting for a cycle it can take over on, -1 = none
+  double pending_gain;
+  bool pending_by_latency;
+
+  // report
+  uint64_t epochs;
+  uint64_t live_epochs[MAX_DUEL_POLICIES];   // epochs each candidate ran live
+  uint64_t wins[MAX_DUEL_POLICIES];          // epochs each candidate's shadow won
+  Stats_t followed;                          // the shadow statistics of whichever candidate was live
+  uint64_t switches;
+  double gain_sum;                           // estimated gains of the switches
+  DuelSwitch_t log[MAX_REPORTED_SWITCHES];
+} Dueling_t;
+
+/*** function declaration(s) ***/
+/**
+ * @brief Start the shadows of the candidates at cycle 0. The live run starts
+ *        with the first candidate.
+ *
+ * @param dueling  The selector
+ * @param config   The simulation parameters; duel_policies, duel_epoch and duel_sample pick the candidates
+ */
+void dueling_init(Dueling_t *dueling, Config_t *config);
+
+/**
+ * @brief Bring the shadows up to the live clock, close the epoch at a
+ *        boundary and switch the live policy when a switch is due and safe.
+ *        Called at the start of every simulator step.
+ *
+ * @param dueling  The selector
+ * @param q        The live queue
+ * @param clock    The live CPU cycle
+ * @return int  The scheduling level to go live now, -1 to keep the current one
+ */
+int dueling_advance(Dueling_t *dueling, Queue_t *q, uint64_t clock);
+
+void dueling_print_stats(Dueling_t *dueling, FILE *stream);
+
+/**
+ * @brief Destroy the shadows.
+ */
+void dueling_close(Dueling_t *dueling);
+
+/**
+ * @brief Parse a comma-separated list of scheduling levels or names.
+ *
+ * @param list      The list, e.g. 1,3 or fcfs-open,blp-ooo
+ * @param policies  Filled with the levels
+ * @return int  The number of levels, -1 if the list is malformed or names a level twice
+ */
+int dueling_parse_policies(const char *list, uint8_t policies[MAX_DUEL_POLICIES]);
+
+#endif
@@ -0,0 +1,71 @@
+/**
+ * @file  epoch.h
+ *
+ * @brief Epoch-parallel simulation of a single trace. The trace is cut into
+ *        time epochs that are simulated on their own threads. Each epoch
+ *        starts a warmup stretch early (replaying the tail of the previous
+ *        epoch) so its banks and queue are warm at the boundary, and keeps
+ *        running the same stretch past its end so the next epoch's warmed-up
+ *        start can be compared against a run with the full history. A
+ *        backlog older than the next epoch's warmup would lose its commands
+ *        at the boundary, so that epoch is run again from where the backlog
+ *        built up.
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef __EPOCH_H__
+#define __EPOCH_H__
+
+#include "common.h"
+#include "config.h"
+#include "simulator.h"
+
+/*** macro(s), enum(s), struct(s) ***/
+#define DEFAULT_EPOCH_WARMUP 100000  // cpu cycles replayed before (and after) each boundary
+#define EPOCH_INDEX_STRIDE 1024      // requests between entries of the trace index
+
+typedef struct TraceIndexEntry {
+  uint64_t time;    // arrival time of the request
+  uint64_t offset;  // byte offset of its line in the input file
+} TraceIndexEntry_t;
+
+typedef struct Epoch {
+  // inputs
+  Config_t config;
+  uint64_t warmup_time;   // replay the trace from here on
+  uint64_t start_offset;  // first line to replay (warmup_time or earlier)
+  uint64_t start_time;    // commands and completions before this belong to the previous epoch
+  uint64_t end_time;      // commands and completions from here on belong to the next epoch
+  uint64_t stop_time;     // end_time + warmup; overlap used to measure the next boundary
+  bool is_last;
+
+  // outputs
+  FILE *commands;  // commands issued in [start_time, end_time)
+  FILE *overlap;   // commands issued in [end_time, stop_time)
+  Stats_t stats;   // completions in [start_time, end_time)
+  uint64_t busy_time;     // the simulator was last idle here before end_time; its backlog built up since
+  uint64_t final_cycle;
+  uint64_t dimm_end_time;   // end_time and stop_time as output (DIMM) cycles
+  uint64_t dimm_stop_time;
+} Epoch_t;
+
+typedef struct EpochBoundary {
+  uint64_t cycle;
+  uint64_t overlap_commands;  // commands the earlier epoch issued in the overlap
+  uint64_t mismatched_commands;
+  uint64_t converged_after;   // DIMM cycles after the boundary until the last mismatch
+} EpochBoundary_t;
+
+/*** function declaration(s) ***/
+/**
+ * @brief Run the trace as config->epochs parallel epochs, stitch the command
+ *        output and statistics together and report the boundary divergence.
+ *
+ * @param config  The simulation parameters
+ * @return uint64_t  The CPU clock cycle at which the run ended
+ */
+uint64_t run_epoch_parallel_simulation(Config_t *config);
+
+#endif
@@ -0,0 +1,101 @@
+/**
+ * @file  hazard.h
+ *
+ * @brief Per-line hazard table: keeps the reads and writes to each 64-byte
+ *        line in arrival order until their RD/WR command is issued, so that a
+ *        column command to a line never passes an older conflicting access to
+ *        the same line (read after write, write after read, write after
+ *        write). Two reads of a line may still pass each other, and requests
+ *        to different lines are free to go in any order, which leaves the
+ *        queue order entirely to the scheduler.
+ *
+ *        Every request gets a sequence number when it is admitted to the
+ *        queue. The table is a small open-addressing hash of the lines in
+ *        flight, each holding the sequence numbers of its unissued accesses,
+ *        oldest first.
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef __HAZARD_H__
+#define __HAZARD_H__
+
+#include "common.h"
+#include "config.h"
+#include "memory_request.h"
+
+/*** macro(s), enum(s), struct(s) ***/
+#define HAZARD_SLOTS 64               // power of two, four times the lines that can be in flight
+#define HAZARD_DEPTH MAX_QUEUE_SIZE   // every request in the queue can be to the same line
+
+typedef enum HazardKind {
+  HAZARD_RAW,  // a read waits for an older write
+  HAZARD_WAR,  // a write waits for an older read
+  HAZARD_WAW,  // a write waits for an older write
+  NUM_HAZARD_KINDS
+} HazardKind_t;
+
+typedef struct HazardAccess {
+  uint32_t sequence;
+  bool is_write;
+} HazardAccess_t;
+
+typedef struct HazardLine {
+  uint64_t line;   // address / BYTES_PER_LINE
+  uint8_t count;   // unissued accesses, 0 = free slot
+  HazardAccess_t accesses[HAZARD_DEPTH];  // oldest first
+} HazardLine_t;
+
+typedef struct HazardTable {
+  HazardLine_t slots[HAZARD_SLOTS];
+  uint32_t next_sequence;
+  uint8_t lines;      // slots in use
+
+  // report
+  uint64_t stalls[NUM_HAZARD_KINDS];  // column commands held back, one per DIMM cycle tried
+  uint8_t max_lines;
+  uint8_t max_depth;
+} HazardTable_t;
+
+/*** function declaration(s) ***/
+void hazard_init(HazardTable_t *table);
+
+/**
+ * @brief Number the request and append it to its line. Called once, when the
+ *        request enters the queue.
+ *
+ * @param table    The hazard table
+ * @param request  The request being admitted; its sequence is set
+ */
+void hazard_enqueue(HazardTable_t *table, MemoryRequest_t *request);
+
+/**
+ * @brief Whether the request's RD/WR may be issued: no older access to its
+ *        line that conflicts with it is still waiting.
+ *
+ * @param table    The hazard table
+ * @param request  The request about to issue its column command
+ * @return bool  true if the command may go
+ */
+bool hazard_is_clear(HazardTable_t *table, MemoryRequest_t *request);
+
+/**
+ * @brief hazard_is_clear() for the command about to be issued, counting a
+ *        refusal as a stall of its kind.
+ *
+ * @return bool  true if the command has to wait
+ */
+bool hazard_hold(HazardTable_t *table, MemoryRequest_t *request);
+
+/**
+ * @brief Drop the request from its line once its RD/WR is issued.
+ *
+ * @param table    The hazard table
+ * @param request  The request whose column command went out
+ */
+void hazard_release(HazardTable_t *table, MemoryRequest_t *request);
+
+void hazard_print_stats(HazardTable_t *table, FILE *stream);
+
+#endif
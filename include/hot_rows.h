@@ -0,0 +1,100 @@
+/**
+ * @file  hot_rows.h
+ *
+ * @brief Row activation tracking (--hot-rows): which rows are activated most
+ *        and how the activations spread over the banks, for performance and
+ *        for RowHammer exposure. Every ACT updates a count-min sketch, which
+ *        estimates a row's activations from the smallest of four counters, and
+ *        a small min-heap keeps the K rows with the highest estimates. Exact
+ *        counters are kept per bank only, so the memory used is fixed however
+ *        long the run is, and an ACT costs four counter updates and a scan of
+ *        the heap.
+ *
+ *        The run's heavy hitters and the activations of every bank are printed
+ *        with the statistics summary; with an interval, the hot rows of each
+ *        interval are written to a CSV file from a second sketch that is
+ *        cleared at every boundary.
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef __HOT_ROWS_H__
+#define __HOT_ROWS_H__
+
+#include "common.h"
+#include "dimm.h"
+#include "memory_request.h"
+
+/*** macro(s), enum(s), struct(s) ***/
+#define HOT_ROWS_DEPTH 4
+#define HOT_ROWS_WIDTH_BITS 14
+#define HOT_ROWS_WIDTH (1 << HOT_ROWS_WIDTH_BITS)  // an estimate overcounts by at most e/WIDTH of the ACTs, 98% of the time
+#define MAX_HOT_ROWS 64
+#define DEFAULT_HOT_ROWS_FILE "hot_rows.csv"
+
+typedef struct HotRow {
+  uint32_t key;          // channel, rank, bank group, bank and row, see hot_row_key()
+  uint32_t activations;  // count-min estimate
+} HotRow_t;
+
+typedef struct RowSketch {
+  uint32_t counters[HOT_ROWS_DEPTH][HOT_ROWS_WIDTH];
+  HotRow_t top[MAX_HOT_ROWS];  // min-heap on the estimate, the coldest of the hot rows first
+  uint8_t num_top;
+  uint64_t activations;
+  uint32_t bank_activations[NUM_CHANNELS][MAX_RANKS_PER_CHANNEL][NUM_BANKS];  // kept for intervals, the run counts in 64 bits
+} RowSketch_t;
+
+typedef struct HotRows {
+  uint8_t k;                  // rows reported
+  RowSketch_t run;
+  uint64_t bank_activations[NUM_CHANNELS][MAX_RANKS_PER_CHANNEL][NUM_BANKS];  // exact, the sketch's 32 bits wrap on long runs
+  uint32_t bank_max[NUM_CHANNELS][MAX_RANKS_PER_CHANNEL][NUM_BANKS];          // estimate of the bank's hottest row
+  uint16_t bank_max_row[NUM_CHANNELS][MAX_RANKS_PER_CHANNEL][NUM_BANKS];
+
+  // per-interval hot rows, file is NULL when off
+  FILE *file;
+  uint64_t interval_cycles;   // DIMM cycles
+  uint64_t index;
+  uint64_t start;
+  uint64_t end;
+  RowSketch_t interval;
+} HotRows_t;
+
+/*** function declaration(s) ***/
+/**
+ * @brief Start tracking.
+ *
+ * @param hot_rows         The tracker
+ * @param k                Hot rows reported, at most MAX_HOT_ROWS
+ * @param file_name        CSV of the hot rows of each interval
+ * @param interval_cycles  DIMM cycles per interval, 0 = no intervals
+ */
+void hot_rows_init(HotRows_t *hot_rows, uint8_t k, char *file_name, uint64_t interval_cycles);
+
+/**
+ * @brief Continue a restored run: the interval sketch starts over at the restore cycle.
+ */
+void hot_rows_resume(HotRows_t *hot_rows, uint64_t cycle);
+
+/**
+ * @brief Count an activation, at the ACT1 of a request.
+ *
+ * @param hot_rows  The tracker
+ * @param request   The request whose row is opened
+ * @param cycle     The DIMM cycle
+ */
+void hot_rows_activate(HotRows_t *hot_rows, MemoryRequest_t *request, uint64_t cycle);
+
+/**
+ * @brief Print the hot rows and the activations of every bank.
+ */
+void hot_rows_print_stats(HotRows_t *hot_rows, uint8_t num_ranks, FILE *stream);
+
+/**
+ * @brief Write the last interval and close the file.
+ */
+void hot_rows_close(HotRows_t *hot_rows);
+
+#endif
@@ -0,0 +1,112 @@
+/**
+ * @file  input_stream.h
+ *
+ * @brief Trace input that cannot be read with fseeko: stdin (-i -), named
+ *        pipes and gzip or zstd compressed files. A reader thread reads and
+ *        decompresses the input into a small ring of fixed-size blocks while
+ *        the parser takes lines out of them, so decompression overlaps the
+ *        simulation and an archive of any size is simulated without expanding
+ *        it on disk. The compression is recognized by its magic bytes, not by
+ *        the file name.
+ *
+ *        gzip needs zlib and zstd needs libzstd at build time (HAVE_ZLIB,
+ *        HAVE_ZSTD, set by the Makefile when their headers are found).
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef __INPUT_STREAM_H__
+#define __INPUT_STREAM_H__
+
+#include <pthread.h>
+#include "common.h"
+
+/*** macro(s), enum(s), struct(s) ***/
+#define INPUT_STREAM_BLOCKS 4
+#define INPUT_STREAM_BLOCK_SIZE (256 * 1024)  // decompressed bytes per block
+#define INPUT_STREAM_READ_SIZE (64 * 1024)    // bytes read from the file at a time
+
+typedef enum InputCompression {
+  INPUT_PLAIN,
+  INPUT_GZIP,
+  INPUT_ZSTD
+} InputCompression_t;
+
+typedef struct InputStream {
+  int fd;
+  InputCompression_t compression;
+  pthread_t reader;
+  pthread_mutex_t lock;
+  pthread_cond_t filled;    // the reader handed a block over
+  pthread_cond_t drained;   // the parser gave a block back
+  char *blocks[INPUT_STREAM_BLOCKS];
+  size_t block_lengths[INPUT_STREAM_BLOCKS];
+  uint8_t head;             // block the parser is reading
+  uint8_t count;            // blocks handed over and not given back, the head included
+  bool end;                 // the reader is done, no blocks follow the ones handed over
+  bool stop;                // the parser is closing the stream
+
+  // reader side
+  char *raw;                // INPUT_STREAM_READ_SIZE bytes read from the file, not yet decompressed
+  size_t raw_length;
+  size_t raw_position;
+  void *decoder;            // z_stream or ZSTD_DStream
+  bool frame_open;          // the decoder is inside a gzip member or zstd frame
+  bool pending;             // the last block filled up, the decoder may hold more output
+
+  // parser side
+  size_t position;          // in the head block
+  bool has_block;           // the head block is being read
+  uint64_t offset;          // decompressed bytes handed to the parser
+} InputStream_t;
+
+/*** function declaration(s) ***/
+/**
+ * @brief true if the input has to be read through an InputStream_t: stdin,
+ *        anything that is not a regular file, and compressed files.
+ *
+ * @param file_name  The input file name, - for stdin
+ */
+bool input_stream_needed(char *file_name);
+
+/**
+ * @brief Open the input and start the reader thread.
+ *
+ * @param file_name  The input file name, - for stdin
+ * @return InputStream_t*  The stream
+ */
+InputStream_t *input_stream_open(char *file_name);
+
+/**
+ * @brief Read one line, newline included, the way fgets() does.
+ *
+ * @return true  if a line was read, false at the end of the input
+ */
+bool input_stream_gets(InputStream_t *stream, char *line, size_t size);
+
+/**
+ * @brief Read size bytes of binary input, the way fread() does.
+ *
+ * @return size_t  The bytes read, less than size only at the end of the input
+ */
+size_t input_stream_read(InputStream_t *stream, void *buffer, size_t size);
+
+/**
+ * @brief Decompressed bytes read so far, the offset of the next line.
+ */
+uint64_t input_stream_tell(InputStream_t *stream);
+
+/**
+ * @brief Skip forward to a decompressed offset. A stream cannot go back.
+ *
+ * @return true  if the offset was reached
+ */
+bool input_stream_skip(InputStream_t *stream, uint64_t offset);
+
+/**
+ * @brief Stop the reader thread, close the input and free the stream.
+ */
+void input_stream_close(InputStream_t *stream);
+
+#endif
@@ -0,0 +1,164 @@
+/**
+ * @file  interval_stats.h
+ *
+ * @brief Time series of the statistics, one sample every N DIMM cycles
+ *        (--interval-stats), so phases of a trace stay apart instead of
+ *        averaging into the end-of-run totals. Each interval reports, per
+ *        channel and per core, the reads and writes completed, bandwidth,
+ *        row-hit rate (column commands that needed no ACT), average and p99
+ *        latency and the average and peak queue occupancy.
+ *
+ *        The counters are fixed arrays that are cleared at every boundary, the
+ *        queue occupancy is integrated when it changes rather than sampled
+ *        every cycle, and the p99 comes from a log-linear histogram, so
+ *        collecting costs a few additions per command and nothing is allocated
+ *        after the start of the run.
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef __INTERVAL_STATS_H__
+#define __INTERVAL_STATS_H__
+
+#include "common.h"
+#include "dimm.h"
+#include "memory_request.h"
+#include "output.h"
+#include "queue.h"
+
+/*** macro(s), enum(s), struct(s) ***/
+#define DEFAULT_INTERVAL_CSV_FILE "intervals.csv"
+#define DEFAULT_INTERVAL_BINARY_FILE "intervals.bin"
+#define INTERVAL_BINARY_MAGIC "DDR5IVAL"
+#define INTERVAL_BINARY_VERSION 2
+
+// 8 buckets per power of two: a latency lands within 12.5% of its bucket's bounds
+#define INTERVAL_LATENCY_SUB_BUCKETS 8
+#define INTERVAL_LATENCY_BUCKETS ((64 - 2) * INTERVAL_LATENCY_SUB_BUCKETS)
+
+typedef enum IntervalFormat {
+  INTERVAL_CSV,
+  INTERVAL_BINARY
+} IntervalFormat_t;
+
+typedef enum IntervalScope {
+  INTERVAL_CHANNEL,
+  INTERVAL_CORE
+} IntervalScope_t;
+
+typedef struct IntervalCounters {
+  uint32_t reads;             // data reads and instruction fetches completed
+  uint32_t writes;
+  uint32_t activates;         // ACTs issued
+  uint32_t column_commands;   // RDs and WRs issued
+  uint64_t total_latency;     // cpu cycles
+  uint64_t max_latency;
+  uint64_t queue_cycles;      // queued requests summed over the DIMM cycles of the interval
+  uint64_t queue_since;       // DIMM cycle the occupancy was last added to queue_cycles
+  uint16_t occupancy;         // requests in the queue now
+  uint16_t max_occupancy;
+  uint32_t latency_histogram[INTERVAL_LATENCY_BUCKETS];
+} IntervalCounters_t;
+
+typedef struct IntervalStats {
+  FILE *file;
+  IntervalFormat_t format;
+  uint64_t interval_cycles;   // DIMM cycles per interval
+  uint64_t index;             // interval being collected, the first one of the run is 0
+  uint64_t start;             // DIMM cycle the interval started on
+  uint64_t end;               // and the one it ends before
+  uint32_t data_rate;         // MT/s, turns DIMM cycles into seconds
+  bool channel_seen[NUM_CHANNELS];  // channels without any request are left out of the report
+  IntervalCounters_t channels[NUM_CHANNELS];
+  IntervalCounters_t cores[NUM_CORES];  // demand requests only; prefetches count for their channel
+} IntervalStats_t;
+
+// starts the binary file; the records follow back to back
+typedef struct __attribute__((__packed__)) IntervalBinaryHeader {
+  char magic[8];
+  uint32_t version;
+  uint16_t record_size;       // sizeof(IntervalRecord_t)
+  uint8_t num_channels;
+  uint8_t num_cores;
+  uint64_t interval_cycles;
+  uint32_t cpu_mhz;
+  uint32_t data_rate;
+} IntervalBinaryHeader_t;
+
+// one per channel and per core and interval, the raw counters the CSV columns are derived from
+typedef struct __attribute__((__packed__)) IntervalRecord {
+  uint64_t interval;
+  uint8_t scope;              // IntervalScope_t
+  uint8_t id;                 // channel or core
+  uint16_t max_occupancy;
+  uint32_t reads;
+  uint32_t writes;
+  uint32_t activates;
+  uint32_t column_commands;
+  uint64_t cycles;            // DIMM cycles in the interval, less than interval_cycles for the last one
+  uint64_t p99_latency;       // cpu cycles, like the latencies it comes from
+  uint64_t total_latency;
+  uint64_t queue_cycles;
+} IntervalRecord_t;
+
+/*** function declaration(s) ***/
+/**
+ * @brief Open the file, write the header and start interval 0 at DIMM cycle 0;
+ *        a restored run moves on with interval_stats_resume().
+ *
+ * @param intervals        The interval statistics
+ * @param file_name        The CSV or binary file
+ * @param format           CSV or binary
+ * @param interval_cycles  DIMM cycles per interval
+ * @param dimm             The DIMM, for its clocks
+ */
+void interval_stats_init(IntervalStats_t *intervals, char *file_name, IntervalFormat_t format, uint64_t interval_cycles, DIMM_t *dimm);
+
+/**
+ * @brief Continue a restored run: start the interval of the restore cycle and
+ *        count the requests already in the queue.
+ */
+void interval_stats_resume(IntervalStats_t *intervals, Queue_t *queue, uint64_t cycle);
+
+void interval_stats_enqueue(IntervalStats_t *intervals, MemoryRequest_t *request, uint64_t cycle);
+void interval_stats_command(IntervalStats_t *intervals, MemoryRequest_t *request, CommandCode_t command);
+
+/**
+ * @brief Count a completed request.
+ *
+ * @param intervals  The interval statistics
+ * @param request    The request
+ * @param cycle      DIMM cycle it completed on
+ * @param latency    CPU cycles from its arrival
+ */
+void interval_stats_complete(IntervalStats_t *intervals, MemoryRequest_t *request, uint64_t cycle, uint64_t latency);
+
+/**
+ * @brief Write the last, partial interval and close the file.
+ */
+void interval_stats_close(IntervalStats_t *intervals, uint64_t cycle);
+
+/**
+ * @brief Write the interval being collected and start the next one.
+ */
+void interval_stats_flush(IntervalStats_t *intervals);
+
+/**
+ * @brief Parse csv or binary.
+ *
+ * @return int  The IntervalFormat_t, -1 if the name is unknown
+ */
+int interval_stats_parse_format(const char *name);
+
+/**
+ * @brief Write every interval that ended by the given DIMM cycle. The
+ *        boundary check is all that a cycle costs.
+ */
+static inline void interval_stats_advance(IntervalStats_t *intervals, uint64_t cycle) {
+  while (cycle >= intervals->end) {
+    interval_stats_flush(intervals);
+  }
+}
+
+#endif
@@ -0,0 +1,83 @@
+/**
+ * @file  load_curve.h
+ *
+ * @brief Load-latency curves (--load-curve): one trace replayed at several
+ *        injection rates under every scheduling level. The parser divides
+ *        each request time by the intensity, so 2 offers twice the trace's
+ *        bandwidth with the same addresses and order. All the variants are
+ *        independent runs and go to a pool of threads.
+ *
+ *        After the listed intensities, each level's highest passing load and
+ *        the lowest failing one above it are narrowed down for a few rounds,
+ *        splitting the bracket geometrically among the free threads (one
+ *        split is a binary search), to find the maximum bandwidth the level
+ *        sustains under the average-latency SLO. A level that misses the SLO
+ *        at every listed load steps down by halves until it meets it.
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef __LOAD_CURVE_H__
+#define __LOAD_CURVE_H__
+
+#include <pthread.h>
+#include "common.h"
+#include "config.h"
+#include "simulator.h"
+
+/*** macro(s), enum(s), struct(s) ***/
+#define DEFAULT_LATENCY_SLO 1000  // average CPU cycles from arrival to completion
+#define DEFAULT_LOAD_CURVE_FILE "load_curve.csv"
+#define LOAD_SEARCH_ROUNDS 4      // narrowing rounds after the listed intensities
+#define MAX_LOAD_SPLITS 8         // points per level and round
+#define LOAD_PROBE_FACTOR 2.0     // step down from a level's lowest load when it misses the SLO everywhere
+
+typedef struct LoadPoint {
+  // inputs
+  uint8_t level;
+  double intensity;
+
+  // outputs
+  uint64_t completed_requests;
+  double average_latency;
+  uint64_t max_latency;
+  uint64_t final_cycle;
+  double achieved_gbps;  // completions over the time from the first arrival to the end of the run
+} LoadPoint_t;
+
+typedef struct LoadTrace {
+  uint64_t requests;
+  uint64_t first_time;  // arrival of the first and last request at intensity 1
+  uint64_t last_time;
+} LoadTrace_t;
+
+typedef struct LoadPool {
+  Config_t *config;
+  LoadPoint_t *points;
+  uint64_t num_points;
+  uint64_t next_point;  // first point no thread has taken
+  pthread_mutex_t lock;
+} LoadPool_t;
+
+/*** function declaration(s) ***/
+/**
+ * @brief Sweep every scheduling level over config->load_scales, search each
+ *        level's maximum sustainable bandwidth, print the curves and write
+ *        every point to config->load_curve_file.
+ *
+ * @param config  The simulation parameters
+ */
+void run_load_curve(Config_t *config);
+
+/**
+ * @brief Parse a comma-separated list of intensities.
+ *
+ * @param list        The list, e.g. 0.5,1,2
+ * @param scales      Filled with the intensities in increasing order
+ * @param max_scales  The room in scales
+ * @return int  The number of intensities, -1 if the list is malformed
+ */
+int load_curve_parse_scales(const char *list, double *scales, int max_scales);
+
+#endif
@@ -10,6 +10,8 @@
 
 #include "common.h"
 
+#define BYTES_PER_LINE 64
+
 
 typedef enum MemoryRequestState {
   PENDING,
@@ -37,13 +39,19 @@ typedef struct __attribute__((__packed__)) MemoryRequest {
   uint16_t bank : 2;         // 2 bits
   uint16_t column_high : 6;  // 6 bits (column[9:4])
   uint16_t row : 16;         // 16 bits
+  uint8_t rank;              // 0-2 bits above the bank bits, see memory_request_set_rank_bits
   MemoryRequestState_t state;
   uint32_t aging;
   bool is_finished;
+  bool is_prefetch;          // issued by the prefetcher, not by a core
+  uint32_t sequence;         // admission order, see hazard_enqueue
 } MemoryRequest_t;
 
+void memory_request_set_rank_bits(uint8_t rank_bits);
+uint8_t memory_request_address_bits(void);
 void memory_request_init(MemoryRequest_t *memoryRequest, uint64_t time, uint8_t core, uint8_t operation, uint64_t address);
 void log_memory_request(char *prefix, MemoryRequest_t *memory_request, uint64_t cycle);
 uint16_t get_column(MemoryRequest_t *memory_request);
+uint64_t memory_request_address(MemoryRequest_t *memory_request);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,132 @@
+/**
+ * @file  output.h
+ *
+ * @brief Where issued DRAM commands go. Every command is handed to each sink
+ *        of the run as a CommandRecord_t: the text sink writes today's command
+ *        trace, the binary sink a compact log of fixed-size records (turned
+ *        back into the text trace by bin/decode_commands), the stats sink
+ *        writes nothing per command and receives the statistics summary at the
+ *        end of the run, and the null sink drops everything.
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef __OUTPUT_H__
+#define __OUTPUT_H__
+
+#include "common.h"
+
+/*** macro(s), enum(s), struct(s) ***/
+#define MAX_OUTPUT_SINKS 4
+#define DEFAULT_BINARY_OUTPUT_FILE "dram.bin"
+#define BINARY_OUTPUT_MAGIC "DDR5CMDS"
+#define BINARY_OUTPUT_VERSION 1
+
+typedef enum SinkKind {
+  SINK_NONE,
+  SINK_TEXT,
+  SINK_BINARY,
+  SINK_STATS
+} SinkKind_t;
+
+typedef enum CommandCode {
+  COMMAND_ACT0,
+  COMMAND_ACT1,
+  COMMAND_RD0,
+  COMMAND_RD1,
+  COMMAND_WR0,
+  COMMAND_WR1,
+  COMMAND_PRE,
+  COMMAND_RFM,  // RowHammer mitigation; address 0 = RFMab, 1 = RFMsb of the bank
+  NUM_COMMAND_CODES
+} CommandCode_t;
+_Static_assert(NUM_COMMAND_CODES <= 8, "a CommandRecord_t holds the command in 3 bits");
+
+// 10 bytes per command against about 28 for a text line
+typedef struct __attribute__((__packed__)) CommandRecord {
+  uint64_t cycle : 48;      // DIMM cycle
+  uint64_t command : 3;     // CommandCode_t
+  uint64_t channel : 1;
+  uint64_t rank : 2;
+  uint64_t bank_group : 3;
+  uint64_t bank : 2;
+  uint64_t reserved : 5;
+  uint16_t address;         // row for ACT, column for RD/WR, 0 for PRE, RFMsb for RFM
+} CommandRecord_t;
+
+// starts every binary log; the records follow back to back
+typedef struct __attribute__((__packed__)) BinaryOutputHeader {
+  char magic[8];
+  uint32_t version;
+  uint16_t record_size;  // sizeof(CommandRecord_t)
+  uint8_t num_ranks;     // the text trace has a rank column when there is more than one
+  uint8_t reserved;
+} BinaryOutputHeader_t;
+
+typedef struct OutputSink {
+  SinkKind_t kind;
+  FILE *file;  // NULL for the null sink; stdout for a stats sink without a file
+} OutputSink_t;
+
+typedef struct Output {
+  OutputSink_t sinks[MAX_OUTPUT_SINKS];
+  uint8_t num_sinks;
+  uint8_t num_ranks;
+} Output_t;
+
+/*** function declaration(s) ***/
+void output_init(Output_t *output, uint8_t num_ranks);
+
+/**
+ * @brief Open a sink and add it to the output.
+ *
+ * @param output     The output
+ * @param kind       The sink kind
+ * @param file_name  The file the sink writes; NULL for the null sink, and for
+ *                   a stats sink that writes to stdout
+ */
+void output_add_sink(Output_t *output, SinkKind_t kind, char *file_name);
+
+/**
+ * @brief Add a sink that writes to a file the caller already opened. The
+ *        output closes it.
+ */
+void output_attach_sink(Output_t *output, SinkKind_t kind, FILE *file);
+
+/**
+ * @brief Reopen a sink of a restored run so it continues after the first
+ *        offset bytes. A file that holds less is started over (with a warning),
+ *        as the commands before the checkpoint cannot be recovered.
+ */
+void output_resume_sink(Output_t *output, SinkKind_t kind, char *file_name, uint64_t offset);
+
+/**
+ * @brief Hand one issued command to every sink.
+ */
+void output_command(Output_t *output, const CommandRecord_t *record);
+
+/**
+ * @brief Bytes written so far by each sink, 0 for sinks without a log.
+ */
+void output_offsets(Output_t *output, uint64_t offsets[MAX_OUTPUT_SINKS]);
+
+void output_close(Output_t *output);
+
+/**
+ * @brief Write one command the way the text sink does, without the newline.
+ */
+void output_format_text(FILE *file, const CommandRecord_t *record, bool show_rank);
+
+bool output_read_binary_header(FILE *file, BinaryOutputHeader_t *header);
+
+/**
+ * @brief Parse a sink name as given on the command line.
+ *
+ * @return int  The SinkKind_t, -1 if the name is unknown
+ */
+int output_parse_sink(const char *name);
+const char *output_sink_name(SinkKind_t kind);
+const char *output_command_name(CommandCode_t command);
+
+#endif
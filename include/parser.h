@@ -9,7 +9,9 @@
 #define __PARSER_H__
 
 #include "common.h"
+#include "input_stream.h"
 #include "memory_request.h"
+#include "trace_format.h"
 
 #define LINE_LENGTH 256
 
@@ -20,19 +22,26 @@ typedef enum ParserStatus {
 } ParserStatus_t;
 
 typedef struct Parser {
-  FILE *file;
+  FILE *file;             // NULL when the input is read through stream
+  InputStream_t *stream;  // stdin, pipes and compressed files, NULL for a plain file
   char line[LINE_LENGTH];
-  MemoryRequest_t *next_request;
+  MemoryRequest_t next_request;  // read ahead, valid while status is OK
   ParserStatus_t status;
+  uint64_t end_time;  // requests at or after this time are treated as the end of the input
+  double intensity;   // offered load relative to the trace, request times are divided by it
+  uint8_t bank_sample;  // only requests to one bank in bank_sample are read, 1 = every request
+  TraceImporter_t importer;      // the trace format and the rest of the record the pending request came from
 } Parser_t;
 
 /**
  * @brief Initialize the parser.
  *
- * @param input_file  The input file name
+ * @param input_file  The input file name, - for stdin; gzip and zstd input is decompressed on the fly
+ * @param format      The trace format
+ * @param policy      What to do with addresses the DIMM cannot hold, NUM_ADDRESS_POLICIES for the format's default
  * @return Parser_t*  The parser
  */
-Parser_t *parser_init(char *input_file);
+Parser_t *parser_init(char *input_file, TraceFormat_t format, AddressPolicy_t policy);
 
 /**
  * @brief Destroy parser and free memory.
@@ -44,10 +53,75 @@ void parser_destroy(Parser_t *parser);
 /**
  * @brief Get the next request from the parser if the current cycle is greater than the request's time.
  *
+ * @param parser   The parser
+ * @param cycle    The current cpu cycle
+ * @param request  Filled with the memory request
+ * @return true  if a request was due
+ */
+bool parser_next_request(Parser_t *parser, uint64_t cycle, MemoryRequest_t *request);
+
+/**
+ * @brief Get every request due by the current cycle, in trace order, up to max_requests.
+ *
+ * @param parser        The parser
+ * @param cycle         The current cpu cycle
+ * @param requests      Filled with the memory requests
+ * @param max_requests  The room in requests
+ * @return uint16_t  The number of requests returned
+ */
+uint16_t parser_next_requests(Parser_t *parser, uint64_t cycle, MemoryRequest_t *requests, uint16_t max_requests);
+
+/**
+ * @brief Get the input file position right after the pending request's line
+ *        (or record; the importer holds the rest of the record).
+ *
+ * @param parser  The parser
+ * @return uint64_t  The byte offset into the input file, decompressed
+ */
+uint64_t parser_tell(Parser_t *parser);
+
+/**
+ * @brief Resume parsing at a saved position. A streamed input can only skip
+ *        forward to it.
+ *
+ * @param parser        The parser
+ * @param offset        The byte offset returned by parser_tell()
+ * @param next_request  The request that was pending at that offset, NULL if the input was exhausted
+ */
+void parser_seek(Parser_t *parser, uint64_t offset, MemoryRequest_t *next_request);
+
+/**
+ * @brief Drop the pending request and continue parsing at the line starting at offset.
+ *
  * @param parser  The parser
- * @param cycle  The current cpu cycle
- * @return MemoryRequest_t*  The memory request
+ * @param offset  The byte offset of the start of a line
+ */
+void parser_seek_line(Parser_t *parser, uint64_t offset);
+
+/**
+ * @brief Replay the trace at a different rate: every request time from here
+ *        on is divided by intensity, so 2 offers twice the trace's load.
+ *
+ * @param parser     The parser
+ * @param intensity  The offered load relative to the trace, > 0
+ */
+void parser_set_intensity(Parser_t *parser, double intensity);
+
+/**
+ * @brief Read only the requests to one bank in bank_sample from here on
+ *        (see parser_is_sampled()), for models that follow a sample of the
+ *        banks.
+ *
+ * @param parser       The parser
+ * @param bank_sample  1 reads every request
+ */
+void parser_set_bank_sample(Parser_t *parser, uint8_t bank_sample);
+
+/**
+ * @brief Whether a request goes to one of the sampled banks: the bank's index
+ *        over the channels, ranks and banks of the DIMM is a multiple of
+ *        bank_sample.
  */
-MemoryRequest_t *parser_next_request(Parser_t *parser, uint64_t cycle);
+bool parser_is_sampled(MemoryRequest_t *request, uint8_t bank_sample);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,107 @@
+/**
+ * @file  prefetcher.h
+ *
+ * @brief Memory-side stream prefetcher. Demand reads train a small per-core
+ *        stride table; confirmed streams queue the next lines as prefetch
+ *        candidates, which are issued as low-priority reads only while the
+ *        controller has spare queue slots and the target bank is not holding
+ *        another row open. Completed prefetches land in a prefetch buffer that
+ *        serves later demand reads without going to the DIMM. Writes
+ *        invalidate the line.
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef __PREFETCHER_H__
+#define __PREFETCHER_H__
+
+#include "common.h"
+#include "dimm.h"
+#include "memory_request.h"
+
+/*** macro(s), enum(s), struct(s) ***/
+#define PREFETCH_STREAMS_PER_CORE 4
+#define PREFETCH_MAX_STRIDE 64      // lines; larger jumps start a new stream
+#define PREFETCH_CONFIDENCE 2       // stride repeats before the stream is trusted
+#define PREFETCH_QUEUE_SIZE 8       // candidates waiting for a spare slot
+#define PREFETCH_BUFFER_SIZE 16     // lines held for demand reads
+#define DEFAULT_PREFETCH_DEGREE 2   // lines fetched ahead of a confirmed stream
+
+typedef enum PrefetchEntryState {
+  PREFETCH_EMPTY,
+  PREFETCH_IN_FLIGHT,  // issued to the DIMM, data not back yet
+  PREFETCH_READY
+} PrefetchEntryState_t;
+
+typedef struct Stream {
+  uint64_t last_line;
+  int64_t stride;      // in 64-byte lines
+  uint8_t confidence;
+  uint64_t last_use;   // for LRU replacement
+} Stream_t;
+
+typedef struct PrefetchEntry {
+  uint64_t line;
+  PrefetchEntryState_t state;
+} PrefetchEntry_t;
+
+typedef struct PrefetchCandidate {
+  uint64_t line;
+  uint8_t core;
+} PrefetchCandidate_t;
+
+typedef struct Prefetcher {
+  Stream_t streams[NUM_CORES][PREFETCH_STREAMS_PER_CORE];
+  PrefetchCandidate_t candidates[PREFETCH_QUEUE_SIZE];  // ring, oldest at candidate_head
+  uint8_t candidate_head;
+  uint8_t num_candidates;
+  PrefetchEntry_t buffer[PREFETCH_BUFFER_SIZE];
+  uint8_t next_victim;  // FIFO replacement
+  uint8_t degree;
+  uint64_t accesses;    // demand accesses seen, orders the stream LRU
+
+  // statistics
+  uint64_t demand_reads;
+  uint64_t issued;
+  uint64_t hits;             // demand reads served from the buffer
+  uint64_t late;             // demand reads that found their prefetch still in flight
+  uint64_t evicted_unused;
+  uint64_t invalidated;      // prefetched lines dropped by a write
+  uint64_t dropped;          // candidates overwritten before a slot was free
+} Prefetcher_t;
+
+/*** function declaration(s) ***/
+void prefetcher_init(Prefetcher_t *prefetcher, uint8_t degree);
+
+/**
+ * @brief Train on a demand request. Reads that hit a ready line are served by
+ *        the buffer; writes invalidate the line.
+ *
+ * @param prefetcher  The prefetcher
+ * @param request     The demand request as it arrives at the controller
+ * @return true  if the request was served from the prefetch buffer
+ */
+bool prefetcher_demand(Prefetcher_t *prefetcher, MemoryRequest_t *request);
+
+/**
+ * @brief Take the oldest candidate whose bank has its row open or is
+ *        precharged and turn it into a prefetch read. Candidates that would
+ *        close another row stay queued.
+ *
+ * @param prefetcher  The prefetcher
+ * @param dimm        The DIMM, to look up the bank state
+ * @param prefetch    Filled with the prefetch request
+ * @param cycle       The current CPU cycle
+ * @return true  if a prefetch should be enqueued
+ */
+bool prefetcher_next(Prefetcher_t *prefetcher, DIMM_t *dimm, MemoryRequest_t *prefetch, uint64_t cycle);
+
+/**
+ * @brief Move a completed prefetch into the buffer.
+ */
+void prefetcher_fill(Prefetcher_t *prefetcher, MemoryRequest_t *prefetch);
+
+void prefetcher_print_stats(Prefetcher_t *prefetcher, FILE *stream);
+
+#endif
@@ -0,0 +1,102 @@
+/**
+ * @file  preset.h
+ *
+ * @brief Named DIMM configurations. --preset applies one to a run. A build with
+ *        FIXED_PRESET set (make fast PRESET=name) runs only that configuration:
+ *        its command rate, burst length and rank count become constants in the
+ *        DIMM engine, so the per-cycle rank loops and the burst arithmetic are
+ *        folded at compile time, and so is the timing table in DIMM cycles,
+ *        derived from its data rate. The generic build stays the fallback for
+ *        every other configuration and hands a matching run to the specialized
+ *        binary when one was built next to it.
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef __PRESET_H__
+#define __PRESET_H__
+
+#include "common.h"
+#include "config.h"
+
+/*** macro(s), enum(s), struct(s) ***/
+// the data rates are macros too, the timing table of a FIXED_PRESET build is a static initializer
+#define PRESET_PC5_38400_DATA_RATE 4800
+#define PRESET_PC5_38400_2R_DATA_RATE 4800
+
+typedef enum PresetId {
+  PRESET_PC5_38400,
+  PRESET_PC5_38400_2R,
+  NUM_PRESETS
+} PresetId_t;
+
+typedef struct Preset {
+  const char *name;
+  const char *description;
+  uint32_t cpu_mhz;
+  uint32_t data_rate;
+  uint8_t command_rate;
+  uint8_t burst_length;
+  bool burst_chop;
+  uint8_t dimms_per_channel;
+  uint8_t ranks_per_dimm;
+} Preset_t;
+
+// static so that a FIXED_PRESET build can fold the fields of its entry
+static const Preset_t preset_table[NUM_PRESETS] = {
+  [PRESET_PC5_38400] = {
+    .name = "pc5-38400",
+    .description = "4.8 GHz cores, DDR5-4800 x8, 1N, BL16, one single-rank DIMM",
+    .cpu_mhz = 4800,
+    .data_rate = PRESET_PC5_38400_DATA_RATE,
+    .command_rate = 1,
+    .burst_length = 16,
+    .burst_chop = false,
+    .dimms_per_channel = 1,
+    .ranks_per_dimm = 1,
+  },
+  [PRESET_PC5_38400_2R] = {
+    .name = "pc5-38400-2r",
+    .description = "4.8 GHz cores, DDR5-4800 x8, 1N, BL16, one dual-rank DIMM",
+    .cpu_mhz = 4800,
+    .data_rate = PRESET_PC5_38400_2R_DATA_RATE,
+    .command_rate = 1,
+    .burst_length = 16,
+    .burst_chop = false,
+    .dimms_per_channel = 1,
+    .ranks_per_dimm = 2,
+  },
+};
+
+#ifdef FIXED_PRESET
+#define FIXED_PRESET_ENTRY (preset_table[FIXED_PRESET])
+#define PRESET_DATA_RATE_OF(id) id##_DATA_RATE
+#define PRESET_DATA_RATE(id) PRESET_DATA_RATE_OF(id)
+#define FIXED_PRESET_DATA_RATE PRESET_DATA_RATE(FIXED_PRESET)
+#endif
+
+/*** function declaration(s) ***/
+const Preset_t *preset_get(uint8_t id);
+
+/**
+ * @brief Look a preset up by name.
+ *
+ * @return int  The preset id, -1 if no preset matches
+ */
+int preset_find(const char *name);
+
+/**
+ * @brief Overwrite the clocks, command rate, burst and topology of a
+ *        configuration with those of a preset.
+ */
+void preset_apply(const Preset_t *preset, Config_t *config);
+
+/**
+ * @brief true if a configuration runs exactly the DIMM setup of a preset.
+ */
+bool preset_matches(const Preset_t *preset, Config_t *config);
+
+void preset_print_list(FILE *stream);
+
+#endif
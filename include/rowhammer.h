@@ -0,0 +1,162 @@
+/**
+ * @file  rowhammer.h
+ *
+ * @brief DDR5 RowHammer mitigation (--rfm, --prac): the controller side of
+ *        Refresh Management and of Per-Row Activation Counting, so the cost
+ *        of enabling them can be measured on a trace.
+ *
+ *        RFM: every ACT raises the Rolling Accumulated ACT (RAA) counter of
+ *        its bank. At RAAIMT an RFM is due and goes out as soon as its banks
+ *        are idle; at RAAMMT no new request may start on them until the
+ *        banks are precharged and the RFM is issued. An RFMab covers every
+ *        bank of the rank for tRFMab, an RFMsb the same bank of every bank
+ *        group for tRFMsb, and either lowers the RAA of its banks by RAAIMT.
+ *
+ *        PRAC: the DRAM counts the activations of every row. When a row
+ *        reaches the back-off threshold the rank raises ALERT; traffic goes
+ *        on for tABO_ACT, then the controller owes the configured number of
+ *        RFMab, each of which resets the hottest row of every bank. The rows
+ *        of a bank are counted in a table of PRAC_TRACKED_ROWS entries; when
+ *        it is full the coldest entry is taken over with its count, so a
+ *        count is never low. The longer tRP and tRC of PRAC devices are not
+ *        modeled.
+ *
+ *        The simulator issues no REF; the refresh that would run anyway
+ *        still lowers every RAA by RAAIMT each tREFI and clears the row
+ *        counts each tREFW.
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef __ROWHAMMER_H__
+#define __ROWHAMMER_H__
+
+#include "common.h"
+#include "dimm.h"
+#include "memory_request.h"
+
+/*** macro(s), enum(s), struct(s) ***/
+// in picoseconds, rowhammer_init() turns them into DIMM cycles
+#define TRFM_AB_PS          295000 // an all-bank RFM blocks the rank like a REFab
+#define TRFM_SB_PS          130000 // a same-bank RFM blocks one bank per bank group like a REFsb
+#define TABO_ACT_PS         180000 // normal traffic between ALERT and the back-off RFMs
+#define TREFI_PS           3900000 // refresh interval, each REF lowers the RAA
+#define TREFW_PS    32000000000ULL // every row is refreshed once, which clears its PRAC count
+
+#define DEFAULT_RAA_IMT 32
+#define RAA_MMT_FACTOR 3  // RAAMMT defaults to 3 x RAAIMT
+#define DEFAULT_PRAC_RFMS 1
+#define PRAC_TRACKED_ROWS 256
+
+typedef enum RfmMode {
+  RFM_OFF,
+  RFM_ALL_BANK,   // RFMab
+  RFM_SAME_BANK,  // RFMsb
+  NUM_RFM_MODES
+} RfmMode_t;
+
+typedef struct PracRow {
+  uint16_t row;
+  uint16_t activations;
+} PracRow_t;
+
+typedef struct PracBank {
+  PracRow_t rows[PRAC_TRACKED_ROWS];
+  uint16_t num_rows;
+} PracBank_t;
+
+typedef struct RankMitigation {
+  uint16_t raa[NUM_BANKS];
+  uint8_t backoff_rfms;  // RFMab owed for an ALERT, 0 = no ALERT
+  uint64_t window_end;   // DIMM cycle the back-off RFMs become mandatory
+} RankMitigation_t;
+
+typedef struct RowHammer {
+  uint8_t rfm_mode;         // RfmMode_t
+  uint16_t raa_imt;
+  uint16_t raa_mmt;
+  uint16_t prac_threshold;  // back-off threshold, 0 = no PRAC
+  uint8_t prac_rfms;        // RFMab per back-off
+  uint16_t trfm_ab;         // the timings in DIMM cycles
+  uint16_t trfm_sb;
+  uint64_t tabo_act;
+  uint64_t trefi;
+  uint64_t trefw;
+  uint64_t refreshes;       // tREFI periods credited so far
+  uint64_t refresh_windows; // tREFW periods cleared so far
+  RankMitigation_t ranks[NUM_CHANNELS][MAX_RANKS_PER_CHANNEL];
+  BankMask_t held[NUM_CHANNELS][MAX_RANKS_PER_CHANNEL];  // banks no new request may start on
+  PracBank_t prac[NUM_CHANNELS][MAX_RANKS_PER_CHANNEL][NUM_BANKS];
+
+  // overhead
+  uint64_t rfm_all_bank;        // RFMab for the RAA
+  uint64_t rfm_same_bank;       // RFMsb for the RAA
+  uint64_t alerts;
+  uint64_t backoff_rfms;        // RFMab for an ALERT
+  uint64_t forced_rfms;         // RFMs the banks were drained for
+  uint64_t precharges;          // PREs issued to close rows for an RFM
+  uint64_t blocked_bank_cycles; // bank-cycles under RFM
+  uint64_t waiting_cycles;      // request-cycles spent waiting for a held or blocked bank
+  uint64_t stalled_cycles;      // DIMM cycles every queued request was waiting on mitigation
+} RowHammer_t;
+
+/*** function declaration(s) ***/
+/**
+ * @brief Start with every counter at 0.
+ *
+ * @param rowhammer       The mitigation state
+ * @param rfm_mode        RfmMode_t, RFM_OFF for PRAC only
+ * @param raa_imt         RAA initial management threshold
+ * @param raa_mmt         RAA maximum management threshold
+ * @param prac_threshold  PRAC back-off threshold, 0 = no PRAC
+ * @param prac_rfms       RFMab per back-off
+ * @param time_base       The DIMM's time base, the timings follow its data rate
+ */
+void rowhammer_init(RowHammer_t *rowhammer, RfmMode_t rfm_mode, uint16_t raa_imt, uint16_t raa_mmt, uint16_t prac_threshold,
+                    uint8_t prac_rfms, const TimeBase_t *time_base);
+
+/**
+ * @brief Credit the refreshes that have passed by this DIMM cycle.
+ */
+void rowhammer_refresh(RowHammer_t *rowhammer, uint64_t cycle);
+
+/**
+ * @brief Count an activation, at the ACT1 of a request.
+ */
+void rowhammer_activate(RowHammer_t *rowhammer, MemoryRequest_t *request, uint64_t cycle);
+
+/**
+ * @brief The RFM a rank owes.
+ *
+ * @param rowhammer  The mitigation state
+ * @param channel    The channel
+ * @param rank       The rank
+ * @param cycle      The DIMM cycle
+ * @param bank       Set to the bank of an RFMsb
+ * @param forced     Set when the banks have to be drained for it
+ * @return RfmMode_t  RFM_OFF if none is due
+ */
+RfmMode_t rowhammer_due(RowHammer_t *rowhammer, uint8_t channel, uint8_t rank, uint64_t cycle, uint8_t *bank, bool *forced);
+
+/**
+ * @brief The banks of a rank an RFM covers.
+ */
+BankMask_t rowhammer_targets(RfmMode_t mode, uint8_t bank);
+
+/**
+ * @brief Update the counters for an issued RFM.
+ */
+void rowhammer_rfm(RowHammer_t *rowhammer, uint8_t channel, uint8_t rank, RfmMode_t mode, uint8_t bank, bool forced);
+
+void rowhammer_print_stats(RowHammer_t *rowhammer, DIMM_t *dimm, uint64_t clock_cycle, FILE *stream);
+
+/**
+ * @brief Parse an RFM mode as given on the command line.
+ *
+ * @return int  The RfmMode_t, -1 if the name is unknown
+ */
+int rowhammer_parse_mode(const char *name);
+const char *rowhammer_mode_name(RfmMode_t mode);
+
+#endif
@@ -0,0 +1,45 @@
+/**
+ * @file  sampling.h
+ *
+ * @brief SMARTS-style sampled simulation. The trace is split into periods;
+ *        each period fast-forwards functionally (only the open row of each
+ *        bank is updated, no timing), then simulates a warmup stretch and a
+ *        measured window in full detail. Window means are combined into
+ *        estimates with 95% confidence intervals.
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef __SAMPLING_H__
+#define __SAMPLING_H__
+
+#include "common.h"
+#include "config.h"
+#include "simulator.h"
+
+/*** macro(s), enum(s), struct(s) ***/
+#define DEFAULT_SAMPLE_PERIOD 20000  // requests from one window start to the next
+#define DEFAULT_SAMPLE_WARMUP 200    // detailed requests simulated before measuring
+#define DEFAULT_SAMPLE_WINDOW 500    // detailed requests measured per window
+
+typedef struct SamplingResult {
+  uint64_t windows;
+  uint64_t detailed_requests;
+  uint64_t fast_forwarded_requests;
+  double latency_sum;  // sum of per-window mean latencies
+  double latency_square_sum;
+  double bandwidth_sum;  // sum of per-window bandwidths (GB/s)
+  double bandwidth_square_sum;
+} SamplingResult_t;
+
+/*** function declaration(s) ***/
+/**
+ * @brief Run the trace in sampling mode and print the estimates.
+ *
+ * @param config  The simulation parameters; sample_* select the window sizes
+ * @return uint64_t  The CPU clock cycle at which the run ended
+ */
+uint64_t run_sampled_simulation(Config_t *config);
+
+#endif
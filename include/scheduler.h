@@ -0,0 +1,74 @@
+/**
+ * @file  scheduler.h
+ *
+ * @brief Scheduling policies. A policy decides where an admitted request goes
+ *        in the queue and which request gets the command bus each DIMM cycle;
+ *        the DIMM (closed_page()/open_page()) checks the timing and issues the
+ *        command. Policies are looked up by name or by their index in the
+ *        registry, which is the level -s has always taken. The built-in
+ *        levels are registered in scheduler.c; a policy defined in a file of
+ *        its own registers itself with scheduler_register() before the
+ *        arguments are parsed, e.g. from a constructor function.
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef __SCHEDULER_H__
+#define __SCHEDULER_H__
+
+#include "common.h"
+#include "dimm.h"
+#include "memory_request.h"
+#include "queue.h"
+
+/*** macro(s), enum(s), struct(s) ***/
+#define MAX_SCHEDULERS 16  // built-in levels and registered policies together
+
+typedef struct Scheduler {
+  const char *name;
+  const char *description;
+  bool open_page;  // rows stay open after an access, functional fast-forward tracks them
+
+  /**
+   * @brief Insert an admitted request into the queue.
+   */
+  void (*on_enqueue)(Queue_t **q, MemoryRequest_t *request);
+
+  /**
+   * @brief Offer the command bus to the queued requests for one DIMM cycle
+   *        and retire the completed ones through complete_request().
+   */
+  void (*select_command)(DIMM_t **dimm, Queue_t **q, uint64_t clock);
+
+  // optional, NULL when the policy keeps no state of its own
+  void (*on_issue)(DIMM_t *dimm, MemoryRequest_t *request, MemoryRequestState_t state, uint64_t clock);
+  void (*on_complete)(DIMM_t *dimm, MemoryRequest_t *request, uint64_t clock);
+} Scheduler_t;
+
+/*** function declaration(s) ***/
+/**
+ * @brief Append a policy to the registry. The registry is not locked: register
+ *        before main() parses the arguments and starts any simulator.
+ *
+ * @param scheduler  The policy; it has to outlive the program
+ * @return int       Its index, -1 if the registry is full or the name is taken
+ */
+int scheduler_register(const Scheduler_t *scheduler);
+
+/**
+ * @brief The registered policy with the given index, NULL if there is none.
+ */
+const Scheduler_t *scheduler_get(uint8_t id);
+
+/**
+ * @brief Look a policy up by name or index.
+ *
+ * @param name  A registered name or a level number
+ * @return int  The index, -1 if no policy matches
+ */
+int scheduler_find(const char *name);
+
+void scheduler_print_list(FILE *stream);
+
+#endif
@@ -0,0 +1,77 @@
+/**
+ * @file  simulator.h
+ *
+ * @brief Owns everything the control loop needs (parser, queue, DIMM and the
+ *        CPU clock) so a run can be stepped, checkpointed and resumed.
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef __SIMULATOR_H__
+#define __SIMULATOR_H__
+
+#include "common.h"
+#include "config.h"
+#include "core_model.h"
+#include "interval_stats.h"
+#include "dimm.h"
+#include "dueling.h"
+#include "hot_rows.h"
+#include "memory_request.h"
+#include "parser.h"
+#include "prefetcher.h"
+#include "queue.h"
+#include "rowhammer.h"
+#include "scheduler.h"
+#include "timeline.h"
+
+/*** macro(s), enum(s), struct(s) ***/
+typedef struct Simulator {
+  Parser_t *parser;
+  DIMM_t *dimm;
+  Queue_t *queue;
+  MemoryRequest_t pending[MAX_ADMIT_WIDTH];  // requests taken from the parser but not yet admitted, oldest first
+  uint8_t num_pending;
+  uint8_t admit_width;               // requests taken from the parser and admitted per CPU cycle
+  uint64_t clock_cycle;              // CPU clock. dimm->time_base says which cycles start a DIMM cycle.
+  uint64_t admitted_requests;        // requests enqueued so far
+  uint64_t admission_limit;          // stop taking requests from the parser once this many were admitted
+  uint8_t scheduling_policy;         // index of the scheduler in the registry
+  const Scheduler_t *scheduler;
+  Prefetcher_t *prefetcher;          // NULL unless prefetching is enabled
+  CoreModel_t *cores;                // releases requests in closed-loop runs, NULL replays the trace times
+  Timeline_t *timeline;              // trace-event export, NULL unless --timeline is given
+  IntervalStats_t *intervals;        // statistics every N DIMM cycles, NULL unless --interval-stats is given
+  HotRows_t *hot_rows;               // row activation tracking, NULL unless --hot-rows is given
+  RowHammer_t *rowhammer;            // RFM and PRAC mitigation, NULL unless --rfm or --prac is given
+  Dueling_t *dueling;                // switches the scheduling level, NULL unless --duel is given
+} Simulator_t;
+
+/*** function declaration(s) ***/
+/**
+ * @brief Create a simulator at cycle 0 for the given configuration.
+ *
+ * @param config  The simulation parameters
+ * @return Simulator_t*  The simulator
+ */
+Simulator_t *simulator_create(Config_t *config);
+
+/**
+ * @brief Destroy the simulator and free memory.
+ *
+ * @param sim  The simulator
+ */
+void simulator_destroy(Simulator_t *sim);
+
+/**
+ * @brief Run one CPU clock cycle.
+ *
+ * @param sim  The simulator
+ * @return true  if the simulation has more work, false once the trace is drained
+ */
+bool simulator_step(Simulator_t *sim);
+
+void advance_clock(uint64_t *clock_cycle, Queue_t *global_queue, Parser_t *parser);
+
+#endif
@@ -0,0 +1,36 @@
+/**
+ * @file  stats.h
+ *
+ * @brief Running counters for completed memory requests.
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef __STATS_H__
+#define __STATS_H__
+
+#include "common.h"
+#include "memory_request.h"
+
+/*** macro(s), enum(s), struct(s) ***/
+#define BYTES_PER_REQUEST 64   // one cache line per request
+
+typedef struct Stats {
+  uint64_t completed_requests;
+  uint64_t reads;           // data reads and instruction fetches
+  uint64_t writes;
+  uint64_t total_latency;   // cpu cycles from arrival in the trace to completion
+  uint64_t max_latency;
+  uint64_t admission_stalls[NUM_CORES];  // cycles a core's request waited for a free queue slot
+} Stats_t;
+
+/*** function declaration(s) ***/
+void stats_init(Stats_t *stats);
+void stats_record_completion(Stats_t *stats, MemoryRequest_t *request, uint64_t cycle);
+void stats_add(Stats_t *total, Stats_t *stats);
+void stats_subtract(Stats_t *result, Stats_t *end, Stats_t *start);
+double stats_average_latency(Stats_t *stats);
+double stats_bandwidth_gbps(uint64_t completed_requests, double seconds);
+
+#endif
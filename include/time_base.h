@@ -0,0 +1,107 @@
+/**
+ * @file  time_base.h
+ *
+ * @brief Relation between the CPU clock, which trace times and latencies are
+ *        counted in, and the DIMM command clock (half the data rate), which
+ *        the command output and the DRAM timers are counted in. The ratio is
+ *        kept as a reduced fraction, so any pair of clocks converts exactly:
+ *        cpu_per_tick CPU cycles span dimm_per_tick DIMM cycles.
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef __TIME_BASE_H__
+#define __TIME_BASE_H__
+
+#include "common.h"
+
+/*** macro(s), enum(s), struct(s) ***/
+#define DEFAULT_CPU_MHZ 4800    // 4.8 GHz cores
+#define DEFAULT_DATA_RATE 4800  // MT/s, PC5-38400
+
+// a duration in picoseconds as DIMM cycles of a data rate; a DIMM cycle is 2 / data_rate microseconds,
+// rounded up so a timing constraint is never shortened. A constant expression for constant arguments
+#define PS_TO_DIMM_CYCLES(ps, data_rate) (((uint64_t)(ps) * (data_rate) + 1999999) / 2000000)
+
+typedef enum TimeBaseKind {
+  TIME_BASE_POWER_OF_TWO,  // a DIMM cycle is 2^n CPU cycles (the default 2:1)
+  TIME_BASE_INTEGER,       // a DIMM cycle is a whole number of CPU cycles
+  TIME_BASE_FRACTIONAL     // anything else, e.g. 5.0 GHz with DDR5-5600 (25:14)
+} TimeBaseKind_t;
+
+typedef struct TimeBase {
+  uint32_t cpu_mhz;
+  uint32_t data_rate;       // MT/s; the command clock runs at half of it
+  uint64_t cpu_per_tick;    // reduced ratio numerator
+  uint64_t dimm_per_tick;   // reduced ratio denominator, never larger than cpu_per_tick
+  uint64_t mask;            // cpu_per_tick - 1 for TIME_BASE_POWER_OF_TWO
+  uint8_t shift;            // log2(cpu_per_tick) for TIME_BASE_POWER_OF_TWO
+  TimeBaseKind_t kind;
+} TimeBase_t;
+
+/*** function declaration(s) ***/
+/**
+ * @brief A duration as DIMM cycles of the data rate, rounded up so a timing
+ *        constraint is never shortened.
+ *
+ * @param time_base  The time base
+ * @param ps         The duration in picoseconds
+ * @return uint64_t  DIMM cycles
+ */
+static inline uint64_t time_base_ps_to_dimm(const TimeBase_t *time_base, uint64_t ps) {
+  return PS_TO_DIMM_CYCLES(ps, time_base->data_rate);
+}
+
+/**
+ * @brief Reduce the clock ratio and pick the conversion path.
+ *
+ * @param time_base  The time base
+ * @param cpu_mhz    CPU clock in MHz
+ * @param data_rate  DRAM data rate in MT/s
+ * @return true  if the CPU clock is at least as fast as the DIMM command clock
+ */
+bool time_base_init(TimeBase_t *time_base, uint32_t cpu_mhz, uint32_t data_rate);
+
+/**
+ * @brief The DIMM cycle a CPU cycle falls into.
+ */
+static inline uint64_t time_base_dimm_cycle(const TimeBase_t *time_base, uint64_t cpu_cycle) {
+  switch (time_base->kind) {
+    case TIME_BASE_POWER_OF_TWO:
+      return cpu_cycle >> time_base->shift;
+    case TIME_BASE_INTEGER:
+      return cpu_cycle / time_base->cpu_per_tick;
+    case TIME_BASE_FRACTIONAL:
+    default:
+      // split so cpu_cycle * dimm_per_tick cannot overflow
+      return (cpu_cycle / time_base->cpu_per_tick) * time_base->dimm_per_tick +
+             (cpu_cycle % time_base->cpu_per_tick) * time_base->dimm_per_tick / time_base->cpu_per_tick;
+  }
+}
+
+/**
+ * @brief true if a DIMM cycle starts on this CPU cycle, i.e. the controller
+ *        may issue a command.
+ */
+static inline bool time_base_is_dimm_edge(const TimeBase_t *time_base, uint64_t cpu_cycle) {
+  switch (time_base->kind) {
+    case TIME_BASE_POWER_OF_TWO:
+      return (cpu_cycle & time_base->mask) == 0;
+    case TIME_BASE_INTEGER:
+      return cpu_cycle % time_base->cpu_per_tick == 0;
+    case TIME_BASE_FRACTIONAL:
+    default:
+      return (cpu_cycle % time_base->cpu_per_tick) * time_base->dimm_per_tick % time_base->cpu_per_tick < time_base->dimm_per_tick;
+  }
+}
+
+/**
+ * @brief The first DIMM cycle that starts at or after a CPU cycle. Commands
+ *        issued before cpu_cycle are exactly those with a smaller DIMM cycle.
+ */
+uint64_t time_base_next_dimm_cycle(const TimeBase_t *time_base, uint64_t cpu_cycle);
+
+double time_base_seconds(const TimeBase_t *time_base, uint64_t cpu_cycle);
+
+#endif
@@ -0,0 +1,82 @@
+/**
+ * @file  timeline.h
+ *
+ * @brief Chrome trace-event export of a run (--timeline), readable by
+ *        chrome://tracing and ui.perfetto.dev. It has one track per bank
+ *        (each ACT to PRE as a span named after the open row), one for the
+ *        command bus and one for the data bus of the channel (each command and
+ *        each burst), an async track per core (each request from its arrival
+ *        to its completion) and a counter of the queue occupancy.
+ *
+ *        Events are written to the file as they happen, so the memory it takes
+ *        is the open row of each bank and nothing else, however long the run.
+ *        A window limits the file to the events that overlap it. Timestamps
+ *        are DIMM cycles, shown by the viewers as microseconds.
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef __TIMELINE_H__
+#define __TIMELINE_H__
+
+#include "common.h"
+#include "dimm.h"
+#include "memory_request.h"
+#include "output.h"
+
+/*** macro(s), enum(s), struct(s) ***/
+#define TIMELINE_BANK_CLOSED UINT64_MAX
+
+typedef struct Timeline {
+  FILE *file;
+  uint64_t window_start;   // DIMM cycles; events that end before it are dropped
+  uint64_t window_end;     // events that start at or after it are dropped
+  uint64_t num_events;
+  uint64_t num_requests;   // async id of the next request slice
+  uint64_t open_since[MAX_RANKS_PER_CHANNEL][NUM_BANKS];  // ACT0 cycle of the open row, TIMELINE_BANK_CLOSED if precharged
+  uint16_t open_row[MAX_RANKS_PER_CHANNEL][NUM_BANKS];
+  int32_t queue_size;      // last occupancy written, -1 before the first
+  uint8_t command_rate;    // DIMM cycles a command holds the command bus
+} Timeline_t;
+
+/*** function declaration(s) ***/
+/**
+ * @brief Create the timeline file and write the track names.
+ *
+ * @param timeline      The timeline
+ * @param file_name     The JSON file
+ * @param window_start  First DIMM cycle kept
+ * @param window_end    DIMM cycle the window ends before, UINT64_MAX for the whole run
+ * @param dimm          The DIMM, for its ranks, command rate and clocks
+ */
+void timeline_init(Timeline_t *timeline, char *file_name, uint64_t window_start, uint64_t window_end, DIMM_t *dimm);
+
+/**
+ * @brief Record an issued command on the command bus and, for ACT and PRE,
+ *        open or close the span of its bank.
+ */
+void timeline_command(Timeline_t *timeline, const CommandRecord_t *record);
+
+/**
+ * @brief Record a data burst, start and length in DIMM cycles.
+ */
+void timeline_burst(Timeline_t *timeline, MemoryRequest_t *request, uint64_t start, uint64_t length);
+
+/**
+ * @brief Record a request on its core's async track once it completes. Both
+ *        cycles are DIMM cycles.
+ */
+void timeline_request(Timeline_t *timeline, MemoryRequest_t *request, uint64_t arrival, uint64_t completion);
+
+/**
+ * @brief Record the queue occupancy if it changed.
+ */
+void timeline_queue(Timeline_t *timeline, uint64_t cycle, uint8_t size);
+
+/**
+ * @brief End the spans of the banks still open at the last cycle and close the file.
+ */
+void timeline_close(Timeline_t *timeline, uint64_t cycle);
+
+#endif
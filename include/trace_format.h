@@ -0,0 +1,118 @@
+/**
+ * @file  trace_format.h
+ *
+ * @brief Importers that turn the traces of other tools into memory requests
+ *        as they are read, so an existing trace library replays without a
+ *        conversion pass:
+ *
+ *          native    <time> <core> <op> <hex address>, the course format
+ *          ramulator <bubbles> <address> [<writeback address>] CPU traces, and
+ *                    <address> <R|W> memory traces
+ *          dramsim3  <address> <READ|WRITE> <cycle>
+ *          champsim  64-byte input_instr records (binary)
+ *          perf-mem  perf mem report -D (--dump-raw-samples) text
+ *
+ *        Formats without timestamps advance one CPU cycle per instruction (or
+ *        sample) and replay on core 0; perf-mem spreads its threads over the
+ *        cores. Addresses wider than the simulated DIMM are brought into it by
+ *        an address policy: reject them (the native default), keep the low
+ *        bits, or XOR-fold the high bits onto them. Both remaps also take out
+ *        the channel bit, as only channel 0 is simulated.
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef __TRACE_FORMAT_H__
+#define __TRACE_FORMAT_H__
+
+#include "common.h"
+#include "memory_request.h"
+
+/*** macro(s), enum(s), struct(s) ***/
+#define MAX_IMPORTED_REQUESTS 8  // a ChampSim instruction: a fetch, 4 loads and 2 stores
+
+typedef enum TraceFormat {
+  TRACE_NATIVE,
+  TRACE_RAMULATOR,
+  TRACE_DRAMSIM3,
+  TRACE_CHAMPSIM,
+  TRACE_PERF_MEM,
+  NUM_TRACE_FORMATS
+} TraceFormat_t;
+
+typedef enum AddressPolicy {
+  ADDRESS_REJECT,  // stop at the first address the DIMM cannot hold
+  ADDRESS_MASK,    // keep the low bits
+  ADDRESS_FOLD,    // XOR the high bits onto the low bits
+  NUM_ADDRESS_POLICIES
+} AddressPolicy_t;
+
+// one instruction of a ChampSim trace
+typedef struct __attribute__((__packed__)) ChampSimInstruction {
+  uint64_t ip;
+  uint8_t is_branch;
+  uint8_t branch_taken;
+  uint8_t destination_registers[2];
+  uint8_t source_registers[4];
+  uint64_t destination_memory[2];  // stores, 0 = unused
+  uint64_t source_memory[4];       // loads, 0 = unused
+} ChampSimInstruction_t;
+
+_Static_assert(sizeof(ChampSimInstruction_t) == 64, "ChampSim records are 64 bytes");
+
+// everything an importer carries from one record to the next; checkpointed with the parser
+typedef struct TraceImporter {
+  uint8_t format;             // TraceFormat_t
+  uint8_t policy;             // AddressPolicy_t
+  uint64_t clock;             // cpu cycle of the next instruction or sample
+  uint64_t last_fetch_line;   // ChampSim: fetches are only issued when the instruction line changes
+  uint8_t address_column;     // perf-mem: columns of the address and the data source, from the header
+  uint8_t source_column;
+  MemoryRequest_t pending[MAX_IMPORTED_REQUESTS];  // requests of the last record not yet handed out
+  uint8_t num_pending;
+  uint8_t next_pending;
+} TraceImporter_t;
+
+/*** function declaration(s) ***/
+/**
+ * @brief Set up an importer. NUM_ADDRESS_POLICIES picks the default policy of
+ *        the format: reject for native traces, fold for the others.
+ */
+void trace_importer_init(TraceImporter_t *importer, TraceFormat_t format, AddressPolicy_t policy);
+
+/**
+ * @brief Turn one text line into requests; comments, headers and samples
+ *        that are not memory accesses give none.
+ */
+void trace_import_line(TraceImporter_t *importer, char *line);
+
+/**
+ * @brief Turn one ChampSim instruction into requests.
+ */
+void trace_import_champsim(TraceImporter_t *importer, const ChampSimInstruction_t *instruction);
+
+/**
+ * @brief Take the next request of the last record.
+ *
+ * @return true  if one was left
+ */
+bool trace_import_next(TraceImporter_t *importer, MemoryRequest_t *request);
+
+/**
+ * @brief Bring an address into the simulated DIMM and onto channel 0.
+ */
+uint64_t trace_remap_address(uint64_t address, AddressPolicy_t policy);
+
+/**
+ * @brief Check that an address fits the DIMM and maps to channel 0, exit if it
+ *        does not. This is what the reject policy does.
+ */
+void trace_check_address(uint64_t time, uint64_t address);
+
+int trace_format_parse(const char *name);
+const char *trace_format_name(TraceFormat_t format);
+int address_policy_parse(const char *name);
+const char *address_policy_name(AddressPolicy_t policy);
+
+#endif
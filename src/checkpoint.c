@@ -0,0 +1,392 @@
+/**
+ * @file  checkpoint.c
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include <signal.h>
+#include <stddef.h>
+#include "checkpoint.h"
+
+// the run's counts; the interval sketch and its file belong to the process
+#define HOT_ROWS_IMAGE_SIZE offsetof(HotRows_t, file)
+
+static volatile sig_atomic_t checkpoint_pending = 0;
+
+/*** helper function(s) ***/
+static uint32_t fnv1a(const uint8_t *data, uint64_t length) {
+  uint32_t hash = 2166136261u;
+  for (uint64_t i = 0; i < length; i++) {
+    hash ^= data[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static void on_sigusr1(int signal_number) {
+  (void)signal_number;
+  checkpoint_pending = 1;
+}
+
+static void write_image(char *file_name, uint8_t *image, uint64_t image_size) {
+  char temp_name[LINE_LENGTH];
+  snprintf(temp_name, sizeof(temp_name), "%s.tmp", file_name);
+
+  FILE *file = fopen(temp_name, "wb");
+  if (file == NULL) {
+    perror("Error opening checkpoint file");
+    exit(EXIT_FAILURE);
+  }
+
+  if (fwrite(image, 1, image_size, file) != image_size || fclose(file) != 0) {
+    perror("Error writing checkpoint file");
+    exit(EXIT_FAILURE);
+  }
+
+  if (rename(temp_name, file_name) != 0) {
+    perror("Error renaming checkpoint file");
+    exit(EXIT_FAILURE);
+  }
+}
+
+static uint8_t *read_image(char *file_name, uint64_t *image_size) {
+  FILE *file = fopen(file_name, "rb");
+  if (file == NULL) {
+    perror("Error opening checkpoint file");
+    exit(EXIT_FAILURE);
+  }
+
+  fseeko(file, 0, SEEK_END);
+  *image_size = ftello(file);
+  fseeko(file, 0, SEEK_SET);
+
+  uint8_t *image = malloc(*image_size);
+  if (image == NULL) {
+    fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  if (fread(image, 1, *image_size, file) != *image_size) {
+    perror("Error reading checkpoint file");
+    exit(EXIT_FAILURE);
+  }
+
+  fclose(file);
+  return image;
+}
+
+static void validate_header(CheckpointHeader_t *header, uint8_t *image, uint64_t image_size) {
+  if (image_size < sizeof(CheckpointHeader_t) || memcmp(header->magic, CHECKPOINT_MAGIC, sizeof(header->magic)) != 0) {
+    fprintf(stderr, "Error: not a checkpoint file\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if (header->version != CHECKPOINT_VERSION) {
+    fprintf(stderr, "Error: checkpoint version %u, expected %u\n", header->version, CHECKPOINT_VERSION);
+    exit(EXIT_FAILURE);
+  }
+
+  if (
+    header->request_size != sizeof(MemoryRequest_t) ||
+    header->channel_size != sizeof(Channel_t) ||
+    header->stats_size != sizeof(Stats_t)
+  ) {
+    fprintf(stderr, "Error: checkpoint was written by an incompatible build\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if (header->image_size != image_size) {
+    fprintf(stderr, "Error: checkpoint is truncated (%" PRIu64 " of %" PRIu64 " bytes)\n", image_size, header->image_size);
+    exit(EXIT_FAILURE);
+  }
+
+  uint64_t payload_size = image_size - sizeof(CheckpointHeader_t);
+  if (header->checksum != fnv1a(image + sizeof(CheckpointHeader_t), payload_size)) {
+    fprintf(stderr, "Error: checkpoint checksum mismatch\n");
+    exit(EXIT_FAILURE);
+  }
+}
+
+/*** function(s) ***/
+void checkpoint_save(Simulator_t *sim, char *file_name) {
+  CheckpointHeader_t header;
+  memset(&header, 0, sizeof(header));
+
+  memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+  header.version = CHECKPOINT_VERSION;
+  header.request_size = sizeof(MemoryRequest_t);
+  header.channel_size = sizeof(Channel_t);
+  header.stats_size = sizeof(Stats_t);
+  header.clock_cycle = sim->clock_cycle;
+  header.parser_offset = parser_tell(sim->parser);
+  uint64_t offsets[MAX_OUTPUT_SINKS];
+  output_offsets(&sim->dimm->output, offsets);
+  memcpy(header.output_offsets, offsets, sizeof(offsets));
+  header.admitted_requests = sim->admitted_requests;
+  header.cpu_mhz = sim->dimm->time_base.cpu_mhz;
+  header.data_rate = sim->dimm->time_base.data_rate;
+  header.queue_size = sim->queue->size;
+  header.scheduling_policy = sim->scheduling_policy;
+  header.dimms_per_channel = sim->dimm->dimms_per_channel;
+  header.ranks_per_dimm = sim->dimm->ranks_per_dimm;
+  header.command_rate = DIMM_COMMAND_RATE(sim->dimm);
+  header.burst_length = DIMM_BURST_LENGTH(sim->dimm);
+  header.burst_chop = DIMM_BURST_CHOP(sim->dimm);
+  header.parser_status = sim->parser->status;
+  header.trace_format = sim->parser->importer.format;
+  header.has_next_request = sim->parser->status == OK;
+  header.num_pending = sim->num_pending;
+  header.admit_width = sim->admit_width;
+  header.has_prefetcher = sim->prefetcher != NULL;
+  header.has_core_model = sim->cores != NULL;
+  header.hot_rows = sim->hot_rows != NULL ? sim->hot_rows->k : 0;
+  header.has_rowhammer = sim->rowhammer != NULL;
+  header.num_outputs = sim->dimm->output.num_sinks;
+  for (int i = 0; i < header.num_outputs; i++) {
+    header.output_kinds[i] = sim->dimm->output.sinks[i].kind;
+  }
+
+  header.image_size = sizeof(CheckpointHeader_t) +
+                      sizeof(MemoryRequest_t) * (header.has_next_request + header.num_pending + header.queue_size) +
+                      sizeof(TraceImporter_t) +
+                      sizeof(Channel_t) * NUM_CHANNELS +
+                      sizeof(Stats_t) +
+                      sizeof(HazardTable_t) +
+                      sizeof(Prefetcher_t) * header.has_prefetcher +
+                      sizeof(CoreModel_t) * header.has_core_model +
+                      HOT_ROWS_IMAGE_SIZE * (header.hot_rows > 0) +
+                      sizeof(RowHammer_t) * header.has_rowhammer;
+
+  uint8_t *image = malloc(header.image_size);
+  if (image == NULL) {
+    fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  // payload
+  uint8_t *cursor = image + sizeof(CheckpointHeader_t);
+  if (header.has_next_request) {
+    memcpy(cursor, &sim->parser->next_request, sizeof(MemoryRequest_t));
+    cursor += sizeof(MemoryRequest_t);
+  }
+
+  memcpy(cursor, &sim->parser->importer, sizeof(TraceImporter_t));
+  cursor += sizeof(TraceImporter_t);
+
+  memcpy(cursor, sim->pending, sizeof(MemoryRequest_t) * header.num_pending);
+  cursor += sizeof(MemoryRequest_t) * header.num_pending;
+
+  for (uint32_t i = 0; i < header.queue_size; i++) {
+    memcpy(cursor, queue_peek_at(sim->queue, i), sizeof(MemoryRequest_t));
+    cursor += sizeof(MemoryRequest_t);
+  }
+
+  memcpy(cursor, sim->dimm->channels, sizeof(Channel_t) * NUM_CHANNELS);
+  cursor += sizeof(Channel_t) * NUM_CHANNELS;
+
+  memcpy(cursor, &sim->dimm->stats, sizeof(Stats_t));
+  cursor += sizeof(Stats_t);
+
+  memcpy(cursor, &sim->dimm->hazards, sizeof(HazardTable_t));
+  cursor += sizeof(HazardTable_t);
+
+  if (header.has_prefetcher) {
+    memcpy(cursor, sim->prefetcher, sizeof(Prefetcher_t));
+    cursor += sizeof(Prefetcher_t);
+  }
+
+  if (header.has_core_model) {
+    memcpy(cursor, sim->cores, sizeof(CoreModel_t));
+    cursor += sizeof(CoreModel_t);
+  }
+
+  if (header.hot_rows > 0) {
+    memcpy(cursor, sim->hot_rows, HOT_ROWS_IMAGE_SIZE);
+    cursor += HOT_ROWS_IMAGE_SIZE;
+  }
+
+  if (header.has_rowhammer) {
+    memcpy(cursor, sim->rowhammer, sizeof(RowHammer_t));
+  }
+
+  header.checksum = fnv1a(image + sizeof(CheckpointHeader_t), header.image_size - sizeof(CheckpointHeader_t));
+  memcpy(image, &header, sizeof(CheckpointHeader_t));
+
+  write_image(file_name, image, header.image_size);
+  free(image);
+
+  LOG("[%" PRIu64 "] Checkpoint written to %s\n", sim->clock_cycle, file_name);
+}
+
+Simulator_t *checkpoint_restore(Config_t *config) {
+  uint64_t image_size = 0;
+  uint8_t *image = read_image(config->restore_file, &image_size);
+
+  CheckpointHeader_t header;
+  memcpy(&header, image, sizeof(CheckpointHeader_t));
+  validate_header(&header, image, image_size);
+
+  if (header.scheduling_policy != config->scheduling_policy) {
+    fprintf(stderr, "Error: checkpoint was taken with scheduling policy %u, not %u\n", header.scheduling_policy, config->scheduling_policy);
+    exit(EXIT_FAILURE);
+  }
+
+  if (header.dimms_per_channel != config->dimms_per_channel || header.ranks_per_dimm != config->ranks_per_dimm) {
+    fprintf(stderr, "Error: checkpoint was taken with %u DIMM(s) of %u rank(s) per channel, not %u of %u\n", header.dimms_per_channel,
+            header.ranks_per_dimm, config->dimms_per_channel, config->ranks_per_dimm);
+    exit(EXIT_FAILURE);
+  }
+
+  if (header.command_rate != config->command_rate || header.burst_length != config->burst_length ||
+      header.burst_chop != config->burst_chop) {
+    fprintf(stderr, "Error: checkpoint was taken with %uN and %s, not %uN and %s\n", header.command_rate,
+            header.burst_chop ? "BC8" : header.burst_length == BL32 ? "BL32" : "BL16", config->command_rate,
+            config->burst_chop ? "BC8" : config->burst_length == BL32 ? "BL32" : "BL16");
+    exit(EXIT_FAILURE);
+  }
+
+  if (header.trace_format != config->trace_format) {
+    fprintf(stderr, "Error: checkpoint was taken from a %s trace, not %s\n", trace_format_name(header.trace_format),
+            trace_format_name(config->trace_format));
+    exit(EXIT_FAILURE);
+  }
+
+  if (header.admit_width != config->admit_width) {
+    fprintf(stderr, "Error: checkpoint was taken with an admission width of %u, not %u\n", header.admit_width, config->admit_width);
+    exit(EXIT_FAILURE);
+  }
+
+  if (header.cpu_mhz != config->cpu_mhz || header.data_rate != config->data_rate) {
+    fprintf(stderr, "Error: checkpoint was taken with a %u MHz CPU and DDR5-%u, not %u MHz and DDR5-%u\n", header.cpu_mhz,
+            header.data_rate, config->cpu_mhz, config->data_rate);
+    exit(EXIT_FAILURE);
+  }
+
+  if (header.has_prefetcher != config->prefetch) {
+    fprintf(stderr, "Error: checkpoint was taken %s --prefetch\n", header.has_prefetcher ? "with" : "without");
+    exit(EXIT_FAILURE);
+  }
+
+  if (header.has_core_model != config->closed_loop) {
+    fprintf(stderr, "Error: checkpoint was taken %s --closed-loop\n", header.has_core_model ? "with" : "without");
+    exit(EXIT_FAILURE);
+  }
+
+  if (header.hot_rows != config->hot_rows) {
+    fprintf(stderr, "Error: checkpoint was taken with --hot-rows %u, not %u\n", header.hot_rows, config->hot_rows);
+    exit(EXIT_FAILURE);
+  }
+
+  if (header.has_rowhammer != (config->rfm_mode != RFM_OFF || config->prac_threshold > 0)) {
+    fprintf(stderr, "Error: checkpoint was taken %s RowHammer mitigation\n", header.has_rowhammer ? "with" : "without");
+    exit(EXIT_FAILURE);
+  }
+
+  bool same_outputs = header.num_outputs == config->num_outputs;
+  for (int i = 0; same_outputs && i < header.num_outputs; i++) {
+    same_outputs = header.output_kinds[i] == config->output_kinds[i];
+  }
+  if (!same_outputs) {
+    fprintf(stderr, "Error: checkpoint was taken with other --output sinks\n");
+    exit(EXIT_FAILURE);
+  }
+
+  Simulator_t *sim = simulator_create(config);
+  uint8_t *cursor = image + sizeof(CheckpointHeader_t);
+
+  // parser: continue reading right after the pending request
+  MemoryRequest_t *next_request = NULL;
+  if (header.has_next_request) {
+    next_request = (MemoryRequest_t *)cursor;
+    cursor += sizeof(MemoryRequest_t);
+  }
+  parser_seek(sim->parser, header.parser_offset, next_request);
+  memcpy(&sim->parser->importer, cursor, sizeof(TraceImporter_t));
+  cursor += sizeof(TraceImporter_t);
+  if (sim->parser->importer.policy != config->address_policy) {
+    fprintf(stderr, "Error: checkpoint was taken with --address-map %s, not %s\n", address_policy_name(sim->parser->importer.policy),
+            address_policy_name(config->address_policy));
+    exit(EXIT_FAILURE);
+  }
+
+  memcpy(sim->pending, cursor, sizeof(MemoryRequest_t) * header.num_pending);
+  sim->num_pending = header.num_pending;
+  cursor += sizeof(MemoryRequest_t) * header.num_pending;
+
+  // queue: enqueue inserts at the young end, so oldest first keeps the order
+  for (uint32_t i = 0; i < header.queue_size; i++) {
+    MemoryRequest_t request;
+    memcpy(&request, cursor, sizeof(MemoryRequest_t));
+    enqueue(&sim->queue, request);
+    cursor += sizeof(MemoryRequest_t);
+  }
+
+  memcpy(sim->dimm->channels, cursor, sizeof(Channel_t) * NUM_CHANNELS);
+  cursor += sizeof(Channel_t) * NUM_CHANNELS;
+
+  memcpy(&sim->dimm->stats, cursor, sizeof(Stats_t));
+  cursor += sizeof(Stats_t);
+
+  memcpy(&sim->dimm->hazards, cursor, sizeof(HazardTable_t));
+  cursor += sizeof(HazardTable_t);
+
+  if (header.has_prefetcher) {
+    memcpy(sim->prefetcher, cursor, sizeof(Prefetcher_t));
+    cursor += sizeof(Prefetcher_t);
+  }
+
+  if (header.has_core_model) {
+    memcpy(sim->cores, cursor, sizeof(CoreModel_t));
+    cursor += sizeof(CoreModel_t);
+  }
+
+  if (header.hot_rows > 0) {
+    memcpy(sim->hot_rows, cursor, HOT_ROWS_IMAGE_SIZE);
+    cursor += HOT_ROWS_IMAGE_SIZE;
+  }
+
+  if (header.has_rowhammer) {
+    RowHammer_t *rowhammer = sim->rowhammer;
+    memcpy(rowhammer, cursor, sizeof(RowHammer_t));
+    if (rowhammer->rfm_mode != config->rfm_mode || rowhammer->raa_imt != config->raa_imt || rowhammer->raa_mmt != config->raa_mmt ||
+        rowhammer->prac_threshold != config->prac_threshold || rowhammer->prac_rfms != config->prac_rfms) {
+      fprintf(stderr, "Error: checkpoint was taken with other --rfm, --raa-imt, --raa-mmt, --prac or --prac-rfms settings\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  sim->clock_cycle = header.clock_cycle;
+  sim->admitted_requests = header.admitted_requests;
+  for (int i = 0; i < config->num_outputs; i++) {
+    output_resume_sink(&sim->dimm->output, config->output_kinds[i], config->output_files[i], header.output_offsets[i]);
+  }
+
+  if (sim->intervals != NULL) {
+    interval_stats_resume(sim->intervals, sim->queue, time_base_dimm_cycle(&sim->dimm->time_base, sim->clock_cycle));
+  }
+  if (sim->hot_rows != NULL) {
+    hot_rows_resume(sim->hot_rows, time_base_dimm_cycle(&sim->dimm->time_base, sim->clock_cycle));
+  }
+
+  free(image);
+  return sim;
+}
+
+void checkpoint_install_signal_handler(bool accept) {
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = accept ? on_sigusr1 : SIG_IGN;
+  sigemptyset(&action.sa_mask);
+  action.sa_flags = SA_RESTART;
+  sigaction(SIGUSR1, &action, NULL);
+}
+
+bool checkpoint_requested(void) {
+  if (checkpoint_pending) {
+    checkpoint_pending = 0;
+    return true;
+  }
+
+  return false;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file  config.c
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "config.h"
+#include "core_model.h"
+#include "dueling.h"
+#include "epoch.h"
+#include "hot_rows.h"
+#include "interval_stats.h"
+#include "load_curve.h"
+#include "prefetcher.h"
+#include "rowhammer.h"
+#include "sampling.h"
+#include "time_base.h"
+#include "trace_format.h"
+
+void config_init(Config_t *config) {
+  config->input_file = DEFAULT_INPUT_FILE;
+  config->trace_format = TRACE_NATIVE;
+  config->address_policy = NUM_ADDRESS_POLICIES;
+  config->output_file = DEFAULT_OUTPUT_FILE;
+  config->num_outputs = 0;
+  config->scheduling_policy = LEVEL_0;
+  config->preset = -1;
+  config->generic_engine = false;
+  config->cpu_mhz = DEFAULT_CPU_MHZ;
+  config->data_rate = DEFAULT_DATA_RATE;
+  config->command_rate = 1;
+  config->admit_width = 1;
+  config->print_stats = false;
+  config->burst_length = 16;
+  config->burst_chop = false;
+  config->dimms_per_channel = 1;
+  config->ranks_per_dimm = 1;
+  config->prefetch = false;
+  config->prefetch_degree = DEFAULT_PREFETCH_DEGREE;
+
+  config->closed_loop = false;
+  config->core_mlp = DEFAULT_CORE_MLP;
+  config->dependency = DEPENDENCY_IFETCH;
+
+  config->checkpoint_file = DEFAULT_CHECKPOINT_FILE;
+  config->checkpoint_interval = 0;
+  config->restore_file = NULL;
+
+  config->sample = false;
+  config->sample_period = DEFAULT_SAMPLE_PERIOD;
+  config->sample_warmup = DEFAULT_SAMPLE_WARMUP;
+  config->sample_window = DEFAULT_SAMPLE_WINDOW;
+
+  config->timeline_file = NULL;
+  config->timeline_start = 0;
+  config->timeline_end = UINT64_MAX;
+
+  config->interval_cycles = 0;
+  config->interval_file = NULL;
+  config->interval_format = INTERVAL_CSV;
+
+  config->hot_rows = 0;
+  config->hot_rows_interval = 0;
+  config->hot_rows_file = DEFAULT_HOT_ROWS_FILE;
+
+  config->rfm_mode = RFM_OFF;
+  config->raa_imt = DEFAULT_RAA_IMT;
+  config->raa_mmt = 0;
+  config->prac_threshold = 0;
+  config->prac_rfms = DEFAULT_PRAC_RFMS;
+
+  config->num_duel_policies = 0;
+  config->duel_epoch = DEFAULT_DUEL_EPOCH;
+  config->duel_sample = DEFAULT_DUEL_SAMPLE;
+
+  config->num_load_scales = 0;
+  config->latency_slo = DEFAULT_LATENCY_SLO;
+  config->load_threads = 0;
+  config->load_curve_file = DEFAULT_LOAD_CURVE_FILE;
+
+  config->epochs = 1;
+  config->epoch_warmup = DEFAULT_EPOCH_WARMUP;
+}
+
+uint8_t config_rank_bits(Config_t *config) {
+  uint8_t ranks = config->dimms_per_channel * config->ranks_per_dimm;
+  uint8_t bits = 0;
+
+  while ((1 << bits) < ranks) {
+    bits++;
+  }
+
+  return bits;
+}
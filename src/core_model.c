@@ -0,0 +1,168 @@
+/**
+ * @file  core_model.c
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "core_model.h"
+
+static const char *dependency_names[] = {"none", "ifetch", "loads"};
+
+/*** helper function(s) ***/
+static bool is_dependency(CoreModel_t *model, MemoryRequest_t *request) {
+  switch (model->dependency) {
+    case DEPENDENCY_IFETCH:
+      return request->operation == IFETCH;
+    case DEPENDENCY_LOADS:
+      return request->operation != DATA_WRITE;
+    case DEPENDENCY_NONE:
+    default:
+      return false;
+  }
+}
+
+static void fill_buffers(CoreModel_t *model, Parser_t *parser) {
+  // stop at the first request whose core is full, the trace order within a core must hold
+  while (parser->status == OK) {
+    Core_t *core = &model->cores[parser->next_request.core];
+    if (core->count == CORE_LOOKAHEAD) {
+      break;
+    }
+
+    uint8_t slot = (core->head + core->count) % CORE_LOOKAHEAD;
+    MemoryRequest_t *request = &core->pending[slot];
+
+    parser_next_request(parser, UINT64_MAX, request);
+    core->gaps[slot] = request->time - core->last_trace_time;
+    core->last_trace_time = request->time;
+    core->count++;
+  }
+}
+
+static uint64_t ready_cycle(Core_t *core) {
+  return core->resume_cycle + core->gaps[core->head];
+}
+
+static bool can_release(CoreModel_t *model, Core_t *core) {
+  if (core->count == 0 || core->blocked) {
+    return false;
+  }
+
+  // writes are posted and do not hold a miss slot
+  MemoryRequest_t *request = &core->pending[core->head];
+  return request->operation == DATA_WRITE || core->outstanding < model->mlp;
+}
+
+/*** function(s) ***/
+void core_model_init(CoreModel_t *model, uint16_t mlp, DependencyModel_t dependency) {
+  memset(model, 0, sizeof(CoreModel_t));
+  model->mlp = mlp;
+  model->dependency = dependency;
+}
+
+bool core_model_next_request(CoreModel_t *model, Parser_t *parser, uint64_t cycle, MemoryRequest_t *request) {
+  fill_buffers(model, parser);
+
+  for (int i = 0; i < NUM_CORES; i++) {
+    uint8_t index = (model->next_core + i) % NUM_CORES;
+    Core_t *core = &model->cores[index];
+
+    if (!can_release(model, core) || ready_cycle(core) > cycle) {
+      continue;
+    }
+
+    // compute finished at the ready cycle, anything after it was spent waiting to issue
+    *request = core->pending[core->head];
+    core->compute_cycles += core->gaps[core->head];
+    core->issue_stall_cycles += cycle - ready_cycle(core);
+    core->head = (core->head + 1) % CORE_LOOKAHEAD;
+    core->count--;
+
+    request->time = cycle;
+    core->resume_cycle = cycle;
+    core->released++;
+    if (request->operation != DATA_WRITE) {
+      core->outstanding++;
+    }
+    core->blocked = is_dependency(model, request);
+
+    model->next_core = (index + 1) % NUM_CORES;
+    return true;
+  }
+
+  return false;
+}
+
+void core_model_complete(CoreModel_t *model, MemoryRequest_t *request, uint64_t cycle) {
+  Core_t *core = &model->cores[request->core];
+
+  core->completed++;
+  core->total_latency += cycle - request->time;
+  if (request->operation == DATA_WRITE) {
+    return;
+  }
+
+  core->outstanding--;
+  if (core->blocked && is_dependency(model, request)) {
+    // the dependent instruction runs once the data is back, the next compute gap starts here
+    core->dependency_stall_cycles += cycle - core->resume_cycle;
+    core->resume_cycle = cycle;
+    core->blocked = false;
+  }
+}
+
+uint64_t core_model_next_release(CoreModel_t *model) {
+  uint64_t next = UINT64_MAX;
+
+  for (int i = 0; i < NUM_CORES; i++) {
+    Core_t *core = &model->cores[i];
+    if (can_release(model, core) && ready_cycle(core) < next) {
+      next = ready_cycle(core);
+    }
+  }
+
+  return next;
+}
+
+bool core_model_is_drained(CoreModel_t *model) {
+  for (int i = 0; i < NUM_CORES; i++) {
+    if (model->cores[i].count != 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+DependencyModel_t core_model_parse_dependency(char *name) {
+  for (int i = 0; i < (int)(sizeof(dependency_names) / sizeof(dependency_names[0])); i++) {
+    if (strcmp(name, dependency_names[i]) == 0) {
+      return (DependencyModel_t)i;
+    }
+  }
+
+  return (DependencyModel_t)-1;
+}
+
+const char *core_model_dependency_name(DependencyModel_t dependency) {
+  return dependency_names[dependency];
+}
+
+void core_model_print_stats(CoreModel_t *model, FILE *stream) {
+  fprintf(stream, "Closed Loop: MLP %u, %s dependencies\n", model->mlp, dependency_names[model->dependency]);
+  fprintf(stream, "Core  Requests  Avg Latency  Issue Stall  Dep. Stall  IPC Proxy\n");
+
+  for (int i = 0; i < NUM_CORES; i++) {
+    Core_t *core = &model->cores[i];
+    if (core->released == 0) {
+      continue;
+    }
+
+    // fraction of its time the core spent computing rather than waiting on memory
+    uint64_t busy = core->compute_cycles + core->issue_stall_cycles + core->dependency_stall_cycles;
+    fprintf(stream, "%4d  %8" PRIu64 "  %11.2lf  %11" PRIu64 "  %10" PRIu64 "  %9.3lf\n", i, core->released,
+           core->completed ? (double)core->total_latency / core->completed : 0.0, core->issue_stall_cycles,
+           core->dependency_stall_cycles, busy ? (double)core->compute_cycles / busy : 1.0);
+  }
+}
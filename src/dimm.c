@@ -6,41 +6,83 @@
  */
 
 #include "dimm.h"
+#include "core_model.h"
+#include "dueling.h"
+#include "hot_rows.h"
+#include "interval_stats.h"
+#include "prefetcher.h"
+#include "rowhammer.h"
+#include "scheduler.h"
+#include "timeline.h"
+
+// the bank timers, indexed by TimingConstraints_t, as X(picoseconds); tBURST is given in clocks,
+// the BL16 one, see set_burst_timer()
+#define TIMING_TABLE(X, burst) { \
+  [tRC] = X(TRC_PS), \
+  [tRAS] = X(TRAS_PS), \
+  [tRP] = X(TRP_PS), \
+  [tRFC] = X(TRFC_PS), \
+  [tCWL] = X(TCWL_PS), \
+  [tCL] = X(TCL_PS), \
+  [tRCD] = X(TRCD_PS), \
+  [tWR] = X(TWR_PS), \
+  [tRTP] = X(TRTP_PS), \
+  [tBURST] = (burst), \
+}
 
-uint16_t timing_attribute[NUM_TIMING_CONSTRAINTS] = {
-  TRC,
-  TRAS,
-  TRP,
-  TRFC,
-  TCWL,
-  TCL,
-  TRCD,
-  TWR,
-  TRTP,
-  TBURST
-};
+// the command spacing, [previous][next][other bank group, same bank group], as X(picoseconds, clocks);
+// the larger of the two applies
+#define SPACING_TABLE(X) { \
+  [ACTIVATE] = { \
+    [ACTIVATE] = {X(0, TRRD_S), X(TRRD_L_PS, 0)}, \
+  }, \
+  [READ] = { \
+    [READ]  = {X(0, TCCD_S), X(TCCD_L_PS, 0)}, \
+    [WRITE] = {X(TCCD_S_RTW_PS, 0), X(TCCD_L_RTW_PS, 0)}, \
+  }, \
+  [WRITE] = { \
+    [READ]  = {X(TCCD_S_WTR_PS, 0), X(TCCD_L_WTR_PS, 0)}, \
+    [WRITE] = {X(0, TCCD_S_WR), X(TCCD_L_WR_PS, 0)}, \
+  }, \
+}
 
-uint8_t consecutive_cmd_attribute[NUM_CONSECUTIVE_CMD_CONSTRAINTS] = {
-  TRRD_L,
-  TRRD_S,
-  TCCD_L,
-  TCCD_S,
-  TCCD_L_WR,
-  TCCD_S_WR,
-  TCCD_L_RTW,
-  TCCD_S_RTW,
-  TCCD_L_WTR,
-  TCCD_S_WTR
+#define PS_OF(ps, ...) (ps)
+#define CLOCKS_OF(ps, clocks) (clocks)
+#define AT_LEAST(cycles, minimum) ((cycles) < (minimum) ? (minimum) : (cycles))
+
+static const uint32_t timing_ps[NUM_TIMING_CONSTRAINTS] = TIMING_TABLE(PS_OF, 0);
+static const uint32_t spacing_ps[NUM_SPACED_COMMANDS][NUM_SPACED_COMMANDS][2] = SPACING_TABLE(PS_OF);
+static const uint8_t spacing_clocks[NUM_SPACED_COMMANDS][NUM_SPACED_COMMANDS][2] = SPACING_TABLE(CLOCKS_OF);
+
+#ifdef FIXED_PRESET
+// the table dimm_set_time_base() computes, derived from the preset's data rate at compile time
+#define FIXED_CYCLES(ps) PS_TO_DIMM_CYCLES(ps, FIXED_PRESET_DATA_RATE)
+#define FIXED_SPACING(ps, clocks) AT_LEAST(FIXED_CYCLES(ps), clocks)
+#define FIXED_LATENCY AT_LEAST(FIXED_CYCLES(TCL_PS), FIXED_CYCLES(TCWL_PS))
+
+static const Timings_t fixed_timings = {
+  .constraints = TIMING_TABLE(FIXED_CYCLES, TBURST),
+  .spacing = SPACING_TABLE(FIXED_SPACING),
+  .tfaw = AT_LEAST(FIXED_CYCLES(TFAW_PS), TFAW),
+  .data_bus_reservations = DATA_BUS_RESERVATIONS(FIXED_LATENCY),
 };
+#define DIMM_TIMINGS(dimm) (&fixed_timings)
+#else
+#define DIMM_TIMINGS(dimm) ((const Timings_t *)&(dimm)->timings)
+#endif
 
 /*** helper function(s) ***/
+BankMask_t bank_bit(MemoryRequest_t *request) {
+  return BANK_BIT(request->bank_group, request->bank);
+}
+
 bool is_bank_active(DRAM_t *dram, MemoryRequest_t *request) {
-  bool active_result = dram->bank_groups[request->bank_group].banks[request->bank].is_active;
+  bool active_result = (dram->open_banks & bank_bit(request)) != 0;
   return active_result;
 }
 
 bool is_bank_precharged(DRAM_t *dram, MemoryRequest_t *request) {
-  bool precharged_result = dram->bank_groups[request->bank_group].banks[request->bank].is_precharged;
+  bool precharged_result = (dram->precharged_banks & bank_bit(request)) != 0;
   return precharged_result;
 }
 
@@ -60,75 +102,121 @@ bool is_page_empty(DRAM_t *dram, MemoryRequest_t *request) {
 }
 
 void activate_bank(DRAM_t *dram, MemoryRequest_t *request) {
-  dram->bank_groups[request->bank_group].banks[request->bank].is_active = true;
+  dram->open_banks |= bank_bit(request);
+  dram->precharged_banks &= ~bank_bit(request);
   dram->bank_groups[request->bank_group].banks[request->bank].active_row = request->row;
 }
 
 void precharge_bank(DRAM_t *dram, MemoryRequest_t *request) {
-  dram->bank_groups[request->bank_group].banks[request->bank].is_precharged = true;
-  dram->bank_groups[request->bank_group].banks[request->bank].is_active = false;
+  dram->precharged_banks |= bank_bit(request);
+  dram->open_banks &= ~bank_bit(request);
 }
 
-char *issue_cmd(char *cmd, MemoryRequest_t *request, uint64_t cycle) {
-  /**
-   * @brief Constructs a command string to be written to the output file.
-   *
-   * @param cmd     command string (ACT, PRE, RD, or WR)
-   * @param request memory request
-   * @return char*  command string to be written to the output file
-   */
-  char *response = malloc(sizeof(char) * 100);
-  char *temp = malloc(sizeof(char) * 100);
+void set_bank_busy(DRAM_t *dram, MemoryRequest_t *request, bool busy) {
+  if (busy) {
+    dram->busy_banks |= bank_bit(request);
+  }
+  else {
+    dram->busy_banks &= ~bank_bit(request);
+  }
+}
 
-  sprintf(response, "%10" PRIu64 " %u %4s", cycle, request->channel, cmd);
+// an open-page request holds its row from choosing it until its RD/WR is issued
+static void pin_row(DRAM_t *dram, MemoryRequest_t *request, bool pinned) {
+  if (pinned) {
+    dram->pins[request->bank_group][request->bank]++;
+  }
+  else {
+    dram->pins[request->bank_group][request->bank]--;
+  }
+}
 
-  if (strncmp(cmd, "ACT", 3) == 0) {
-    sprintf(temp, " %u %u 0x%04X", request->bank_group, request->bank, request->row);
+void set_last_operation(DRAM_t *dram, MemoryRequest_t *request) {
+  if (request->operation == DATA_WRITE) {
+    dram->write_banks |= bank_bit(request);
+  }
+  else {
+    dram->write_banks &= ~bank_bit(request);
+  }
+}
 
-  } else if (strncmp(cmd, "PRE", 3) == 0) {
-    sprintf(temp, " %u %u", request->bank_group, request->bank);
+bool is_bank_held(DIMM_t *dimm, MemoryRequest_t *request) {
+  return dimm->rowhammer != NULL && (dimm->rowhammer->held[request->channel][request->rank] & bank_bit(request)) != 0;
+}
 
-  } else if (strncmp(cmd, "RD", 2) == 0 || strncmp(cmd, "WR", 2) == 0) {
-    sprintf(temp, " %u %u 0x%04X", request->bank_group, request->bank, get_column(request));
+bool issue_cmd(DIMM_t *dimm, CommandRecord_t *record, CommandCode_t command, MemoryRequest_t *request, uint64_t cycle) {
+  /**
+   * @brief Fills in the record of a command for the output sinks.
+   *
+   * @param dimm    the DIMM
+   * @param record  filled with the command
+   * @param command ACT, PRE, RD or WR half
+   * @param request memory request
+   * @param cycle   cpu cycle the command is issued on, recorded as a DIMM cycle
+   * @return true   the command is issued
+   */
+  record->cycle = time_base_dimm_cycle(&dimm->time_base, cycle);
+  record->channel = request->channel;
+  record->rank = request->rank;
+  record->command = command;
+  record->bank_group = request->bank_group;
+  record->bank = request->bank;
+  record->reserved = 0;
+
+  if (command == COMMAND_ACT0 || command == COMMAND_ACT1) {
+    record->address = request->row;
+  }
+  else if (command == COMMAND_PRE) {
+    record->address = 0;
+  }
+  else {
+    record->address = get_column(request);
   }
 
-  strcat(response, temp);
-  free(temp);
+  return true;
+}
 
-  return response;
+void arm_rank_timers(DRAM_t *dram, uint16_t cycles) {
+  if (cycles > dram->timers_running) {
+    dram->timers_running = cycles;
+  }
 }
 
-void set_tfaw_timer(DRAM_t *dram) {
+void set_tfaw_timer(DIMM_t *dimm, DRAM_t *dram) {
   for (int i = 0; i < NUM_TFAW_COUNTERS; i++) {
     if (dram->tFAW_timers[i] == 0) {
-      dram->tFAW_timers[i] = TFAW;
+      dram->tFAW_timers[i] = DIMM_TIMINGS(dimm)->tfaw;
+      arm_rank_timers(dram, DIMM_TIMINGS(dimm)->tfaw);
       break;  // only want to set one counter at a time
     }
   }
 }
 
-void set_timing_constraint(DRAM_t *dram, MemoryRequest_t *request, TimingConstraints_t constraint_type) {
-  dram->timing_constraints[request->bank_group][request->bank][constraint_type] = timing_attribute[constraint_type];
+void set_timing_constraint(DIMM_t *dimm, DRAM_t *dram, MemoryRequest_t *request, TimingConstraints_t constraint_type) {
+  dram->timing_constraints[request->bank_group][request->bank][constraint_type] = DIMM_TIMINGS(dimm)->constraints[constraint_type];
+  dram->armed[constraint_type] |= bank_bit(request);
+  arm_rank_timers(dram, DIMM_TIMINGS(dimm)->constraints[constraint_type]);
 }
 
-void set_consecutive_cmd_timers(DRAM_t *dram, ConsecutiveCmdConstraints_t constraint_type) {
-  dram->consecutive_cmd_timers[constraint_type] = consecutive_cmd_attribute[constraint_type];
+void set_burst_timer(DIMM_t *dimm, DRAM_t *dram, MemoryRequest_t *request) {
+  // BL32 holds the bank for twice as long as the BL16 default; a chopped burst keeps the BL16 slot
+  dram->timing_constraints[request->bank_group][request->bank][tBURST] = TBURST * DIMM_BURST_LENGTH(dimm) / BL16;
+  dram->armed[tBURST] |= bank_bit(request);
+  arm_rank_timers(dram, TBURST * DIMM_BURST_LENGTH(dimm) / BL16);
 }
 
-void set_trrd_timers(DRAM_t *dram) {
-  dram->consecutive_cmd_timers[tRRD_L] = consecutive_cmd_attribute[tRRD_L];
-  dram->consecutive_cmd_timers[tRRD_S] = consecutive_cmd_attribute[tRRD_S];
+void set_bank_timers(DRAM_t *dram, BankMask_t banks, TimingConstraints_t constraint_type, uint16_t cycles) {
+  for (BankMask_t remaining = banks; remaining != 0; remaining &= remaining - 1) {
+    int index = __builtin_ctz(remaining);
+    dram->timing_constraints[index / NUM_BANKS_PER_GROUP][index % NUM_BANKS_PER_GROUP][constraint_type] = cycles;
+  }
+  dram->armed[constraint_type] |= banks;
+  arm_rank_timers(dram, cycles);
 }
 
-void set_tccd_timers(DRAM_t *dram) {
-  dram->consecutive_cmd_timers[tCCD_L]     = consecutive_cmd_attribute[tCCD_L];
-  dram->consecutive_cmd_timers[tCCD_S]     = consecutive_cmd_attribute[tCCD_S];
-  dram->consecutive_cmd_timers[tCCD_L_WR]  = consecutive_cmd_attribute[tCCD_L_WR];
-  dram->consecutive_cmd_timers[tCCD_S_WR]  = consecutive_cmd_attribute[tCCD_S_WR];
-  dram->consecutive_cmd_timers[tCCD_L_RTW] = consecutive_cmd_attribute[tCCD_L_RTW];
-  dram->consecutive_cmd_timers[tCCD_S_RTW] = consecutive_cmd_attribute[tCCD_S_RTW];
-  dram->consecutive_cmd_timers[tCCD_L_WTR] = consecutive_cmd_attribute[tCCD_L_WTR];
-  dram->consecutive_cmd_timers[tCCD_S_WTR] = consecutive_cmd_attribute[tCCD_S_WTR];
+void record_command(DRAM_t *dram, Commands_t command, uint8_t bank_group, uint64_t now) {
+  dram->last_issue[command][bank_group] = now;
+  dram->last_issue_any[command] = now;
 }
 
 void decrement_tfaw_timers(DRAM_t *dram) {
@@ -140,38 +228,61 @@ void decrement_tfaw_timers(DRAM_t *dram) {
 }
 
 void decrement_timing_constraints(DRAM_t *dram) {
-  // TODO: need a table to keep track of active timers. 3 nested loop is too big of a hit on performance
-  // works for now
-  for (int i = 0; i < NUM_BANK_GROUPS; i++) {
-    for (int j = 0; j < NUM_BANKS_PER_GROUP; j++) {
-      for (int k = 0; k < NUM_TIMING_CONSTRAINTS; k++) {
-        if (dram->timing_constraints[i][j][k] != 0) {
-          dram->timing_constraints[i][j][k]--;
-        }
+  // only the armed timers are visited; a bank leaves the mask when its timer runs out
+  for (int k = 0; k < NUM_TIMING_CONSTRAINTS; k++) {
+    BankMask_t armed = dram->armed[k];
+    while (armed != 0) {
+      int index = __builtin_ctz(armed);
+      armed &= armed - 1;
+
+      uint16_t *timer = &dram->timing_constraints[index / NUM_BANKS_PER_GROUP][index % NUM_BANKS_PER_GROUP][k];
+      if (--(*timer) == 0) {
+        dram->armed[k] &= ~((BankMask_t)1 << index);
       }
     }
   }
 }
 
-void decrement_consecutive_cmd_timers(DRAM_t *dram) {
-  for (int i = 0; i < NUM_CONSECUTIVE_CMD_CONSTRAINTS; i++) {
-    if (dram->consecutive_cmd_timers[i] != 0) {
-      dram->consecutive_cmd_timers[i]--;
+void decrement_rank_timers(DIMM_t *dimm) {
+  for (int i = 0; i < NUM_CHANNELS; i++) {
+    dimm->channels[i].timing_cycle++;
+
+    for (int j = 0; j < DIMM_NUM_RANKS(dimm); j++) {
+      DRAM_t *dram = &(dimm->channels[i].ranks[j]);
+      if (dram->timers_running == 0) {
+        continue;
+      }
+
+      dram->timers_running--;
+      decrement_tfaw_timers(dram);
+      decrement_timing_constraints(dram);
     }
   }
 }
 
 bool is_timing_constraint_met(DRAM_t *dram, MemoryRequest_t *request, TimingConstraints_t constraint_type) {
-  bool result = dram->timing_constraints[request->bank_group][request->bank][constraint_type] == 0;
+  bool result = (dram->armed[constraint_type] & bank_bit(request)) == 0;
   return result;
 }
 
-bool is_trrd_met(DRAM_t *dram, ConsecutiveCmdConstraints_t constraint_type) {
-  return dram->consecutive_cmd_timers[constraint_type] == 0;
-}
+bool is_command_spacing_met(DIMM_t *dimm, DRAM_t *dram, Commands_t next, uint8_t bank_group, uint64_t now) {
+  // every earlier ACT/RD/WR counts, not just the most recent command
+  uint64_t ready = 0;
 
-bool is_tccds_met(DRAM_t *dram, ConsecutiveCmdConstraints_t constraint_type) {
-  return dram->consecutive_cmd_timers[constraint_type] == 0;
+  for (int previous = 0; previous < NUM_SPACED_COMMANDS; previous++) {
+    const uint16_t *spacing = DIMM_TIMINGS(dimm)->spacing[previous][next];
+    uint64_t same_group = dram->last_issue[previous][bank_group] + spacing[1];
+    uint64_t any_group = dram->last_issue_any[previous] + spacing[0];
+
+    if (same_group > ready) {
+      ready = same_group;
+    }
+    if (any_group > ready) {
+      ready = any_group;
+    }
+  }
+
+  return now >= ready;
 }
 
 bool can_issue_act(DRAM_t *dram) {
@@ -186,33 +297,267 @@ bool can_issue_act(DRAM_t *dram) {
   return false;
 }
 
-void check_requests_age(Queue_t *global_queue){
-  if (global_queue == NULL || global_queue->list == NULL) {
-    return; 
+bool is_first_half(MemoryRequestState_t state) {
+  return state == ACT0 || state == RD0 || state == WR0;
+}
+
+bool is_second_half(MemoryRequestState_t state) {
+  return state == ACT1 || state == RD1 || state == WR1;
+}
+
+bool command_bus_can_issue(CommandBus_t *bus, MemoryRequestState_t state) {
+  // ACT, RD and WR take two bus cycles; their second half has the bus reserved
+  if (is_first_half(state) || state == PRE) {
+    return bus->busy_timer == 0;
+  }
+
+  if (is_second_half(state)) {
+    return bus->second_half_timer == 0;
   }
 
-  int old_request_age =-1;
-  int young_request_age =-1;
-  for (int i = 0; i < global_queue->size; i++) {
-    MemoryRequest_t *request = queue_peek_at(global_queue, i);
-    if (request != NULL) {
-      if (request->aging >= TRC*8 && old_request_age == -1) {
-        old_request_age = i;
-      } 
-      else if (request->aging < TRC && young_request_age == -1) {
-        young_request_age = i;
+  return true;  // bank-internal transitions do not use the bus
+}
+
+void command_bus_issue(CommandBus_t *bus, MemoryRequestState_t state, CommandRate_t command_rate) {
+  if (is_first_half(state)) {
+    bus->busy_timer = 2 * command_rate;
+    bus->second_half_timer = command_rate;
+    bus->commands++;
+  }
+  else if (state == PRE) {
+    bus->busy_timer = command_rate;
+    bus->commands++;
+  }
+}
+
+bool is_column_command(MemoryRequestState_t state) {
+  return state == RD0 || state == WR0;
+}
+
+uint64_t burst_cycles(DIMM_t *dimm) {
+  return TBURST * DIMM_BURST_LENGTH(dimm) / BL16;
+}
+
+uint64_t burst_start(DIMM_t *dimm, MemoryRequest_t *request, uint64_t cycle) {
+  // data follows the second half of the column command by tCL (read) or tCWL (write)
+  uint64_t latency = DIMM_TIMINGS(dimm)->constraints[request->operation == DATA_WRITE ? tCWL : tCL];
+  return cycle + DIMM_COMMAND_RATE(dimm) + latency;
+}
+
+uint8_t rank_switch_gap(DIMM_t *dimm, uint8_t rank, uint8_t other_rank) {
+  if (rank == other_rank) {
+    return 0;
+  }
+
+  bool same_dimm = rank / dimm->ranks_per_dimm == other_rank / dimm->ranks_per_dimm;
+  return same_dimm ? TRTRS : TRTRS_DIMM;
+}
+
+bool data_bus_can_reserve(DIMM_t *dimm, MemoryRequest_t *request, uint64_t cycle) {
+  DataBus_t *bus = &(dimm->channels[request->channel].data_bus);
+  uint64_t start = burst_start(dimm, request, cycle);
+  uint64_t end = start + burst_cycles(dimm);
+
+  // bursts from another rank keep tRTRS clear on either side for the bus handover
+  for (int i = 0; i < DIMM_TIMINGS(dimm)->data_bus_reservations; i++) {
+    uint8_t gap = rank_switch_gap(dimm, request->rank, bus->reservation_rank[i]);
+    if (bus->reservation_end[i] > cycle && start < bus->reservation_end[i] + gap && bus->reservation_start[i] < end + gap) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void data_bus_reserve(DIMM_t *dimm, MemoryRequest_t *request, uint64_t cycle) {
+  DataBus_t *bus = &(dimm->channels[request->channel].data_bus);
+  uint64_t start = burst_start(dimm, request, cycle);
+  uint64_t slot = burst_cycles(dimm);
+  uint64_t transfer = DIMM_BURST_CHOP(dimm) ? slot / 2 : slot;
+
+  // reuse the first slot whose burst is over
+  int free_slot = -1;
+  for (int i = 0; i < DIMM_TIMINGS(dimm)->data_bus_reservations && free_slot < 0; i++) {
+    if (bus->reservation_end[i] <= cycle) {
+      free_slot = i;
+    }
+  }
+
+  // a burst left out would be invisible to data_bus_can_reserve() and overlapped by later ones
+  if (free_slot < 0) {
+    fprintf(stderr, "Error: more than %d bursts in flight on channel %d at DIMM cycle %" PRIu64 "\n",
+            DIMM_TIMINGS(dimm)->data_bus_reservations, request->channel, cycle);
+    exit(EXIT_FAILURE);
+  }
+
+  bus->reservation_start[free_slot] = start;
+  bus->reservation_end[free_slot] = start + slot;
+  bus->reservation_rank[free_slot] = request->rank;
+
+  if (bus->bursts != 0 && start > bus->last_burst_end) {
+    uint64_t gap = start - bus->last_burst_end;
+    bus->idle_gaps++;
+    bus->idle_gap_cycles += gap;
+    if (gap > bus->max_idle_gap) {
+      bus->max_idle_gap = gap;
+    }
+  }
+
+  if (start + transfer > bus->last_burst_end) {
+    bus->last_burst_end = start + transfer;
+  }
+
+  if (bus->bursts != 0 && request->rank != bus->last_burst_rank) {
+    bus->rank_switches++;
+  }
+  bus->last_burst_rank = request->rank;
+
+  bus->bursts++;
+  bus->busy_cycles += transfer;
+  bus->bytes += transfer * 2 * CHANNEL_WIDTH_BYTES;  // double data rate
+
+  if (dimm->timeline != NULL) {
+    timeline_burst(dimm->timeline, request, start, transfer);
+  }
+}
+
+void tick_command_buses(DIMM_t *dimm) {
+  for (int i = 0; i < NUM_CHANNELS; i++) {
+    CommandBus_t *bus = &(dimm->channels[i].command_bus);
+
+    bus->elapsed_cycles++;
+    if (bus->busy_timer != 0) {
+      bus->busy_cycles++;
+      bus->busy_timer--;
+    }
+
+    if (bus->second_half_timer != 0) {
+      bus->second_half_timer--;
+    }
+  }
+}
+
+void issue_mitigation_command(DIMM_t *dimm, uint8_t channel, uint8_t rank, CommandCode_t command, uint8_t bank_group, uint8_t bank,
+                              uint16_t address, uint64_t clock) {
+  CommandRecord_t cmd = {
+    .cycle = time_base_dimm_cycle(&dimm->time_base, clock),
+    .command = command,
+    .channel = channel,
+    .rank = rank,
+    .bank_group = bank_group,
+    .bank = bank,
+    .address = address,
+  };
+
+  output_command(&dimm->output, &cmd);
+  if (dimm->timeline != NULL) {
+    timeline_command(dimm->timeline, &cmd);
+  }
+
+  // PRE and RFM take one bus slot
+  command_bus_issue(&dimm->channels[channel].command_bus, PRE, DIMM_COMMAND_RATE(dimm));
+}
+
+void manage_row_hammer(DIMM_t *dimm, Queue_t *q, uint64_t clock) {
+  RowHammer_t *rowhammer = dimm->rowhammer;
+  uint64_t cycle = time_base_dimm_cycle(&dimm->time_base, clock);
+
+  rowhammer_refresh(rowhammer, cycle);
+
+  // the RFMs owed, and the PREs that clear their banks, go out ahead of the requests
+  for (int i = 0; i < NUM_CHANNELS; i++) {
+    CommandBus_t *bus = &(dimm->channels[i].command_bus);
+
+    for (int j = 0; j < DIMM_NUM_RANKS(dimm); j++) {
+      DRAM_t *dram = &(dimm->channels[i].ranks[j]);
+      uint8_t bank = 0;
+      bool forced = false;
+      RfmMode_t mode = rowhammer_due(rowhammer, i, j, cycle, &bank, &forced);
+
+      rowhammer->held[i][j] = 0;
+      if (mode == RFM_OFF) {
+        continue;
+      }
+
+      BankMask_t targets = rowhammer_targets(mode, bank);
+      if (forced) {
+        rowhammer->held[i][j] = targets;
+      }
+
+      // a request that has started on a bank finishes first; an early RFM waits for every request to its banks
+      BankMask_t in_use = 0;
+      for (uint8_t k = 0; k < q->size; k++) {
+        MemoryRequest_t *request = queue_peek_at(q, k);
+        if (request->channel == i && request->rank == j &&
+            (!forced || (request->state != PENDING && request->state != ACT0 && request->state != COMPLETE))) {
+          in_use |= bank_bit(request);
+        }
+      }
+      if ((targets & in_use) || bus->busy_timer != 0) {
+        continue;
+      }
+
+      BankMask_t open = targets & dram->open_banks;
+      if (open != 0) {
+        BankMask_t ready = open & ~dram->busy_banks & dram_ready_banks(dram, PRE);
+        if (ready != 0) {
+          int index = __builtin_ctz(ready);
+          dram->open_banks &= ~((BankMask_t)1 << index);
+          dram->precharged_banks |= (BankMask_t)1 << index;
+          set_bank_timers(dram, (BankMask_t)1 << index, tRP, DIMM_TIMINGS(dimm)->constraints[tRP]);
+          issue_mitigation_command(dimm, i, j, COMMAND_PRE, index / NUM_BANKS_PER_GROUP, index % NUM_BANKS_PER_GROUP, 0, clock);
+          rowhammer->precharges++;
+        }
+        continue;
       }
 
-      if (old_request_age != -1 && young_request_age != -1) {
-        break;
+      if (targets & (dram->armed[tRP] | dram->armed[tRFC])) {
+        continue;
       }
+
+      uint16_t duration = mode == RFM_ALL_BANK ? rowhammer->trfm_ab : rowhammer->trfm_sb;
+      set_bank_timers(dram, targets, tRFC, duration);
+      issue_mitigation_command(dimm, i, j, COMMAND_RFM, 0, mode == RFM_SAME_BANK ? bank : 0, mode == RFM_SAME_BANK, clock);
+      rowhammer->blocked_bank_cycles += (uint64_t)duration * __builtin_popcount(targets);
+      rowhammer_rfm(rowhammer, i, j, mode, bank, forced);
     }
   }
 
-  if (old_request_age != -1 && young_request_age != -1) {
-    queue_insert_at(&global_queue, young_request_age,queue_delete_at(&global_queue,old_request_age));
+  // requests that cannot start because of a drain or a running RFM
+  uint8_t waiting = 0;
+  for (uint8_t k = 0; k < q->size; k++) {
+    MemoryRequest_t *request = queue_peek_at(q, k);
+    DRAM_t *dram = &(dimm->channels[request->channel].ranks[request->rank]);
+    if ((request->state == PENDING || request->state == ACT0) &&
+        ((rowhammer->held[request->channel][request->rank] | dram->armed[tRFC]) & bank_bit(request))) {
+      waiting++;
+    }
+  }
+  rowhammer->waiting_cycles += waiting;
+  rowhammer->stalled_cycles += waiting == q->size;
+}
+
+void complete_request(DIMM_t *dimm, MemoryRequest_t *request, uint64_t clock) {
+  if (dimm->timeline != NULL) {
+    timeline_request(dimm->timeline, request, time_base_dimm_cycle(&dimm->time_base, request->time), time_base_dimm_cycle(&dimm->time_base, clock));
+  }
+  if (dimm->intervals != NULL) {
+    interval_stats_complete(dimm->intervals, request, time_base_dimm_cycle(&dimm->time_base, clock), clock - request->time);
   }
 
+  // prefetched data goes to the prefetch buffer, no core is waiting for it
+  if (request->is_prefetch) {
+    prefetcher_fill(dimm->prefetcher, request);
+    return;
+  }
+
+  stats_record_completion(&dimm->stats, request, clock);
+  if (dimm->cores != NULL) {
+    core_model_complete(dimm->cores, request, clock);
+  }
+  if (dimm->scheduler->on_complete != NULL) {
+    dimm->scheduler->on_complete(dimm, request, clock);
+  }
 }
 
 void increment_aging_in_queue(Queue_t *global_queue) {
@@ -229,22 +574,46 @@ void increment_aging_in_queue(Queue_t *global_queue) {
 }
 
 bool closed_page(DIMM_t **dimm, MemoryRequest_t *request, uint64_t clock) {
-  DRAM_t *dram = &((*dimm)->channels[request->channel].DDR5_chip[0]);
-  char *cmd = NULL;
+  DRAM_t *dram = &((*dimm)->channels[request->channel].ranks[request->rank]);
+  CommandRecord_t cmd;
+  bool has_cmd = false;
   bool cmd_is_issued = false;
 
   if (request->state == PENDING) {
     request->state = ACT0;
   }
 
+  // no new row is opened on a bank that is being drained for an RFM
+  if (request->state == ACT0 && is_bank_held(*dimm, request)) {
+    return cmd_is_issued;
+  }
+
+  // the command bus carries one command at a time
+  CommandBus_t *bus = &((*dimm)->channels[request->channel].command_bus);
+  MemoryRequestState_t issued_state = request->state;
+  if (!command_bus_can_issue(bus, issued_state)) {
+    return cmd_is_issued;
+  }
+
+  // and the data bus one burst at a time
+  if (is_column_command(issued_state) && !data_bus_can_reserve(*dimm, request, time_base_dimm_cycle(&(*dimm)->time_base, clock))) {
+    return cmd_is_issued;
+  }
+
+  // and never ahead of an older conflicting access to the same line
+  if (is_column_command(issued_state) && hazard_hold(&(*dimm)->hazards, request)) {
+    return cmd_is_issued;
+  }
+
   // Process the request (one state per cycle)
   switch (request->state) {
     case ACT0:
       if (
         is_timing_constraint_met(dram, request, tRC) &&
-        is_timing_constraint_met(dram, request, tRP)
+        is_timing_constraint_met(dram, request, tRP) &&
+        is_timing_constraint_met(dram, request, tRFC)
       ) {
-        cmd = issue_cmd("ACT0", request, clock);
+        has_cmd = issue_cmd(*dimm, &cmd, COMMAND_ACT0, request, clock);
         request->state = ACT1;
       }
       break;
@@ -252,11 +621,11 @@ bool closed_page(DIMM_t **dimm, MemoryRequest_t *request, uint64_t clock) {
     case ACT1:
       activate_bank(dram, request);
 
-      cmd = issue_cmd("ACT1", request, clock);
+      has_cmd = issue_cmd(*dimm, &cmd, COMMAND_ACT1, request, clock);
 
-      set_timing_constraint(dram, request, tRCD);
-      set_timing_constraint(dram, request, tRAS);
-      set_timing_constraint(dram, request, tRC);
+      set_timing_constraint(*dimm, dram, request, tRCD);
+      set_timing_constraint(*dimm, dram, request, tRAS);
+      set_timing_constraint(*dimm, dram, request, tRC);
 
       // next state
       if (request->operation == DATA_WRITE) {
@@ -270,19 +639,19 @@ bool closed_page(DIMM_t **dimm, MemoryRequest_t *request, uint64_t clock) {
 
     case RD0:
       if (is_timing_constraint_met(dram, request, tRCD)) {
-        cmd = issue_cmd(request->operation == DATA_WRITE ? "WR0" : "RD0", request, clock);
+        has_cmd = issue_cmd(*dimm, &cmd, request->operation == DATA_WRITE ? COMMAND_WR0 : COMMAND_RD0, request, clock);
         request->state = RD1;
       }
       break;
 
     case RD1:
       // issue cmd
-      cmd = issue_cmd(request->operation == DATA_WRITE ? "WR1" : "RD1", request, clock);
+      has_cmd = issue_cmd(*dimm, &cmd, request->operation == DATA_WRITE ? COMMAND_WR1 : COMMAND_RD1, request, clock);
       
 
       // set timers
-      set_timing_constraint(dram, request, tCL);
-      set_timing_constraint(dram, request, tRTP);
+      set_timing_constraint(*dimm, dram, request, tCL);
+      set_timing_constraint(*dimm, dram, request, tRTP);
 
       // nest state
       request->state = PRE;
@@ -290,17 +659,17 @@ bool closed_page(DIMM_t **dimm, MemoryRequest_t *request, uint64_t clock) {
 
     case WR0:
       if (is_timing_constraint_met(dram, request, tRCD)) {
-        cmd = issue_cmd(request->operation == DATA_WRITE ? "WR0" : "RD0", request, clock);
+        has_cmd = issue_cmd(*dimm, &cmd, request->operation == DATA_WRITE ? COMMAND_WR0 : COMMAND_RD0, request, clock);
         request->state = WR1;
       }
       break;
 
     case WR1:
       // issue cmd
-      cmd = issue_cmd(request->operation == DATA_WRITE ? "WR1" : "RD1", request, clock);
+      has_cmd = issue_cmd(*dimm, &cmd, request->operation == DATA_WRITE ? COMMAND_WR1 : COMMAND_RD1, request, clock);
 
       // set timers
-      set_timing_constraint(dram, request, tCWL);
+      set_timing_constraint(*dimm, dram, request, tCWL);
 
       // nest state
       request->state = BUFFER;
@@ -312,10 +681,10 @@ bool closed_page(DIMM_t **dimm, MemoryRequest_t *request, uint64_t clock) {
         if (is_timing_constraint_met(dram, request, tWR) && is_timing_constraint_met(dram, request, tRAS)) {
           precharge_bank(dram, request);
 
-          cmd = issue_cmd("PRE", request, clock);
+          has_cmd = issue_cmd(*dimm, &cmd, COMMAND_PRE, request, clock);
           request->is_finished = true;
 
-          set_timing_constraint(dram, request, tRP);
+          set_timing_constraint(*dimm, dram, request, tRP);
 
           request->state = COMPLETE;
         }
@@ -324,10 +693,10 @@ bool closed_page(DIMM_t **dimm, MemoryRequest_t *request, uint64_t clock) {
         if (is_timing_constraint_met(dram, request, tRTP) && is_timing_constraint_met(dram, request, tRAS)) {
           precharge_bank(dram, request);
 
-          cmd = issue_cmd("PRE", request, clock);
+          has_cmd = issue_cmd(*dimm, &cmd, COMMAND_PRE, request, clock);
           request->is_finished = true;
 
-          set_timing_constraint(dram, request, tRP);
+          set_timing_constraint(*dimm, dram, request, tRP);
 
           request->state = BUFFER;
         }
@@ -339,14 +708,14 @@ bool closed_page(DIMM_t **dimm, MemoryRequest_t *request, uint64_t clock) {
       // data is being stored in buffer while tCL is set
       if (request->operation == DATA_WRITE) {
         if (is_timing_constraint_met(dram, request, tCWL)) {
-          set_timing_constraint(dram, request, tBURST);
+          set_burst_timer(*dimm, dram, request);
           request->state = BURST;
         }
         
       }
       else {
         if (is_timing_constraint_met(dram, request, tCL)) {
-          set_timing_constraint(dram, request, tBURST);
+          set_burst_timer(*dimm, dram, request);
           request->state = BURST;
         }
       }
@@ -355,7 +724,7 @@ bool closed_page(DIMM_t **dimm, MemoryRequest_t *request, uint64_t clock) {
     case BURST:
       if (is_timing_constraint_met(dram, request, tBURST)) {
         if (request->operation == DATA_WRITE) {
-          set_timing_constraint(dram, request, tWR);
+          set_timing_constraint(*dimm, dram, request, tWR);
           request->state = PRE;
         }
         else {
@@ -374,21 +743,52 @@ bool closed_page(DIMM_t **dimm, MemoryRequest_t *request, uint64_t clock) {
       exit(EXIT_FAILURE);
   }
 
-  // writing commands to output file
-  if (cmd != NULL) {
-    fprintf((*dimm)->output_file, "%s\n", cmd);
-    free(cmd);
+  // handing the command to the output sinks
+  if (has_cmd) {
+    output_command(&(*dimm)->output, &cmd);
+    if ((*dimm)->timeline != NULL) {
+      timeline_command((*dimm)->timeline, &cmd);
+    }
+    if ((*dimm)->intervals != NULL) {
+      interval_stats_command((*dimm)->intervals, request, cmd.command);
+    }
+    if ((*dimm)->hot_rows != NULL && cmd.command == COMMAND_ACT1) {
+      hot_rows_activate((*dimm)->hot_rows, request, time_base_dimm_cycle(&(*dimm)->time_base, clock));
+    }
+    if ((*dimm)->rowhammer != NULL && cmd.command == COMMAND_ACT1) {
+      rowhammer_activate((*dimm)->rowhammer, request, time_base_dimm_cycle(&(*dimm)->time_base, clock));
+    }
+    command_bus_issue(bus, issued_state, DIMM_COMMAND_RATE(*dimm));
+    if (is_column_command(issued_state)) {
+      data_bus_reserve(*dimm, request, time_base_dimm_cycle(&(*dimm)->time_base, clock));
+      hazard_release(&(*dimm)->hazards, request);
+    }
     cmd_is_issued = true;
+    if ((*dimm)->scheduler->on_issue != NULL) {
+      (*dimm)->scheduler->on_issue(*dimm, request, issued_state, clock);
+    }
   }
 
   return cmd_is_issued;
 }
 
 bool open_page(DIMM_t **dimm, MemoryRequest_t *request, uint64_t cycle) {
-  DRAM_t *dram = &((*dimm)->channels[request->channel].DDR5_chip[0]);
-  char *cmd = NULL;
+  DRAM_t *dram = &((*dimm)->channels[request->channel].ranks[request->rank]);
+  uint64_t now = (*dimm)->channels[request->channel].timing_cycle;
+  CommandRecord_t cmd;
+  bool has_cmd = false;
   bool cmd_is_issued = false;
 
+  // the bank may have changed since the request chose its first command, another request opened or closed it
+  if ((request->state == PRE && !is_page_miss(dram, request)) || (request->state == ACT0 && !is_page_empty(dram, request))) {
+    request->state = PENDING;
+  }
+
+  // no new request starts on a bank that is being drained for an RFM
+  if ((request->state == PENDING || request->state == ACT0) && is_bank_held(*dimm, request)) {
+    return cmd_is_issued;
+  }
+
   // Set the initial state before processing the request
   if (request->state == PENDING) {
     if (is_page_hit(dram, request)) {
@@ -398,7 +798,8 @@ bool open_page(DIMM_t **dimm, MemoryRequest_t *request, uint64_t cycle) {
       else {
         request->state = RD0;
       }
-      dram->bank_groups[request->bank_group].banks[request->bank].last_request_operation = request->operation;
+      set_last_operation(dram, request);
+      pin_row(dram, request, true);
     }
     else if (is_page_miss(dram, request)) {
       request->state = PRE;
@@ -409,7 +810,7 @@ bool open_page(DIMM_t **dimm, MemoryRequest_t *request, uint64_t cycle) {
       }
 
       request->state = ACT0;
-      dram->bank_groups[request->bank_group].banks[request->bank].last_request_operation = request->operation;
+      set_last_operation(dram, request);
     }
     else {
       fprintf(stderr, "Error: Unknown page state encountered\n");
@@ -417,10 +818,32 @@ bool open_page(DIMM_t **dimm, MemoryRequest_t *request, uint64_t cycle) {
     }
   }
 
+  // a row is closed only once the requests that chose it have issued their RD/WR
+  if (request->state == PRE && dram->pins[request->bank_group][request->bank] > 0) {
+    return cmd_is_issued;
+  }
+
+  // the command bus carries one command at a time
+  CommandBus_t *bus = &((*dimm)->channels[request->channel].command_bus);
+  MemoryRequestState_t issued_state = request->state;
+  if (!command_bus_can_issue(bus, issued_state)) {
+    return cmd_is_issued;
+  }
+
+  // and the data bus one burst at a time
+  if (is_column_command(issued_state) && !data_bus_can_reserve(*dimm, request, time_base_dimm_cycle(&(*dimm)->time_base, cycle))) {
+    return cmd_is_issued;
+  }
+
+  // and never ahead of an older conflicting access to the same line
+  if (is_column_command(issued_state) && hazard_hold(&(*dimm)->hazards, request)) {
+    return cmd_is_issued;
+  }
+
   // Process the request (one state per cycle)
   switch (request->state) {
     case PRE:
-      if (dram->bank_groups[request->bank_group].banks[request->bank].last_request_operation == DATA_WRITE) {
+      if (dram->write_banks & bank_bit(request)) {
         if (
           is_timing_constraint_met(dram, request, tRAS) &&
           is_timing_constraint_met(dram, request, tCWL) &&
@@ -431,13 +854,11 @@ bool open_page(DIMM_t **dimm, MemoryRequest_t *request, uint64_t cycle) {
           precharge_bank(dram, request);
 
           // issue cmd
-          cmd = issue_cmd("PRE", request, cycle);
-          dram->last_interface_cmd = PRECHARGE;
-          dram->last_bank_group = request->bank_group;
-          dram->bank_groups[request->bank_group].banks[request->bank].in_progress = true;
+          has_cmd = issue_cmd(*dimm, &cmd, COMMAND_PRE, request, cycle);
+          set_bank_busy(dram, request, true);
 
           // set timers
-          set_timing_constraint(dram, request, tRP);
+          set_timing_constraint(*dimm, dram, request, tRP);
 
           // next state
           request->state = ACT0;
@@ -452,13 +873,11 @@ bool open_page(DIMM_t **dimm, MemoryRequest_t *request, uint64_t cycle) {
           precharge_bank(dram, request);
 
           // issue cmd
-          cmd = issue_cmd("PRE", request, cycle);
-          dram->last_interface_cmd = PRECHARGE;
-          dram->last_bank_group = request->bank_group;
-          dram->bank_groups[request->bank_group].banks[request->bank].in_progress = true;
+          has_cmd = issue_cmd(*dimm, &cmd, COMMAND_PRE, request, cycle);
+          set_bank_busy(dram, request, true);
 
           // set timers
-          set_timing_constraint(dram, request, tRP);
+          set_timing_constraint(*dimm, dram, request, tRP);
 
           // next state
           request->state = ACT0;
@@ -472,39 +891,15 @@ bool open_page(DIMM_t **dimm, MemoryRequest_t *request, uint64_t cycle) {
         return cmd_is_issued;
       }
 
-      if (dram->last_interface_cmd == ACTIVATE) {
-        if (dram->last_bank_group == request->bank_group) {
-          if (
-            is_timing_constraint_met(dram, request, tRC) &&
-            is_timing_constraint_met(dram, request, tRP) &&
-            is_trrd_met(dram, tRRD_L)
-          ) {
-            cmd = issue_cmd("ACT0", request, cycle);
-            request->state = ACT1;
-            dram->bank_groups[request->bank_group].banks[request->bank].in_progress = true;
-          }
-        }
-        else {
-          if (
-            is_timing_constraint_met(dram, request, tRC) &&
-            is_timing_constraint_met(dram, request, tRP) &&
-            is_trrd_met(dram, tRRD_S)
-          ) {
-            cmd = issue_cmd("ACT0", request, cycle);
-            request->state = ACT1;
-            dram->bank_groups[request->bank_group].banks[request->bank].in_progress = true;
-          }
-        }
-      }
-      else {
-        if (
-          is_timing_constraint_met(dram, request, tRC) &&
-          is_timing_constraint_met(dram, request, tRP)
-        ) {
-          cmd = issue_cmd("ACT0", request, cycle);
-          request->state = ACT1;
-          dram->bank_groups[request->bank_group].banks[request->bank].in_progress = true;
-        }
+      if (
+        is_timing_constraint_met(dram, request, tRC) &&
+        is_timing_constraint_met(dram, request, tRP) &&
+        is_timing_constraint_met(dram, request, tRFC) &&
+        is_command_spacing_met(*dimm, dram, ACTIVATE, request->bank_group, now)
+      ) {
+        has_cmd = issue_cmd(*dimm, &cmd, COMMAND_ACT0, request, cycle);
+        request->state = ACT1;
+        set_bank_busy(dram, request, true);
       }
 
       break;
@@ -513,16 +908,14 @@ bool open_page(DIMM_t **dimm, MemoryRequest_t *request, uint64_t cycle) {
       activate_bank(dram, request);
 
       // issue cmd
-      cmd = issue_cmd("ACT1", request, cycle);
-      dram->last_interface_cmd = ACTIVATE;
-      dram->last_bank_group = request->bank_group;
+      has_cmd = issue_cmd(*dimm, &cmd, COMMAND_ACT1, request, cycle);
 
       // set timers
-      set_timing_constraint(dram, request, tRCD);
-      set_timing_constraint(dram, request, tRAS);
-      set_timing_constraint(dram, request, tRC);
-      set_trrd_timers(dram);
-      set_tfaw_timer(dram);
+      set_timing_constraint(*dimm, dram, request, tRCD);
+      set_timing_constraint(*dimm, dram, request, tRAS);
+      set_timing_constraint(*dimm, dram, request, tRC);
+      record_command(dram, ACTIVATE, request->bank_group, now);
+      set_tfaw_timer(*dimm, dram);
 
       // next state
       if (request->operation == DATA_WRITE) {
@@ -531,146 +924,54 @@ bool open_page(DIMM_t **dimm, MemoryRequest_t *request, uint64_t cycle) {
       else {
         request->state = RD0;
       }
+      pin_row(dram, request, true);
 
       break;
 
     case RD0:
-      if (dram->last_interface_cmd == WRITE) {
-        if (dram->last_bank_group == request->bank_group) {
-          if (
-            is_timing_constraint_met(dram, request, tRCD) &&
-            is_tccds_met(dram, tCCD_L_WTR)
-          ) {
-            cmd = issue_cmd(request->operation == DATA_WRITE ? "WR0" : "RD0", request, cycle);
-            request->state = RD1;
-            dram->bank_groups[request->bank_group].banks[request->bank].in_progress = true;
-          }
-        }
-        else {
-          
-          if (
-            is_timing_constraint_met(dram, request, tRCD) &&
-            is_tccds_met(dram, tCCD_S_WTR)
-          ) {
-            cmd = issue_cmd(request->operation == DATA_WRITE ? "WR0" : "RD0", request, cycle);
-            request->state = RD1;
-            dram->bank_groups[request->bank_group].banks[request->bank].in_progress = true;
-          }
-        }
-
-      }
-      else if (dram->last_interface_cmd == READ) {
-        if (dram->last_bank_group == request->bank_group) {
-          if (
-            is_timing_constraint_met(dram, request, tRCD) &&
-            is_tccds_met(dram, tCCD_L)
-          ) {
-            cmd = issue_cmd(request->operation == DATA_WRITE ? "WR0" : "RD0", request, cycle);
-            request->state = RD1;
-            dram->bank_groups[request->bank_group].banks[request->bank].in_progress = true;
-          }
-        }
-        else {
-          if (
-            is_timing_constraint_met(dram, request, tRCD) &&
-            is_tccds_met(dram, tCCD_S)
-          ) {
-            cmd = issue_cmd(request->operation == DATA_WRITE ? "WR0" : "RD0", request, cycle);
-            request->state = RD1;
-            dram->bank_groups[request->bank_group].banks[request->bank].in_progress = true;
-          }
-        }
-      }
-      else {
-        if (is_timing_constraint_met(dram, request, tRCD)) {
-          cmd = issue_cmd(request->operation == DATA_WRITE ? "WR0" : "RD0", request, cycle);
-          request->state = RD1;
-          dram->bank_groups[request->bank_group].banks[request->bank].in_progress = true;
-        }
+      if (
+        is_timing_constraint_met(dram, request, tRCD) &&
+        is_command_spacing_met(*dimm, dram, READ, request->bank_group, now)
+      ) {
+        has_cmd = issue_cmd(*dimm, &cmd, request->operation == DATA_WRITE ? COMMAND_WR0 : COMMAND_RD0, request, cycle);
+        request->state = RD1;
+        set_bank_busy(dram, request, true);
       }
-
       break;
 
     case RD1:
       // issue cmd
-      cmd = issue_cmd(request->operation == DATA_WRITE ? "WR1" : "RD1", request, cycle);
+      has_cmd = issue_cmd(*dimm, &cmd, request->operation == DATA_WRITE ? COMMAND_WR1 : COMMAND_RD1, request, cycle);
       request->is_finished = true;
-      dram->last_interface_cmd = READ;
-      dram->last_bank_group = request->bank_group;
 
       // set timers
-      set_timing_constraint(dram, request, tCL);
-      set_timing_constraint(dram, request, tRTP);
-      set_tccd_timers(dram);
+      set_timing_constraint(*dimm, dram, request, tCL);
+      set_timing_constraint(*dimm, dram, request, tRTP);
+      record_command(dram, READ, request->bank_group, now);
 
       // nest state
       request->state = BUFFER;
       break;
 
     case WR0:
-      if (dram->last_interface_cmd == WRITE) {
-        if (dram->last_bank_group == request->bank_group) {
-          if (
-            is_timing_constraint_met(dram, request, tRCD) &&
-            is_tccds_met(dram, tCCD_L_WR)
-          ) {
-            cmd = issue_cmd(request->operation == DATA_WRITE ? "WR0" : "RD0", request, cycle);
-            request->state = WR1;
-            dram->bank_groups[request->bank_group].banks[request->bank].in_progress = true;
-          }
-        }
-        else {
-          if (
-            is_timing_constraint_met(dram, request, tRCD) &&
-            is_tccds_met(dram, tCCD_S_WR)
-          ) {
-            cmd = issue_cmd(request->operation == DATA_WRITE ? "WR0" : "RD0", request, cycle);
-            request->state = WR1;
-            dram->bank_groups[request->bank_group].banks[request->bank].in_progress = true;
-          }
-        }
-      }
-      else if (dram->last_interface_cmd == READ) {
-        if (dram->last_bank_group == request->bank_group) {
-          if (
-            is_timing_constraint_met(dram, request, tRCD) &&
-            is_tccds_met(dram, tCCD_L_RTW)
-          ) {
-            cmd = issue_cmd(request->operation == DATA_WRITE ? "WR0" : "RD0", request, cycle);
-            request->state = WR1;
-            dram->bank_groups[request->bank_group].banks[request->bank].in_progress = true;
-          }
-        }
-        else {
-          if (
-            is_timing_constraint_met(dram, request, tRCD) &&
-            is_tccds_met(dram, tCCD_S_RTW)
-          ) {
-            cmd = issue_cmd(request->operation == DATA_WRITE ? "WR0" : "RD0", request, cycle);
-            request->state = WR1;
-            dram->bank_groups[request->bank_group].banks[request->bank].in_progress = true;
-          }
-        }
-      }
-      else {
-        if (is_timing_constraint_met(dram, request, tRCD)) {
-          cmd = issue_cmd(request->operation == DATA_WRITE ? "WR0" : "RD0", request, cycle);
-          request->state = WR1;
-          dram->bank_groups[request->bank_group].banks[request->bank].in_progress = true;
-        }
+      if (
+        is_timing_constraint_met(dram, request, tRCD) &&
+        is_command_spacing_met(*dimm, dram, WRITE, request->bank_group, now)
+      ) {
+        has_cmd = issue_cmd(*dimm, &cmd, request->operation == DATA_WRITE ? COMMAND_WR0 : COMMAND_RD0, request, cycle);
+        request->state = WR1;
+        set_bank_busy(dram, request, true);
       }
       break;
 
     case WR1:
       // issue cmd
-      cmd = issue_cmd(request->operation == DATA_WRITE ? "WR1" : "RD1", request, cycle);
+      has_cmd = issue_cmd(*dimm, &cmd, request->operation == DATA_WRITE ? COMMAND_WR1 : COMMAND_RD1, request, cycle);
       request->is_finished = true;
-      dram->last_interface_cmd = WRITE;
-      dram->last_bank_group = request->bank_group;
 
       // set timers
-      set_timing_constraint(dram, request, tCWL);
-      set_tccd_timers(dram);
+      set_timing_constraint(*dimm, dram, request, tCWL);
+      record_command(dram, WRITE, request->bank_group, now);
 
       // nest state
       request->state = BUFFER;
@@ -679,14 +980,14 @@ bool open_page(DIMM_t **dimm, MemoryRequest_t *request, uint64_t cycle) {
     case BUFFER:
       if (request->operation == DATA_WRITE) {
         if (is_timing_constraint_met(dram, request, tCWL)) {
-          set_timing_constraint(dram, request, tBURST);
+          set_burst_timer(*dimm, dram, request);
           request->state = BURST;
         }
         
       }
       else {
         if (is_timing_constraint_met(dram, request, tCL)) {
-          set_timing_constraint(dram, request, tBURST);
+          set_burst_timer(*dimm, dram, request);
           request->state = BURST;
         }
       }
@@ -695,10 +996,10 @@ bool open_page(DIMM_t **dimm, MemoryRequest_t *request, uint64_t cycle) {
     case BURST:
       if (is_timing_constraint_met(dram, request, tBURST)) {
         if (request->operation == DATA_WRITE) {
-          set_timing_constraint(dram, request, tWR);
+          set_timing_constraint(*dimm, dram, request, tWR);
         }
         request->state = COMPLETE;
-        dram->bank_groups[request->bank_group].banks[request->bank].in_progress = false;
+        set_bank_busy(dram, request, false);
       }
       break;
 
@@ -711,197 +1012,339 @@ bool open_page(DIMM_t **dimm, MemoryRequest_t *request, uint64_t cycle) {
       exit(EXIT_FAILURE);
   }
 
-  // writing commands to output file
-  if (cmd != NULL) {
-    fprintf((*dimm)->output_file, "%s\n", cmd);
-    free(cmd);
+  // handing the command to the output sinks
+  if (has_cmd) {
+    output_command(&(*dimm)->output, &cmd);
+    if ((*dimm)->timeline != NULL) {
+      timeline_command((*dimm)->timeline, &cmd);
+    }
+    if ((*dimm)->intervals != NULL) {
+      interval_stats_command((*dimm)->intervals, request, cmd.command);
+    }
+    if ((*dimm)->hot_rows != NULL && cmd.command == COMMAND_ACT1) {
+      hot_rows_activate((*dimm)->hot_rows, request, time_base_dimm_cycle(&(*dimm)->time_base, cycle));
+    }
+    if ((*dimm)->rowhammer != NULL && cmd.command == COMMAND_ACT1) {
+      rowhammer_activate((*dimm)->rowhammer, request, time_base_dimm_cycle(&(*dimm)->time_base, cycle));
+    }
+    command_bus_issue(bus, issued_state, DIMM_COMMAND_RATE(*dimm));
+    if (is_column_command(issued_state)) {
+      data_bus_reserve(*dimm, request, time_base_dimm_cycle(&(*dimm)->time_base, cycle));
+      hazard_release(&(*dimm)->hazards, request);
+      pin_row(dram, request, false);
+    }
     cmd_is_issued = true;
+    if ((*dimm)->scheduler->on_issue != NULL) {
+      (*dimm)->scheduler->on_issue(*dimm, request, issued_state, cycle);
+    }
   }
 
   return cmd_is_issued;
 }
 
-void level_zero_algorithm(DIMM_t **dimm, Queue_t **q, uint64_t clock) {
-  MemoryRequest_t *request = queue_peek(*q);
-  DRAM_t *dram = &((*dimm)->channels[request->channel].DDR5_chip[0]);
+void dram_init(DRAM_t *dram) {
+  // Initialize the DRAM with all banks precharged
+  for (int i = 0; i < NUM_BANK_GROUPS; i++) {
+    for (int j = 0; j < NUM_BANKS_PER_GROUP; j++) {
+      dram->bank_groups[i].banks[j].active_row = 0;
 
-  if ((*q)->size > 1) {  
-    MemoryRequest_t *next_request = queue_peek_at(*q, 1);
-    if (!request->is_finished) {
-      closed_page(dimm, request, clock);
-    }
-    else {
-      closed_page(dimm, request, clock);
-      closed_page(dimm, next_request, clock);
+      // zero out bank timers
+      for (int k = 0; k < NUM_TIMING_CONSTRAINTS; k++) {
+        dram->timing_constraints[i][j][k] = 0;
+      }
     }
   }
-  else {
-    if (request->state != COMPLETE) {
-      closed_page(dimm, request, clock);
+
+  dram->open_banks = 0;
+  dram->precharged_banks = (BankMask_t)~0;
+  dram->busy_banks = 0;
+  dram->write_banks = 0;
+  memset(dram->pins, 0, sizeof(dram->pins));
+  memset(dram->armed, 0, sizeof(dram->armed));
+
+  // no ACT/RD/WR issued yet
+  memset(dram->last_issue, 0, sizeof(dram->last_issue));
+  memset(dram->last_issue_any, 0, sizeof(dram->last_issue_any));
+
+  // zero out tfaw timers
+  for (int i = 0; i < NUM_TFAW_COUNTERS; i++) {
+    dram->tFAW_timers[i] = 0;
+  }
+  dram->timers_running = 0;
+}
+
+/*** function(s) ***/
+void dimm_create(DIMM_t **dimm) {
+  *dimm = malloc(sizeof(DIMM_t));
+
+  if (*dimm == NULL) {
+    fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  // no sinks yet; the caller adds them once the ranks are known
+  output_init(&(*dimm)->output, 1);
+
+  for (int i = 0; i < NUM_CHANNELS; i++) {
+    for (int j = 0; j < MAX_RANKS_PER_CHANNEL; j++) {
+      dram_init(&((*dimm)->channels[i].ranks[j]));
     }
   }
 
-  if (request && request->state == COMPLETE) {
-    log_memory_request("Dequeued:", request, clock);
-    dequeue(q);
+  for (int i = 0; i < NUM_CHANNELS; i++) {
+    memset(&((*dimm)->channels[i].command_bus), 0, sizeof(CommandBus_t));
+    memset(&((*dimm)->channels[i].data_bus), 0, sizeof(DataBus_t));
+    (*dimm)->channels[i].timing_cycle = TIMING_CYCLE_ORIGIN;
   }
 
-  decrement_timing_constraints(dram);
+  stats_init(&(*dimm)->stats);
+  hazard_init(&(*dimm)->hazards);
+  (*dimm)->command_rate = COMMAND_RATE_1N;
+  (*dimm)->burst_length = BL16;
+  (*dimm)->burst_chop = false;
+  (*dimm)->dimms_per_channel = 1;
+  (*dimm)->ranks_per_dimm = 1;
+  (*dimm)->num_ranks = 1;
+  time_base_init(&(*dimm)->time_base, DEFAULT_CPU_MHZ, DEFAULT_DATA_RATE);
+  (*dimm)->scheduler = scheduler_get(LEVEL_0);
+  (*dimm)->prefetcher = NULL;
+  (*dimm)->cores = NULL;
+  (*dimm)->timeline = NULL;
+  (*dimm)->intervals = NULL;
+  (*dimm)->hot_rows = NULL;
+  (*dimm)->rowhammer = NULL;
+  (*dimm)->dueling = NULL;
 }
 
-void level_one_algorithm(DIMM_t **dimm, Queue_t **q, uint64_t clock) {
-  MemoryRequest_t *request = queue_peek(*q);
-  DRAM_t *dram = &((*dimm)->channels[request->channel].DDR5_chip[0]);
+void dimm_set_ranks(DIMM_t *dimm, uint8_t dimms_per_channel, uint8_t ranks_per_dimm) {
+  dimm->dimms_per_channel = dimms_per_channel;
+  dimm->ranks_per_dimm = ranks_per_dimm;
+  dimm->num_ranks = dimms_per_channel * ranks_per_dimm;
+  dimm->output.num_ranks = dimm->num_ranks;
+}
 
-  // if current request is not finish, finish it
-  if (!request->is_finished) {
-    open_page(dimm, request, clock);
+void dimm_set_time_base(DIMM_t *dimm, uint32_t cpu_mhz, uint32_t data_rate) {
+  if (!time_base_init(&dimm->time_base, cpu_mhz, data_rate)) {
+    fprintf(stderr, "Error: a %u MHz CPU clock is slower than the DDR5-%u command clock\n", cpu_mhz, data_rate);
+    exit(EXIT_FAILURE);
   }
-  // else if current request is finish, start next request
-  else {
-    for (int i = 0; i < (*q)->size; i++) {
-      MemoryRequest_t *next_request = queue_peek_at(*q, i);
-      open_page(dimm, next_request, clock);
 
-      if (!next_request->is_finished) {
-        break;
+  // the timers count DIMM cycles, so the constraints follow the data rate
+  Timings_t *timings = &dimm->timings;
+  bool fits = true;
+
+  for (int i = 0; i < NUM_TIMING_CONSTRAINTS; i++) {
+    uint64_t cycles = time_base_ps_to_dimm(&dimm->time_base, timing_ps[i]);
+    timings->constraints[i] = cycles;
+    fits = fits && cycles <= UINT16_MAX;
+  }
+  timings->constraints[tBURST] = TBURST;
+
+  // the spacing has to stay below the first timing cycle
+  for (int previous = 0; previous < NUM_SPACED_COMMANDS; previous++) {
+    for (int next = 0; next < NUM_SPACED_COMMANDS; next++) {
+      for (int k = 0; k < 2; k++) {
+        uint64_t cycles = time_base_ps_to_dimm(&dimm->time_base, spacing_ps[previous][next][k]);
+        if (cycles < spacing_clocks[previous][next][k]) {
+          cycles = spacing_clocks[previous][next][k];
+        }
+        timings->spacing[previous][next][k] = cycles;
+        fits = fits && cycles < TIMING_CYCLE_ORIGIN;
       }
     }
   }
 
-  // if current request is ready to be dequeue, delete it
-  if (request && request->state == COMPLETE) {
-    log_memory_request("Dequeued:", request, clock);
-    dequeue(q);
+  uint64_t tfaw = time_base_ps_to_dimm(&dimm->time_base, TFAW_PS);
+  timings->tfaw = tfaw < TFAW ? TFAW : tfaw;
+  fits = fits && tfaw <= UINT8_MAX;
+
+  uint64_t latency = timings->constraints[tCL] > timings->constraints[tCWL] ? timings->constraints[tCL] : timings->constraints[tCWL];
+  uint64_t reservations = DATA_BUS_RESERVATIONS(latency);
+  timings->data_bus_reservations = reservations;
+  fits = fits && reservations <= MAX_DATA_BUS_RESERVATIONS;
+
+  if (!fits) {
+    fprintf(stderr, "Error: the timing constraints at DDR5-%u do not fit the DRAM timers\n", data_rate);
+    exit(EXIT_FAILURE);
   }
-  
-  decrement_tfaw_timers(dram);
-  decrement_timing_constraints(dram);
-  decrement_consecutive_cmd_timers(dram);
 }
 
-void bank_level_parallelism(DIMM_t **dimm, Queue_t **q, uint64_t clock) {
-  bool is_cmd_issued = false;
-  DRAM_t *dram = &((*dimm)->channels[0].DDR5_chip[0]);
+void dimm_set_scheduler(DIMM_t *dimm, const Scheduler_t *scheduler) {
+  dimm->scheduler = scheduler;
+}
 
-  for (int index = 0; index < (*q)->size; index++) {
-    MemoryRequest_t *request = queue_peek_at(*q, index);
+void dimm_set_burst_length(DIMM_t *dimm, BurstLength_t burst_length, bool burst_chop) {
+  dimm->burst_length = burst_length;
+  dimm->burst_chop = burst_chop;
+}
 
-    // delete once done
-    if (request->state == COMPLETE) {
-      queue_delete_at(q, index);
-      index--; // decrement index to account for the deleted element
-      continue;
-    }
+void dimm_set_command_rate(DIMM_t *dimm, CommandRate_t command_rate) {
+  dimm->command_rate = command_rate;
+}
 
-    if (request->is_finished) {
-      open_page(dimm, request, clock);
-      continue;
+void dimm_destroy(DIMM_t **dimm) {
+  if (*dimm != NULL) {
+    // closing the sinks
+    output_close(&(*dimm)->output);
+
+    free(*dimm);
+    *dimm = NULL;  // remove dangler
+  }
+}
+
+void dimm_functional_access(DIMM_t *dimm, MemoryRequest_t *request) {
+  // closed page leaves every bank precharged, so only open page policies track rows
+  if (!dimm->scheduler->open_page) {
+    return;
+  }
+
+  DRAM_t *dram = &(dimm->channels[request->channel].ranks[request->rank]);
+  set_last_operation(dram, request);
+  activate_bank(dram, request);
+}
+
+void dimm_clear_timers(DIMM_t *dimm) {
+  for (int i = 0; i < NUM_CHANNELS; i++) {
+    for (int j = 0; j < DIMM_NUM_RANKS(dimm); j++) {
+      DRAM_t *dram = &(dimm->channels[i].ranks[j]);
+      memset(dram->timing_constraints, 0, sizeof(dram->timing_constraints));
+      memset(dram->armed, 0, sizeof(dram->armed));
+      memset(dram->last_issue, 0, sizeof(dram->last_issue));
+      memset(dram->last_issue_any, 0, sizeof(dram->last_issue_any));
+      memset(dram->tFAW_timers, 0, sizeof(dram->tFAW_timers));
+      dram->timers_running = 0;
+      dram->busy_banks = 0;
     }
 
-    if (index != 0) {
+    DataBus_t *bus = &(dimm->channels[i].data_bus);
+    memset(bus->reservation_start, 0, sizeof(bus->reservation_start));
+    memset(bus->reservation_end, 0, sizeof(bus->reservation_end));
+  }
+}
 
-      MemoryRequest_t *last_request = queue_peek_at(*q, index - 1);
-      if (
-        !last_request->is_finished &&
-        last_request->bank_group == request->bank_group &&
-        last_request->bank == request->bank
-      ) {
-        continue;
+bool dimm_is_page_miss(DIMM_t *dimm, MemoryRequest_t *request) {
+  return is_page_miss(&(dimm->channels[request->channel].ranks[request->rank]), request);
+}
+
+BankMask_t dram_ready_banks(DRAM_t *dram, MemoryRequestState_t state) {
+  switch (state) {
+    case ACT0:
+      if (!can_issue_act(dram)) {
+        return 0;
       }
+      return ~(dram->armed[tRC] | dram->armed[tRP] | dram->armed[tRFC]);
 
+    case RD0:
+    case WR0:
+      return ~dram->armed[tRCD];
+
+    case PRE: {
+      // same split as open_page(): after a write the data has to be through and tWR over
+      BankMask_t written = dram->armed[tCWL] | dram->armed[tBURST] | dram->armed[tWR];
+      BankMask_t blocked = dram->armed[tRAS] | dram->armed[tRP] |
+                           (dram->write_banks & written) | (~dram->write_banks & dram->armed[tRTP]);
+      return ~blocked;
     }
 
-    is_cmd_issued = open_page(dimm, request, clock);
+    default:
+      return (BankMask_t)~0;
+  }
+}
+
+void dimm_print_stats(DIMM_t *dimm, uint64_t clock_cycle, FILE *stream) {
+  Stats_t *stats = &dimm->stats;
+  uint64_t dimm_cycles = time_base_dimm_cycle(&dimm->time_base, clock_cycle);
+  double seconds = time_base_seconds(&dimm->time_base, clock_cycle);
+  double channel_peak = CHANNEL_PEAK_GBPS(dimm->time_base.data_rate);
 
-    if (is_cmd_issued) {
-      break;
+  fprintf(stream, "--- Statistics ---\n");
+  fprintf(stream, "Completed Requests: %" PRIu64 " (%" PRIu64 " reads, %" PRIu64 " writes)\n", stats->completed_requests, stats->reads, stats->writes);
+  fprintf(stream, "Average Latency: %.2lf CPU cycles (max %" PRIu64 ")\n", stats_average_latency(stats), stats->max_latency);
+  fprintf(stream, "Bandwidth: %.3lf GB/s\n", stats_bandwidth_gbps(stats->completed_requests, seconds));
+
+  uint64_t admission_stalls = 0;
+  for (int i = 0; i < NUM_CORES; i++) {
+    admission_stalls += stats->admission_stalls[i];
+  }
+  if (admission_stalls > 0) {
+    fprintf(stream, "Admission Stalls: %" PRIu64 " request-cycles waiting for a queue slot (by core:", admission_stalls);
+    for (int i = 0; i < NUM_CORES; i++) {
+      fprintf(stream, " %" PRIu64, stats->admission_stalls[i]);
     }
+    fprintf(stream, ")\n");
   }
+  hazard_print_stats(&dimm->hazards, stream);
 
-  decrement_timing_constraints(dram);
-  decrement_consecutive_cmd_timers(dram);
-  decrement_tfaw_timers(dram);
-}
+  for (int i = 0; i < NUM_CHANNELS; i++) {
+    CommandBus_t *bus = &(dimm->channels[i].command_bus);
+    if (bus->commands == 0) {
+      continue;
+    }
 
-void dram_init(DRAM_t *dram) {
-  // Initialize the DRAM with all banks precharged
-  for (int i = 0; i < NUM_BANK_GROUPS; i++) {
-    for (int j = 0; j < NUM_BANKS_PER_GROUP; j++) {
-      dram->bank_groups[i].banks[j].is_precharged = true;
-      dram->bank_groups[i].banks[j].is_active = false;
-      dram->bank_groups[i].banks[j].active_row = 0;
-      dram->bank_groups[i].banks[j].in_progress = false;
+    fprintf(stream, "Channel %d CA Bus (%dN): %" PRIu64 " commands, %.2lf%% utilization (%.2lf%% while requests pending)\n", i,
+           dimm->command_rate, bus->commands,
+           dimm_cycles ? 100.0 * bus->busy_cycles / dimm_cycles : 0.0,
+           bus->elapsed_cycles ? 100.0 * bus->busy_cycles / bus->elapsed_cycles : 0.0);
+  }
 
-      // zero out bank timers
-      for (int k = 0; k < NUM_TIMING_CONSTRAINTS; k++) {
-        dram->timing_constraints[i][j][k] = 0;
-      }
+  for (int i = 0; i < NUM_CHANNELS; i++) {
+    DataBus_t *bus = &(dimm->channels[i].data_bus);
+    if (bus->bursts == 0) {
+      continue;
     }
-  }
 
-  // zero out dram timers
-  for (int i = 0; i < NUM_CONSECUTIVE_CMD_CONSTRAINTS; i++) {
-    dram->consecutive_cmd_timers[i] = 0;
+    double achieved = seconds > 0.0 ? bus->bytes / seconds / 1e9 : 0.0;
+
+    fprintf(stream, "Channel %d Data Bus (%s): %" PRIu64 " bursts, %.2lf%% utilization\n", i,
+           dimm->burst_chop ? "BC8" : dimm->burst_length == BL32 ? "BL32" : "BL16", bus->bursts,
+           dimm_cycles ? 100.0 * bus->busy_cycles / dimm_cycles : 0.0);
+    fprintf(stream, "Channel %d Idle Gaps: %" PRIu64 " (average %.2lf, max %" PRIu64 " DIMM cycles)\n", i, bus->idle_gaps,
+           bus->idle_gaps ? (double)bus->idle_gap_cycles / bus->idle_gaps : 0.0, bus->max_idle_gap);
+    if (dimm->num_ranks > 1) {
+      fprintf(stream, "Channel %d Rank Switches: %" PRIu64 " (%dDPC, %d rank(s) per DIMM)\n", i, bus->rank_switches,
+             dimm->dimms_per_channel, dimm->ranks_per_dimm);
+    }
+    fprintf(stream, "Channel %d Achieved Bandwidth: %.3lf GB/s of %.1lf GB/s peak (%.2lf%%; DDR5-%u DIMM peak %.1lf GB/s)\n", i,
+           achieved, channel_peak, 100.0 * achieved / channel_peak, dimm->time_base.data_rate,
+           DIMM_PEAK_GBPS(dimm->time_base.data_rate));
   }
 
-  // zero out tfaw timers
-  for (int i = 0; i < NUM_TFAW_COUNTERS; i++) {
-    dram->tFAW_timers[i] = 0;
+  if (dimm->prefetcher != NULL) {
+    prefetcher_print_stats(dimm->prefetcher, stream);
   }
-}
 
-/*** function(s) ***/
-void dimm_create(DIMM_t **dimm, char *output_file_name) {
-  *dimm = malloc(sizeof(DIMM_t));
+  if (dimm->cores != NULL) {
+    core_model_print_stats(dimm->cores, stream);
+  }
 
-  if (*dimm == NULL) {
-    fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
-    exit(EXIT_FAILURE);
+  if (dimm->hot_rows != NULL) {
+    hot_rows_print_stats(dimm->hot_rows, dimm->num_ranks, stream);
   }
 
-  // opening the file
-  (*dimm)->output_file = fopen(output_file_name, "w");
-  if ((*dimm)->output_file == NULL) {
-    fprintf(stderr, "%s:%d: fopen failed\n", __FILE__, __LINE__);
-    exit(EXIT_FAILURE);
+  if (dimm->rowhammer != NULL) {
+    rowhammer_print_stats(dimm->rowhammer, dimm, clock_cycle, stream);
   }
 
-  for (int i = 0; i < NUM_CHANNELS; i++) {
-    for (int j = 0; j < NUM_CHIPS_PER_CHANNEL; j++) {
-      dram_init(&((*dimm)->channels[i].DDR5_chip[j]));
-    }
+  if (dimm->dueling != NULL) {
+    dueling_print_stats(dimm->dueling, stream);
   }
+  fprintf(stream, "------------------\n");
 }
 
-void dimm_destroy(DIMM_t **dimm) {
-  if (*dimm != NULL) {
-    // closing the file
-    if ((*dimm)->output_file) {
-      fclose((*dimm)->output_file);
+void dimm_report_stats(DIMM_t *dimm, uint64_t clock_cycle) {
+  for (int i = 0; i < dimm->output.num_sinks; i++) {
+    if (dimm->output.sinks[i].kind == SINK_STATS) {
+      dimm_print_stats(dimm, clock_cycle, dimm->output.sinks[i].file);
     }
-
-    free(*dimm);
-    *dimm = NULL;  // remove dangler
   }
 }
 
-void process_request(DIMM_t **dimm, Queue_t **q, uint64_t clock, uint8_t scheduling_algorithm) {
-  switch (scheduling_algorithm) {
-    case LEVEL_0:
-      level_zero_algorithm(dimm, q, clock);
-      break;
-
-    case LEVEL_1:
-      level_one_algorithm(dimm, q, clock);
-      break;
-
-    case LEVEL_2:
-    case LEVEL_3:
-      bank_level_parallelism(dimm, q, clock);
-      break;
-
-    default:
-      break;
+void process_request(DIMM_t **dimm, Queue_t **q, uint64_t clock) {
+  if ((*dimm)->rowhammer != NULL) {
+    manage_row_hammer(*dimm, *q, clock);
   }
+  (*dimm)->scheduler->select_command(dimm, q, clock);
+
+  decrement_rank_timers(*dimm);
+  tick_command_buses(*dimm);
 }
@@ -122,10 +122,15 @@ int8_t doubly_ll_insert_at(
 
   new_node->item = new_item;
 
-  // insert at head
+  // insert at tail
   if (index == 0) {
     new_node->prev_node = (*list)->list_tail;
     new_node->next_node = NULL;
+
+    // old tail has to point forward to the new tail
+    if ((*list)->list_tail != NULL) {
+      (*list)->list_tail->next_node = new_node;
+    }
     (*list)->list_tail = new_node;
 
     if ((*list)->size == 0) {
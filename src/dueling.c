@@ -0,0 +1,209 @@
+/**
+ * @file  dueling.c
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "dueling.h"
+#include "simulator.h"
+
+/*** helper function(s) ***/
+// how much better the first epoch was than the second, in completions unless they tie
+static double epoch_gain(Stats_t *epoch, Stats_t *against, bool *by_latency) {
+  *by_latency = false;
+  if (epoch->completed_requests == 0 && against->completed_requests == 0) {
+    return 0.0;
+  }
+
+  double completions = against->completed_requests ? (double)epoch->completed_requests / against->completed_requests - 1.0 : 1.0;
+  if (completions > DUEL_TIE || completions < -DUEL_TIE) {
+    return completions;
+  }
+
+  *by_latency = true;
+  double latency = stats_average_latency(epoch), against_latency = stats_average_latency(against);
+  return against_latency > 0.0 ? 1.0 - latency / against_latency : 0.0;
+}
+
+static void close_epoch(Dueling_t *dueling) {
+  Stats_t epochs[MAX_DUEL_POLICIES];
+
+  for (int i = 0; i < dueling->num_policies; i++) {
+    Stats_t *now = &dueling->shadows[i]->dimm->stats;
+    stats_subtract(&epochs[i], now, &dueling->epoch_start[i]);
+    dueling->epoch_start[i] = *now;
+  }
+
+  dueling->epochs++;
+  dueling->live_epochs[dueling->live]++;
+  stats_add(&dueling->followed, &epochs[dueling->live]);
+
+  // the live policy stays unless a candidate beat it
+  uint8_t best = dueling->live;
+  double best_gain = 0.0;
+  bool best_by_latency = false;
+  for (int i = 0; i < dueling->num_policies; i++) {
+    bool by_latency;
+    double gain = epoch_gain(&epochs[i], &epochs[dueling->live], &by_latency);
+    if (gain > best_gain) {
+      best = i;
+      best_gain = gain;
+      best_by_latency = by_latency;
+    }
+  }
+  dueling->wins[best]++;
+
+  dueling->pending = -1;
+  if (best != dueling->live && best_gain >= DUEL_MIN_GAIN) {
+    dueling->pending = best;
+    dueling->pending_gain = best_gain;
+    dueling->pending_by_latency = best_by_latency;
+  }
+}
+
+// a command half already on the bus reserves the next slot for its second half
+static bool can_switch(Queue_t *q) {
+  for (int i = 0; i < q->size; i++) {
+    if (is_second_half(queue_peek_at(q, i)->state)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/*** function(s) ***/
+void dueling_init(Dueling_t *dueling, Config_t *config) {
+  memset(dueling, 0, sizeof(Dueling_t));
+  dueling->num_policies = config->num_duel_policies;
+  memcpy(dueling->policies, config->duel_policies, sizeof(dueling->policies));
+  dueling->bank_sample = config->duel_sample;
+  dueling->epoch_cycles = config->duel_epoch;
+  dueling->epoch_end = config->duel_epoch;
+  dueling->live = 0;
+  dueling->pending = -1;
+
+  // a shadow is a plain run of its level over the sampled banks
+  Config_t shadow_config = *config;
+  shadow_config.num_outputs = 0;
+  shadow_config.print_stats = false;
+  shadow_config.restore_file = NULL;
+  shadow_config.timeline_file = NULL;
+  shadow_config.interval_cycles = 0;
+  shadow_config.hot_rows = 0;
+  shadow_config.num_duel_policies = 0;
+
+  uint8_t queue_size = MAX_QUEUE_SIZE / dueling->bank_sample > 0 ? MAX_QUEUE_SIZE / dueling->bank_sample : 1;
+
+  for (int i = 0; i < dueling->num_policies; i++) {
+    shadow_config.scheduling_policy = dueling->policies[i];
+    Simulator_t *shadow = simulator_create(&shadow_config);
+    parser_set_bank_sample(shadow->parser, dueling->bank_sample);
+    queue_destroy(&shadow->queue);
+    queue_create(&shadow->queue, queue_size);
+    dueling->shadows[i] = shadow;
+  }
+}
+
+int dueling_advance(Dueling_t *dueling, Queue_t *q, uint64_t clock) {
+  for (int i = 0; i < dueling->num_policies; i++) {
+    Simulator_t *shadow = dueling->shadows[i];
+    while (shadow->clock_cycle < clock && simulator_step(shadow)) {
+    }
+  }
+
+  if (clock >= dueling->epoch_end) {
+    close_epoch(dueling);
+
+    // a skipped idle stretch counts as one epoch
+    while (dueling->epoch_end <= clock) {
+      dueling->epoch_end += dueling->epoch_cycles;
+    }
+  }
+
+  if (dueling->pending < 0 || !can_switch(q)) {
+    return -1;
+  }
+
+  if (dueling->switches < MAX_REPORTED_SWITCHES) {
+    DuelSwitch_t *entry = &dueling->log[dueling->switches];
+    entry->cycle = clock;
+    entry->from = dueling->policies[dueling->live];
+    entry->to = dueling->policies[dueling->pending];
+    entry->gain = dueling->pending_gain;
+    entry->by_latency = dueling->pending_by_latency;
+  }
+  dueling->switches++;
+  dueling->gain_sum += dueling->pending_gain;
+  dueling->live = dueling->pending;
+  dueling->pending = -1;
+
+  return dueling->policies[dueling->live];
+}
+
+void dueling_print_stats(Dueling_t *dueling, FILE *stream) {
+  fprintf(stream, "Policy Dueling: levels");
+  for (int i = 0; i < dueling->num_policies; i++) {
+    fprintf(stream, "%s%d (%s)", i == 0 ? " " : ", ", dueling->policies[i], scheduler_get(dueling->policies[i])->name);
+  }
+  fprintf(stream, "; shadows follow 1 bank in %d, epochs of %" PRIu64 " CPU cycles\n", dueling->bank_sample, dueling->epoch_cycles);
+
+  fprintf(stream, "Dueling Epochs: %" PRIu64 " (live / won by the shadow:", dueling->epochs);
+  for (int i = 0; i < dueling->num_policies; i++) {
+    fprintf(stream, " level %d %" PRIu64 "/%" PRIu64, dueling->policies[i], dueling->live_epochs[i], dueling->wins[i]);
+  }
+  fprintf(stream, ")\n");
+
+  fprintf(stream, "Policy Switches: %" PRIu64 " (average estimated gain %.2lf%%), level %d live at the end\n", dueling->switches,
+          dueling->switches ? 100.0 * dueling->gain_sum / dueling->switches : 0.0, dueling->policies[dueling->live]);
+  for (uint64_t i = 0; i < dueling->switches && i < MAX_REPORTED_SWITCHES; i++) {
+    DuelSwitch_t *entry = &dueling->log[i];
+    fprintf(stream, "  cycle %" PRIu64 ": level %d -> %d, %+.2lf%% %s\n", entry->cycle, entry->from, entry->to,
+            (entry->by_latency ? -100.0 : 100.0) * entry->gain, entry->by_latency ? "average latency" : "completions");
+  }
+  if (dueling->switches > MAX_REPORTED_SWITCHES) {
+    fprintf(stream, "  ... %" PRIu64 " more\n", dueling->switches - MAX_REPORTED_SWITCHES);
+  }
+
+  // over the sampled banks and the closed epochs, the dynamic choice against every fixed level
+  fprintf(stream, "Shadow Estimates: followed %.2lf CPU cycles over %" PRIu64 " requests", stats_average_latency(&dueling->followed),
+          dueling->followed.completed_requests);
+  for (int i = 0; i < dueling->num_policies; i++) {
+    fprintf(stream, ", level %d %.2lf over %" PRIu64, dueling->policies[i], stats_average_latency(&dueling->epoch_start[i]),
+            dueling->epoch_start[i].completed_requests);
+  }
+  fprintf(stream, "\n");
+}
+
+void dueling_close(Dueling_t *dueling) {
+  for (int i = 0; i < dueling->num_policies; i++) {
+    simulator_destroy(dueling->shadows[i]);
+    dueling->shadows[i] = NULL;
+  }
+}
+
+int dueling_parse_policies(const char *list, uint8_t policies[MAX_DUEL_POLICIES]) {
+  char buffer[LINE_LENGTH];
+  int count = 0;
+
+  if (strlen(list) >= sizeof(buffer)) {
+    return -1;
+  }
+  strcpy(buffer, list);
+
+  for (char *name = strtok(buffer, ","); name != NULL; name = strtok(NULL, ",")) {
+    int level = scheduler_find(name);
+    if (level < 0 || count == MAX_DUEL_POLICIES) {
+      return -1;
+    }
+    for (int i = 0; i < count; i++) {
+      if (policies[i] == level) {
+        return -1;
+      }
+    }
+    policies[count++] = level;
+  }
+
+  return count;
+}
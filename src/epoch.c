@@ -0,0 +1,359 @@
+/**
+ * @file  epoch.c
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include <pthread.h>
+#include "epoch.h"
+
+/*** helper function(s) ***/
+static TraceIndexEntry_t *build_trace_index(char *input_file, uint64_t *num_requests, uint64_t *num_entries) {
+  FILE *file = fopen(input_file, "r");
+  if (file == NULL) {
+    perror("Error opening file");
+    exit(EXIT_FAILURE);
+  }
+
+  uint64_t capacity = 1024;
+  TraceIndexEntry_t *index = malloc(sizeof(TraceIndexEntry_t) * capacity);
+  if (index == NULL) {
+    fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  char line[LINE_LENGTH];
+  *num_requests = 0;
+  *num_entries = 0;
+
+  while (true) {
+    uint64_t offset = ftello(file);
+    if (fgets(line, sizeof(line), file) == NULL) {
+      break;
+    }
+
+    // skip empty lines, same as the parser
+    if (strlen(line) == 1) {
+      continue;
+    }
+
+    if (*num_requests % EPOCH_INDEX_STRIDE == 0) {
+      if (*num_entries == capacity) {
+        capacity *= 2;
+        index = realloc(index, sizeof(TraceIndexEntry_t) * capacity);
+        if (index == NULL) {
+          fprintf(stderr, "%s:%d: realloc failed\n", __FILE__, __LINE__);
+          exit(EXIT_FAILURE);
+        }
+      }
+
+      index[*num_entries].time = strtoull(line, NULL, 10);
+      index[*num_entries].offset = offset;
+      (*num_entries)++;
+    }
+
+    (*num_requests)++;
+  }
+
+  fclose(file);
+  return index;
+}
+
+static uint64_t find_start_offset(TraceIndexEntry_t *index, uint64_t num_entries, uint64_t time) {
+  // last indexed line at or before time; everything between it and time is extra warmup
+  uint64_t low = 0, high = num_entries;
+
+  while (high - low > 1) {
+    uint64_t mid = (low + high) / 2;
+    if (index[mid].time <= time) {
+      low = mid;
+    }
+    else {
+      high = mid;
+    }
+  }
+
+  return index[low].offset;
+}
+
+static void split_commands(Epoch_t *epoch, FILE *output, TimeBase_t *time_base) {
+  char line[LINE_LENGTH];
+
+  // the output is in DIMM cycles, the epoch bounds in CPU cycles
+  uint64_t start = time_base_next_dimm_cycle(time_base, epoch->start_time);
+  epoch->dimm_end_time = time_base_next_dimm_cycle(time_base, epoch->end_time);
+  epoch->dimm_stop_time = time_base_next_dimm_cycle(time_base, epoch->stop_time);
+
+  fflush(output);
+  rewind(output);
+
+  while (fgets(line, sizeof(line), output)) {
+    uint64_t cycle = strtoull(line, NULL, 10);
+
+    if (cycle < start) {
+      continue;  // warmup, owned by the previous epoch
+    }
+    else if (cycle < epoch->dimm_end_time || epoch->is_last) {
+      fputs(line, epoch->commands);
+    }
+    else if (cycle < epoch->dimm_stop_time) {
+      fputs(line, epoch->overlap);
+    }
+  }
+
+  rewind(epoch->commands);
+  rewind(epoch->overlap);
+}
+
+static void *simulate_epoch(void *arg) {
+  Epoch_t *epoch = (Epoch_t *)arg;
+  Simulator_t *sim = simulator_create(&epoch->config);
+
+  FILE *trace = tmpfile();
+  epoch->commands = tmpfile();
+  epoch->overlap = tmpfile();
+  if (trace == NULL || epoch->commands == NULL || epoch->overlap == NULL) {
+    perror("Error creating epoch output");
+    exit(EXIT_FAILURE);
+  }
+  output_attach_sink(&sim->dimm->output, SINK_TEXT, trace);
+
+  sim->parser->end_time = epoch->is_last ? UINT64_MAX : epoch->stop_time;
+  parser_seek_line(sim->parser, epoch->start_offset);
+
+  Stats_t at_start, at_end;
+  bool started = false, ended = false;
+  uint64_t idle_cycle = 0;  // last cycle with nothing queued or waiting to be admitted
+
+  while (true) {
+    if (!ended && queue_is_empty(sim->queue) && sim->num_pending == 0) {
+      idle_cycle = sim->clock_cycle;
+    }
+
+    if (!started && sim->clock_cycle >= epoch->start_time) {
+      at_start = sim->dimm->stats;
+      started = true;
+    }
+
+    if (!ended && !epoch->is_last && sim->clock_cycle >= epoch->end_time) {
+      at_end = sim->dimm->stats;
+      epoch->busy_time = idle_cycle;
+      ended = true;
+    }
+
+    if (!epoch->is_last && sim->clock_cycle >= epoch->stop_time) {
+      break;
+    }
+
+    if (!simulator_step(sim)) {
+      break;
+    }
+  }
+
+  if (!started) {
+    at_start = sim->dimm->stats;
+  }
+  if (!ended) {
+    at_end = sim->dimm->stats;
+    epoch->busy_time = epoch->end_time;
+  }
+
+  stats_subtract(&epoch->stats, &at_end, &at_start);
+  epoch->final_cycle = sim->clock_cycle;
+
+  split_commands(epoch, trace, &sim->dimm->time_base);
+  simulator_destroy(sim);
+
+  return NULL;
+}
+
+static void compare_boundary(Epoch_t *earlier, Epoch_t *later, EpochBoundary_t *boundary) {
+  char full_history[LINE_LENGTH], warmed_up[LINE_LENGTH];
+  bool has_full = true, has_warm = true;
+
+  memset(boundary, 0, sizeof(EpochBoundary_t));
+  boundary->cycle = earlier->end_time;
+
+  while (true) {
+    has_full = has_full && fgets(full_history, sizeof(full_history), earlier->overlap) != NULL;
+    has_warm = has_warm && fgets(warmed_up, sizeof(warmed_up), later->commands) != NULL;
+
+    // only the later epoch's commands inside the overlap are comparable
+    if (has_warm && strtoull(warmed_up, NULL, 10) >= earlier->dimm_stop_time) {
+      has_warm = false;
+    }
+
+    // and an overlap longer than the later epoch only up to its end
+    if (has_full && !later->is_last && strtoull(full_history, NULL, 10) >= later->dimm_end_time) {
+      has_full = false;
+    }
+
+    if (!has_full && !has_warm) {
+      break;
+    }
+
+    if (has_full) {
+      boundary->overlap_commands++;
+    }
+
+    if (!has_full || !has_warm || strcmp(full_history, warmed_up) != 0) {
+      uint64_t cycle = strtoull(has_full ? full_history : warmed_up, NULL, 10);
+      boundary->mismatched_commands++;
+      boundary->converged_after = cycle - earlier->dimm_end_time + 1;
+    }
+  }
+
+  rewind(later->commands);
+}
+
+static void append_file(FILE *destination, FILE *source) {
+  char buffer[1 << 16];
+  size_t length;
+
+  while ((length = fread(buffer, 1, sizeof(buffer), source)) > 0) {
+    fwrite(buffer, 1, length, destination);
+  }
+}
+
+static void print_report(Epoch_t *epochs, EpochBoundary_t *boundaries, uint64_t num_epochs, Config_t *config) {
+  printf("--- Epoch-Parallel Simulation ---\n");
+  printf("Epochs: %" PRIu64 " (warmup %" PRIu64 " CPU cycles)\n", num_epochs, config->epoch_warmup);
+  printf("%5s %14s %14s %14s %12s %12s\n", "Epoch", "Warmup From", "Start Cycle", "End Cycle", "Completed", "Avg Latency");
+
+  for (uint64_t i = 0; i < num_epochs; i++) {
+    if (epochs[i].is_last) {
+      printf("%5" PRIu64 " %14" PRIu64 " %14" PRIu64 " %14s %12" PRIu64 " %12.2lf\n", i, epochs[i].warmup_time, epochs[i].start_time,
+             "end", epochs[i].stats.completed_requests, stats_average_latency(&epochs[i].stats));
+    }
+    else {
+      printf("%5" PRIu64 " %14" PRIu64 " %14" PRIu64 " %14" PRIu64 " %12" PRIu64 " %12.2lf\n", i, epochs[i].warmup_time,
+             epochs[i].start_time, epochs[i].end_time, epochs[i].stats.completed_requests, stats_average_latency(&epochs[i].stats));
+    }
+  }
+
+  printf("%8s %14s %10s %10s %16s\n", "Boundary", "Cycle", "Commands", "Mismatch", "Converged After");
+  for (uint64_t i = 0; i + 1 < num_epochs; i++) {
+    printf("%8" PRIu64 " %14" PRIu64 " %10" PRIu64 " %10" PRIu64 " %16" PRIu64 "\n", i + 1, boundaries[i].cycle,
+           boundaries[i].overlap_commands, boundaries[i].mismatched_commands, boundaries[i].converged_after);
+  }
+  printf("---------------------------------\n");
+}
+
+/*** function(s) ***/
+uint64_t run_epoch_parallel_simulation(Config_t *config) {
+  uint64_t num_requests, num_entries;
+  TraceIndexEntry_t *index = build_trace_index(config->input_file, &num_requests, &num_entries);
+
+  if (num_requests == 0) {
+    fprintf(stderr, "Error: %s has no requests\n", config->input_file);
+    exit(EXIT_FAILURE);
+  }
+
+  // cut at equal request counts; identical timestamps collapse epochs
+  uint64_t *boundary_times = malloc(sizeof(uint64_t) * (config->epochs + 1));
+  uint64_t num_epochs = 0;
+  boundary_times[num_epochs++] = 0;
+
+  for (uint64_t i = 1; i < config->epochs; i++) {
+    uint64_t time = index[(i * num_requests / config->epochs) / EPOCH_INDEX_STRIDE].time;
+    if (time > boundary_times[num_epochs - 1]) {
+      boundary_times[num_epochs++] = time;
+    }
+  }
+
+  Epoch_t *epochs = calloc(num_epochs, sizeof(Epoch_t));
+  EpochBoundary_t *boundaries = calloc(num_epochs, sizeof(EpochBoundary_t));
+  pthread_t *threads = malloc(sizeof(pthread_t) * num_epochs);
+  if (epochs == NULL || boundaries == NULL || threads == NULL || boundary_times == NULL) {
+    fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  for (uint64_t i = 0; i < num_epochs; i++) {
+    Epoch_t *epoch = &epochs[i];
+    epoch->config = *config;
+    epoch->config.num_outputs = 0;  // each epoch writes to its own temporary file
+    epoch->config.restore_file = NULL;
+    epoch->warmup_time = boundary_times[i] > config->epoch_warmup ? boundary_times[i] - config->epoch_warmup : 0;
+    epoch->start_offset = find_start_offset(index, num_entries, epoch->warmup_time);
+    epoch->start_time = boundary_times[i];
+    epoch->is_last = i == num_epochs - 1;
+    epoch->end_time = epoch->is_last ? UINT64_MAX : boundary_times[i + 1];
+    epoch->stop_time = epoch->is_last ? UINT64_MAX : epoch->end_time + config->epoch_warmup;
+
+    if (pthread_create(&threads[i], NULL, simulate_epoch, epoch) != 0) {
+      fprintf(stderr, "%s:%d: pthread_create failed\n", __FILE__, __LINE__);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  for (uint64_t i = 0; i < num_epochs; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  // a backlog at the boundary older than the next epoch's warmup would get no commands after it;
+  // run that epoch again from the warmup before the backlog built up. In order, so the earlier epoch is final.
+  for (uint64_t i = 1; i < num_epochs; i++) {
+    uint64_t busy_time = epochs[i - 1].busy_time;
+    uint64_t warmup_time = busy_time > config->epoch_warmup ? busy_time - config->epoch_warmup : 0;
+
+    if (warmup_time < epochs[i].warmup_time) {
+      fclose(epochs[i].commands);
+      fclose(epochs[i].overlap);
+      epochs[i].warmup_time = warmup_time;
+      epochs[i].start_offset = find_start_offset(index, num_entries, warmup_time);
+      simulate_epoch(&epochs[i]);
+    }
+  }
+
+  // stitch into every text output
+  Output_t output;
+  output_init(&output, config->dimms_per_channel * config->ranks_per_dimm);
+  for (int i = 0; i < config->num_outputs; i++) {
+    output_add_sink(&output, config->output_kinds[i], config->output_files[i]);
+  }
+
+  Stats_t total;
+  stats_init(&total);
+
+  for (uint64_t i = 0; i < num_epochs; i++) {
+    if (i + 1 < num_epochs) {
+      compare_boundary(&epochs[i], &epochs[i + 1], &boundaries[i]);
+    }
+
+    for (int j = 0; j < output.num_sinks; j++) {
+      if (output.sinks[j].kind == SINK_TEXT) {
+        rewind(epochs[i].commands);
+        append_file(output.sinks[j].file, epochs[i].commands);
+      }
+    }
+    stats_add(&total, &epochs[i].stats);
+  }
+  output_close(&output);
+
+  print_report(epochs, boundaries, num_epochs, config);
+  printf("Completed Requests: %" PRIu64 "\n", total.completed_requests);
+  printf("Average Latency: %.2lf CPU cycles\n", stats_average_latency(&total));
+
+  // an epoch that diverged from the full history can still serve a request on the wrong side of its boundary
+  if (total.completed_requests != num_requests) {
+    fprintf(stderr, "Error: %" PRIu64 " of %" PRIu64 " requests did not complete inside their epoch, the output misses their commands; "
+            "increase --epoch-warmup\n", num_requests - total.completed_requests, num_requests);
+    exit(EXIT_FAILURE);
+  }
+
+  uint64_t final_cycle = epochs[num_epochs - 1].final_cycle;
+  for (uint64_t i = 0; i < num_epochs; i++) {
+    fclose(epochs[i].commands);
+    fclose(epochs[i].overlap);
+  }
+
+  free(index);
+  free(boundary_times);
+  free(epochs);
+  free(boundaries);
+  free(threads);
+
+  return final_cycle;
+}
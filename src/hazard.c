@@ -0,0 +1,147 @@
+/**
+ * @file  hazard.c
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "hazard.h"
+
+/*** helper function(s) ***/
+static uint64_t request_line(MemoryRequest_t *request) {
+  return memory_request_address(request) / BYTES_PER_LINE;
+}
+
+static uint32_t home_slot(uint64_t line) {
+  return (uint32_t)((line * 0x9E3779B97F4A7C15ULL) >> 32) & (HAZARD_SLOTS - 1);
+}
+
+// the slot holding the line, or the free slot it would go to
+static HazardLine_t *find_slot(HazardTable_t *table, uint64_t line) {
+  uint32_t slot = home_slot(line);
+
+  while (table->slots[slot].count != 0 && table->slots[slot].line != line) {
+    slot = (slot + 1) & (HAZARD_SLOTS - 1);
+  }
+
+  return &table->slots[slot];
+}
+
+// backward-shift deletion, the probe runs of the lines after it stay unbroken
+static void free_slot(HazardTable_t *table, HazardLine_t *entry) {
+  uint32_t hole = (uint32_t)(entry - table->slots);
+  uint32_t slot = hole;
+
+  table->slots[hole].count = 0;
+  while (true) {
+    slot = (slot + 1) & (HAZARD_SLOTS - 1);
+    if (table->slots[slot].count == 0) {
+      break;
+    }
+
+    // move the line back only if the hole lies between its home slot and where it is
+    uint32_t home = home_slot(table->slots[slot].line);
+    if (((slot - home) & (HAZARD_SLOTS - 1)) >= ((slot - hole) & (HAZARD_SLOTS - 1))) {
+      table->slots[hole] = table->slots[slot];
+      table->slots[slot].count = 0;
+      hole = slot;
+    }
+  }
+
+  table->lines--;
+}
+
+// the first older access to the line the request conflicts with, NUM_HAZARD_KINDS if none
+static HazardKind_t blocking_kind(HazardTable_t *table, MemoryRequest_t *request) {
+  HazardLine_t *entry = find_slot(table, request_line(request));
+  bool is_write = request->operation == DATA_WRITE;
+
+  for (uint8_t i = 0; i < entry->count && entry->accesses[i].sequence != request->sequence; i++) {
+    if (entry->accesses[i].is_write) {
+      return is_write ? HAZARD_WAW : HAZARD_RAW;
+    }
+    if (is_write) {
+      return HAZARD_WAR;
+    }
+  }
+
+  return NUM_HAZARD_KINDS;
+}
+
+/*** function(s) ***/
+void hazard_init(HazardTable_t *table) {
+  memset(table, 0, sizeof(HazardTable_t));
+}
+
+void hazard_enqueue(HazardTable_t *table, MemoryRequest_t *request) {
+  uint64_t line = request_line(request);
+  HazardLine_t *entry = find_slot(table, line);
+
+  if (entry->count == 0) {
+    if (table->lines == HAZARD_SLOTS - 1) {
+      fprintf(stderr, "%s:%d: hazard table full\n", __FILE__, __LINE__);
+      exit(EXIT_FAILURE);
+    }
+    entry->line = line;
+    table->lines++;
+    if (table->lines > table->max_lines) {
+      table->max_lines = table->lines;
+    }
+  }
+  else if (entry->count == HAZARD_DEPTH) {
+    fprintf(stderr, "%s:%d: hazard line full\n", __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  request->sequence = table->next_sequence++;
+  entry->accesses[entry->count].sequence = request->sequence;
+  entry->accesses[entry->count].is_write = request->operation == DATA_WRITE;
+  entry->count++;
+  if (entry->count > table->max_depth) {
+    table->max_depth = entry->count;
+  }
+}
+
+bool hazard_is_clear(HazardTable_t *table, MemoryRequest_t *request) {
+  return blocking_kind(table, request) == NUM_HAZARD_KINDS;
+}
+
+bool hazard_hold(HazardTable_t *table, MemoryRequest_t *request) {
+  HazardKind_t kind = blocking_kind(table, request);
+  if (kind == NUM_HAZARD_KINDS) {
+    return false;
+  }
+
+  table->stalls[kind]++;
+  return true;
+}
+
+void hazard_release(HazardTable_t *table, MemoryRequest_t *request) {
+  HazardLine_t *entry = find_slot(table, request_line(request));
+  if (entry->count == 0) {
+    return;
+  }
+
+  for (uint8_t i = 0; i < entry->count; i++) {
+    if (entry->accesses[i].sequence == request->sequence) {
+      memmove(&entry->accesses[i], &entry->accesses[i + 1], sizeof(HazardAccess_t) * (entry->count - i - 1));
+      entry->count--;
+      break;
+    }
+  }
+
+  if (entry->count == 0) {
+    free_slot(table, entry);
+  }
+}
+
+void hazard_print_stats(HazardTable_t *table, FILE *stream) {
+  uint64_t stalls = table->stalls[HAZARD_RAW] + table->stalls[HAZARD_WAR] + table->stalls[HAZARD_WAW];
+  if (stalls == 0) {
+    return;
+  }
+
+  fprintf(stream, "Hazard Stalls: %" PRIu64 " DIMM cycles a RD/WR waited on an older access to its line (RAW %" PRIu64 ", WAR %" PRIu64
+          ", WAW %" PRIu64 "); at most %d lines, %d accesses to one line in flight\n", stalls, table->stalls[HAZARD_RAW],
+          table->stalls[HAZARD_WAR], table->stalls[HAZARD_WAW], table->max_lines, table->max_depth);
+}
@@ -0,0 +1,267 @@
+/**
+ * @file  hot_rows.c
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "hot_rows.h"
+
+#define CSV_HEADER "interval,start_cycle,channel,rank,bank_group,bank,row,activations,bank_activations"
+
+/*** helper function(s) ***/
+static uint32_t hot_row_key(MemoryRequest_t *request) {
+  uint32_t bank = (((request->channel * MAX_RANKS_PER_CHANNEL + request->rank) * NUM_BANK_GROUPS + request->bank_group) * NUM_BANKS_PER_GROUP) +
+                  request->bank;
+  return (bank << 16) | request->row;
+}
+
+static void decode_key(uint32_t key, uint8_t *channel, uint8_t *rank, uint8_t *bank_group, uint8_t *bank, uint16_t *row) {
+  uint32_t index = key >> 16;
+
+  *row = key & 0xFFFF;
+  *bank = index % NUM_BANKS_PER_GROUP;
+  index /= NUM_BANKS_PER_GROUP;
+  *bank_group = index % NUM_BANK_GROUPS;
+  index /= NUM_BANK_GROUPS;
+  *rank = index % MAX_RANKS_PER_CHANNEL;
+  *channel = index / MAX_RANKS_PER_CHANNEL;
+}
+
+static uint64_t mix64(uint64_t value) {
+  value ^= value >> 33;
+  value *= 0xFF51AFD7ED558CCDULL;
+  value ^= value >> 33;
+  value *= 0xC4CEB9FE1A85EC53ULL;
+  value ^= value >> 33;
+  return value;
+}
+
+static void swap_rows(HotRow_t *a, HotRow_t *b) {
+  HotRow_t swap = *a;
+  *a = *b;
+  *b = swap;
+}
+
+static void sift_up(RowSketch_t *sketch, uint8_t i) {
+  while (i > 0 && sketch->top[(i - 1) / 2].activations > sketch->top[i].activations) {
+    swap_rows(&sketch->top[(i - 1) / 2], &sketch->top[i]);
+    i = (i - 1) / 2;
+  }
+}
+
+static void sift_down(RowSketch_t *sketch, uint8_t i) {
+  while (true) {
+    uint8_t smallest = i;
+    uint8_t left = 2 * i + 1, right = 2 * i + 2;
+    if (left < sketch->num_top && sketch->top[left].activations < sketch->top[smallest].activations) {
+      smallest = left;
+    }
+    if (right < sketch->num_top && sketch->top[right].activations < sketch->top[smallest].activations) {
+      smallest = right;
+    }
+    if (smallest == i) {
+      return;
+    }
+    swap_rows(&sketch->top[i], &sketch->top[smallest]);
+    i = smallest;
+  }
+}
+
+// conservative update: only the counters at the minimum grow, which keeps the overcount down
+static uint32_t sketch_add(RowSketch_t *sketch, uint32_t key, uint8_t k) {
+  uint64_t hash = mix64(key);
+  uint32_t *counters[HOT_ROWS_DEPTH];
+  uint32_t estimate = UINT32_MAX;
+
+  for (int d = 0; d < HOT_ROWS_DEPTH; d++) {
+    counters[d] = &sketch->counters[d][(hash >> (d * HOT_ROWS_WIDTH_BITS)) & (HOT_ROWS_WIDTH - 1)];
+    if (*counters[d] < estimate) {
+      estimate = *counters[d];
+    }
+  }
+  estimate++;
+  for (int d = 0; d < HOT_ROWS_DEPTH; d++) {
+    if (*counters[d] < estimate) {
+      *counters[d] = estimate;
+    }
+  }
+  sketch->activations++;
+
+  for (uint8_t i = 0; i < sketch->num_top; i++) {
+    if (sketch->top[i].key == key) {
+      sketch->top[i].activations = estimate;
+      sift_down(sketch, i);
+      return estimate;
+    }
+  }
+
+  if (sketch->num_top < k) {
+    sketch->top[sketch->num_top] = (HotRow_t){key, estimate};
+    sift_up(sketch, sketch->num_top++);
+  }
+  else if (estimate > sketch->top[0].activations) {
+    sketch->top[0] = (HotRow_t){key, estimate};
+    sift_down(sketch, 0);
+  }
+
+  return estimate;
+}
+
+// the hot rows, hottest first
+static uint8_t sorted_rows(RowSketch_t *sketch, HotRow_t *rows) {
+  memcpy(rows, sketch->top, sizeof(HotRow_t) * sketch->num_top);
+
+  for (uint8_t i = 1; i < sketch->num_top; i++) {
+    HotRow_t row = rows[i];
+    int8_t j = i - 1;
+    while (j >= 0 && rows[j].activations < row.activations) {
+      rows[j + 1] = rows[j];
+      j--;
+    }
+    rows[j + 1] = row;
+  }
+
+  return sketch->num_top;
+}
+
+static void write_interval(HotRows_t *hot_rows) {
+  HotRow_t rows[MAX_HOT_ROWS];
+  uint8_t num_rows = sorted_rows(&hot_rows->interval, rows);
+
+  for (uint8_t i = 0; i < num_rows; i++) {
+    uint8_t channel, rank, bank_group, bank;
+    uint16_t row;
+    decode_key(rows[i].key, &channel, &rank, &bank_group, &bank, &row);
+    fprintf(hot_rows->file, "%" PRIu64 ",%" PRIu64 ",%u,%u,%u,%u,%u,%u,%u\n", hot_rows->index, hot_rows->start, channel, rank,
+            bank_group, bank, row, rows[i].activations,
+            hot_rows->interval.bank_activations[channel][rank][bank_group * NUM_BANKS_PER_GROUP + bank]);
+  }
+}
+
+static void start_interval(HotRows_t *hot_rows, uint64_t index, uint64_t start) {
+  hot_rows->index = index;
+  hot_rows->start = start;
+  hot_rows->end = (index + 1) * hot_rows->interval_cycles;
+  if (hot_rows->interval.activations > 0) {
+    memset(&hot_rows->interval, 0, sizeof(RowSketch_t));
+  }
+}
+
+/*** function(s) ***/
+void hot_rows_init(HotRows_t *hot_rows, uint8_t k, char *file_name, uint64_t interval_cycles) {
+  memset(hot_rows, 0, sizeof(HotRows_t));
+  hot_rows->k = k;
+  hot_rows->interval_cycles = interval_cycles;
+
+  if (interval_cycles > 0) {
+    hot_rows->file = fopen(file_name, "w");
+    if (hot_rows->file == NULL) {
+      fprintf(stderr, "%s:%d: fopen failed\n", __FILE__, __LINE__);
+      exit(EXIT_FAILURE);
+    }
+    fprintf(hot_rows->file, "%s\n", CSV_HEADER);
+    start_interval(hot_rows, 0, 0);
+  }
+}
+
+void hot_rows_resume(HotRows_t *hot_rows, uint64_t cycle) {
+  // the first interval is counted from the restore cycle on
+  if (hot_rows->file != NULL) {
+    memset(&hot_rows->interval, 0, sizeof(RowSketch_t));
+    start_interval(hot_rows, cycle / hot_rows->interval_cycles, cycle);
+  }
+}
+
+void hot_rows_activate(HotRows_t *hot_rows, MemoryRequest_t *request, uint64_t cycle) {
+  uint32_t key = hot_row_key(request);
+  uint8_t bank = request->bank_group * NUM_BANKS_PER_GROUP + request->bank;
+
+  uint32_t estimate = sketch_add(&hot_rows->run, key, hot_rows->k);
+  hot_rows->bank_activations[request->channel][request->rank][bank]++;
+  if (estimate > hot_rows->bank_max[request->channel][request->rank][bank]) {
+    hot_rows->bank_max[request->channel][request->rank][bank] = estimate;
+    hot_rows->bank_max_row[request->channel][request->rank][bank] = request->row;
+  }
+
+  if (hot_rows->file != NULL) {
+    if (cycle >= hot_rows->end) {
+      if (hot_rows->interval.activations > 0) {
+        write_interval(hot_rows);
+      }
+      start_interval(hot_rows, cycle / hot_rows->interval_cycles, cycle / hot_rows->interval_cycles * hot_rows->interval_cycles);
+    }
+    sketch_add(&hot_rows->interval, key, hot_rows->k);
+    hot_rows->interval.bank_activations[request->channel][request->rank][bank]++;
+  }
+}
+
+void hot_rows_print_stats(HotRows_t *hot_rows, uint8_t num_ranks, FILE *stream) {
+  HotRow_t rows[MAX_HOT_ROWS];
+  uint8_t num_rows = sorted_rows(&hot_rows->run, rows);
+  uint64_t activations = 0, busiest = 0, top_activations = 0;
+  int active_banks = 0;
+
+  for (int channel = 0; channel < NUM_CHANNELS; channel++) {
+    for (int rank = 0; rank < num_ranks; rank++) {
+      for (int bank = 0; bank < NUM_BANKS; bank++) {
+        uint64_t count = hot_rows->bank_activations[channel][rank][bank];
+        activations += count;
+        active_banks += count > 0;
+        busiest = count > busiest ? count : busiest;
+      }
+    }
+  }
+  for (uint8_t i = 0; i < num_rows; i++) {
+    top_activations += rows[i].activations;
+  }
+
+  fprintf(stream, "Row Activations: %" PRIu64 " in %d bank(s), busiest bank %" PRIu64 " (%.2lfx the mean)\n", activations, active_banks,
+          busiest, active_banks ? (double)busiest * active_banks / activations : 0.0);
+  fprintf(stream, "Hot Rows: top %u take %.2lf%% of the activations (estimates overcount by at most %.0lf, 98%% confidence)\n", num_rows,
+          activations ? 100.0 * top_activations / activations : 0.0, 2.718 * hot_rows->run.activations / HOT_ROWS_WIDTH);
+  fprintf(stream, "Channel  Rank  BG  Bank   Row  Activations  %% of Bank\n");
+  for (uint8_t i = 0; i < num_rows; i++) {
+    uint8_t channel, rank, bank_group, bank;
+    uint16_t row;
+    decode_key(rows[i].key, &channel, &rank, &bank_group, &bank, &row);
+    uint64_t bank_count = hot_rows->bank_activations[channel][rank][bank_group * NUM_BANKS_PER_GROUP + bank];
+    fprintf(stream, "%7u  %4u  %2u  %4u  %4X  %11u  %9.2lf\n", channel, rank, bank_group, bank, row, rows[i].activations,
+            bank_count ? 100.0 * rows[i].activations / bank_count : 0.0);
+  }
+
+  // per bank: the activations and its hottest row with its estimated share
+  fprintf(stream, "Bank Activations (ACTs / hottest row, %% of the bank):\n");
+  for (int channel = 0; channel < NUM_CHANNELS; channel++) {
+    for (int rank = 0; rank < num_ranks; rank++) {
+      bool seen = false;
+      for (int bank = 0; bank < NUM_BANKS; bank++) {
+        seen = seen || hot_rows->bank_activations[channel][rank][bank] > 0;
+      }
+      if (!seen) {
+        continue;
+      }
+
+      for (int bank_group = 0; bank_group < NUM_BANK_GROUPS; bank_group++) {
+        fprintf(stream, "  Channel %d Rank %d BG %d:", channel, rank, bank_group);
+        for (int i = 0; i < NUM_BANKS_PER_GROUP; i++) {
+          int bank = bank_group * NUM_BANKS_PER_GROUP + i;
+          uint64_t count = hot_rows->bank_activations[channel][rank][bank];
+          fprintf(stream, " %10" PRIu64 " / %4X %5.1lf%%", count, hot_rows->bank_max_row[channel][rank][bank],
+                  count ? 100.0 * hot_rows->bank_max[channel][rank][bank] / count : 0.0);
+        }
+        fprintf(stream, "\n");
+      }
+    }
+  }
+}
+
+void hot_rows_close(HotRows_t *hot_rows) {
+  if (hot_rows->file != NULL) {
+    if (hot_rows->interval.activations > 0) {
+      write_interval(hot_rows);
+    }
+    fclose(hot_rows->file);
+    hot_rows->file = NULL;
+  }
+}
@@ -0,0 +1,474 @@
+/**
+ * @file  input_stream.c
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "input_stream.h"
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+static const uint8_t gzip_magic[] = {0x1F, 0x8B};
+static const uint8_t zstd_magic[] = {0x28, 0xB5, 0x2F, 0xFD};
+
+/*** helper function(s) ***/
+static InputCompression_t detect_compression(const uint8_t *bytes, size_t length) {
+  if (length >= sizeof(gzip_magic) && memcmp(bytes, gzip_magic, sizeof(gzip_magic)) == 0) {
+    return INPUT_GZIP;
+  }
+  if (length >= sizeof(zstd_magic) && memcmp(bytes, zstd_magic, sizeof(zstd_magic)) == 0) {
+    return INPUT_ZSTD;
+  }
+
+  return INPUT_PLAIN;
+}
+
+static void *allocate(size_t size) {
+  void *memory = malloc(size);
+  if (memory == NULL) {
+    fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  return memory;
+}
+
+static size_t read_input(InputStream_t *stream, void *buffer, size_t size) {
+  ssize_t length;
+
+  // closing the stream cancels the reader here, and only here, while it waits for a pipe
+  do {
+    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+    length = read(stream->fd, buffer, size);
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+  } while (length < 0 && errno == EINTR);
+
+  if (length < 0) {
+    perror("Error reading input");
+    exit(EXIT_FAILURE);
+  }
+
+  return length;
+}
+
+static bool refill_raw(InputStream_t *stream) {
+  stream->raw_position = 0;
+  stream->raw_length = read_input(stream, stream->raw, INPUT_STREAM_READ_SIZE);
+  return stream->raw_length > 0;
+}
+
+static void truncated_input(InputStream_t *stream) {
+  fprintf(stderr, "Error: the %s input ends in the middle of a frame\n", stream->compression == INPUT_GZIP ? "gzip" : "zstd");
+  exit(EXIT_FAILURE);
+}
+
+static size_t fill_plain(InputStream_t *stream, char *block, size_t size) {
+  size_t produced = 0;
+
+  // what was read to recognize the input comes first
+  if (stream->raw_position < stream->raw_length) {
+    produced = stream->raw_length - stream->raw_position;
+    memcpy(block, stream->raw + stream->raw_position, produced);
+    stream->raw_position = stream->raw_length;
+  }
+
+  while (produced < size) {
+    size_t length = read_input(stream, block + produced, size - produced);
+    if (length == 0) {
+      break;
+    }
+    produced += length;
+  }
+
+  return produced;
+}
+
+#ifdef HAVE_ZLIB
+static size_t fill_gzip(InputStream_t *stream, char *block, size_t size) {
+  z_stream *inflater = stream->decoder;
+  size_t produced = 0;
+
+  while (produced < size) {
+    // a full block may leave output inside zlib, which comes out without new input
+    if (stream->raw_position == stream->raw_length && !stream->pending && !refill_raw(stream)) {
+      if (stream->frame_open) {
+        truncated_input(stream);
+      }
+      break;
+    }
+
+    inflater->next_in = (Bytef *)stream->raw + stream->raw_position;
+    inflater->avail_in = stream->raw_length - stream->raw_position;
+    inflater->next_out = (Bytef *)block + produced;
+    inflater->avail_out = size - produced;
+
+    size_t available = inflater->avail_in;
+    int status = inflate(inflater, Z_NO_FLUSH);
+    if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR) {
+      fprintf(stderr, "Error: gzip input is corrupt (%s)\n", inflater->msg != NULL ? inflater->msg : "inflate failed");
+      exit(EXIT_FAILURE);
+    }
+
+    stream->pending = inflater->avail_out == 0 && status != Z_STREAM_END;
+    stream->raw_position = stream->raw_length - inflater->avail_in;
+    produced = size - inflater->avail_out;
+    stream->frame_open = stream->frame_open || inflater->avail_in < available;
+
+    // concatenated archives are one gzip member after another
+    if (status == Z_STREAM_END) {
+      inflateReset(inflater);
+      stream->frame_open = false;
+    }
+  }
+
+  return produced;
+}
+#endif
+
+#ifdef HAVE_ZSTD
+static size_t fill_zstd(InputStream_t *stream, char *block, size_t size) {
+  ZSTD_DStream *decompressor = stream->decoder;
+  ZSTD_outBuffer output = {block, size, 0};
+
+  while (output.pos < size) {
+    if (stream->raw_position == stream->raw_length && !stream->pending && !refill_raw(stream)) {
+      if (stream->frame_open) {
+        truncated_input(stream);
+      }
+      break;
+    }
+
+    ZSTD_inBuffer input = {stream->raw, stream->raw_length, stream->raw_position};
+    size_t consumed = input.pos;
+    size_t hint = ZSTD_decompressStream(decompressor, &output, &input);
+    if (ZSTD_isError(hint)) {
+      fprintf(stderr, "Error: zstd input is corrupt (%s)\n", ZSTD_getErrorName(hint));
+      exit(EXIT_FAILURE);
+    }
+
+    // 0 once a frame is decoded and flushed
+    stream->frame_open = hint != 0 && (stream->frame_open || input.pos > consumed);
+    stream->pending = output.pos == output.size && hint != 0;
+    stream->raw_position = input.pos;
+  }
+
+  return output.pos;
+}
+#endif
+
+static void start_decoder(InputStream_t *stream) {
+  switch (stream->compression) {
+    case INPUT_GZIP:
+#ifdef HAVE_ZLIB
+      {
+        z_stream *inflater = allocate(sizeof(z_stream));
+        memset(inflater, 0, sizeof(z_stream));
+        if (inflateInit2(inflater, 15 + 16) != Z_OK) {  // gzip wrapper, largest window
+          fprintf(stderr, "Error: cannot start the gzip decoder\n");
+          exit(EXIT_FAILURE);
+        }
+        stream->decoder = inflater;
+      }
+      break;
+#else
+      fprintf(stderr, "Error: the input is gzip compressed and this build has no zlib; use gzip -dc file | bin/main -i -\n");
+      exit(EXIT_FAILURE);
+#endif
+    case INPUT_ZSTD:
+#ifdef HAVE_ZSTD
+      stream->decoder = ZSTD_createDStream();
+      if (stream->decoder == NULL || ZSTD_isError(ZSTD_initDStream(stream->decoder))) {
+        fprintf(stderr, "Error: cannot start the zstd decoder\n");
+        exit(EXIT_FAILURE);
+      }
+      break;
+#else
+      fprintf(stderr, "Error: the input is zstd compressed and this build has no libzstd; use zstd -dc file | bin/main -i -\n");
+      exit(EXIT_FAILURE);
+#endif
+    case INPUT_PLAIN:
+    default:
+      break;
+  }
+}
+
+static void stop_decoder(InputStream_t *stream) {
+  if (stream->decoder == NULL) {
+    return;
+  }
+
+#ifdef HAVE_ZLIB
+  if (stream->compression == INPUT_GZIP) {
+    inflateEnd(stream->decoder);
+    free(stream->decoder);
+  }
+#endif
+#ifdef HAVE_ZSTD
+  if (stream->compression == INPUT_ZSTD) {
+    ZSTD_freeDStream(stream->decoder);
+  }
+#endif
+  stream->decoder = NULL;
+}
+
+static size_t fill_block(InputStream_t *stream, char *block) {
+  switch (stream->compression) {
+#ifdef HAVE_ZLIB
+    case INPUT_GZIP:
+      return fill_gzip(stream, block, INPUT_STREAM_BLOCK_SIZE);
+#endif
+#ifdef HAVE_ZSTD
+    case INPUT_ZSTD:
+      return fill_zstd(stream, block, INPUT_STREAM_BLOCK_SIZE);
+#endif
+    case INPUT_PLAIN:
+    default:
+      return fill_plain(stream, block, INPUT_STREAM_BLOCK_SIZE);
+  }
+}
+
+static void *reader_thread(void *arg) {
+  InputStream_t *stream = arg;
+  pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+
+  // enough of the input to see its magic bytes, a pipe may hand them over one by one
+  stream->raw_length = 0;
+  stream->raw_position = 0;
+  while (stream->raw_length < sizeof(zstd_magic)) {
+    size_t length = read_input(stream, stream->raw + stream->raw_length, INPUT_STREAM_READ_SIZE - stream->raw_length);
+    if (length == 0) {
+      break;
+    }
+    stream->raw_length += length;
+  }
+  stream->compression = detect_compression((uint8_t *)stream->raw, stream->raw_length);
+  start_decoder(stream);
+
+  while (true) {
+    pthread_mutex_lock(&stream->lock);
+    while (stream->count == INPUT_STREAM_BLOCKS && !stream->stop) {
+      pthread_cond_wait(&stream->drained, &stream->lock);
+    }
+    if (stream->stop) {
+      pthread_mutex_unlock(&stream->lock);
+      return NULL;
+    }
+    uint8_t index = (stream->head + stream->count) % INPUT_STREAM_BLOCKS;
+    pthread_mutex_unlock(&stream->lock);
+
+    // the block is not the parser's until it is counted
+    size_t length = fill_block(stream, stream->blocks[index]);
+
+    pthread_mutex_lock(&stream->lock);
+    if (length > 0) {
+      stream->block_lengths[index] = length;
+      stream->count++;
+    }
+    stream->end = length < INPUT_STREAM_BLOCK_SIZE;  // blocks only come back short at the end of the input
+    pthread_cond_signal(&stream->filled);
+    pthread_mutex_unlock(&stream->lock);
+
+    if (stream->end) {
+      return NULL;
+    }
+  }
+}
+
+static bool next_block(InputStream_t *stream) {
+  pthread_mutex_lock(&stream->lock);
+
+  // give the block that was read back to the reader
+  if (stream->has_block) {
+    stream->head = (stream->head + 1) % INPUT_STREAM_BLOCKS;
+    stream->count--;
+    pthread_cond_signal(&stream->drained);
+  }
+
+  while (stream->count == 0 && !stream->end) {
+    pthread_cond_wait(&stream->filled, &stream->lock);
+  }
+  stream->has_block = stream->count > 0;
+
+  pthread_mutex_unlock(&stream->lock);
+  stream->position = 0;
+  return stream->has_block;
+}
+
+/*** function(s) ***/
+bool input_stream_needed(char *file_name) {
+  if (strcmp(file_name, "-") == 0) {
+    return true;
+  }
+
+  // a missing file is left for the parser to report
+  struct stat status;
+  if (stat(file_name, &status) != 0) {
+    return false;
+  }
+  if (!S_ISREG(status.st_mode)) {
+    return true;
+  }
+
+  uint8_t magic[sizeof(zstd_magic)];
+  size_t length = 0;
+  FILE *file = fopen(file_name, "rb");
+  if (file != NULL) {
+    length = fread(magic, 1, sizeof(magic), file);
+    fclose(file);
+  }
+
+  return detect_compression(magic, length) != INPUT_PLAIN;
+}
+
+InputStream_t *input_stream_open(char *file_name) {
+  InputStream_t *stream = allocate(sizeof(InputStream_t));
+  memset(stream, 0, sizeof(InputStream_t));
+
+  stream->fd = strcmp(file_name, "-") == 0 ? STDIN_FILENO : open(file_name, O_RDONLY);
+  if (stream->fd < 0) {
+    perror("Error opening file");
+    exit(EXIT_FAILURE);
+  }
+
+  for (int i = 0; i < INPUT_STREAM_BLOCKS; i++) {
+    stream->blocks[i] = allocate(INPUT_STREAM_BLOCK_SIZE);
+  }
+  stream->raw = allocate(INPUT_STREAM_READ_SIZE);
+
+  pthread_mutex_init(&stream->lock, NULL);
+  pthread_cond_init(&stream->filled, NULL);
+  pthread_cond_init(&stream->drained, NULL);
+  if (pthread_create(&stream->reader, NULL, reader_thread, stream) != 0) {
+    fprintf(stderr, "Error: cannot start the input reader thread\n");
+    exit(EXIT_FAILURE);
+  }
+
+  return stream;
+}
+
+bool input_stream_gets(InputStream_t *stream, char *line, size_t size) {
+  size_t used = 0;
+
+  while (used + 1 < size) {
+    if (!stream->has_block || stream->position == stream->block_lengths[stream->head]) {
+      if (!next_block(stream)) {
+        break;
+      }
+      continue;
+    }
+
+    char *data = stream->blocks[stream->head] + stream->position;
+    size_t length = stream->block_lengths[stream->head] - stream->position;
+    if (length > size - 1 - used) {
+      length = size - 1 - used;
+    }
+
+    char *newline = memchr(data, '\n', length);
+    if (newline != NULL) {
+      length = newline - data + 1;
+    }
+
+    memcpy(line + used, data, length);
+    used += length;
+    stream->position += length;
+    stream->offset += length;
+
+    if (newline != NULL) {
+      break;
+    }
+  }
+
+  line[used] = '\0';
+  return used > 0;
+}
+
+size_t input_stream_read(InputStream_t *stream, void *buffer, size_t size) {
+  size_t used = 0;
+
+  while (used < size) {
+    if (!stream->has_block || stream->position == stream->block_lengths[stream->head]) {
+      if (!next_block(stream)) {
+        break;
+      }
+      continue;
+    }
+
+    size_t length = stream->block_lengths[stream->head] - stream->position;
+    if (length > size - used) {
+      length = size - used;
+    }
+
+    memcpy((char *)buffer + used, stream->blocks[stream->head] + stream->position, length);
+    used += length;
+    stream->position += length;
+    stream->offset += length;
+  }
+
+  return used;
+}
+
+uint64_t input_stream_tell(InputStream_t *stream) {
+  return stream->offset;
+}
+
+bool input_stream_skip(InputStream_t *stream, uint64_t offset) {
+  if (offset < stream->offset) {
+    return false;
+  }
+
+  while (stream->offset < offset) {
+    if (!stream->has_block || stream->position == stream->block_lengths[stream->head]) {
+      if (!next_block(stream)) {
+        return false;
+      }
+      continue;
+    }
+
+    uint64_t length = stream->block_lengths[stream->head] - stream->position;
+    if (length > offset - stream->offset) {
+      length = offset - stream->offset;
+    }
+    stream->position += length;
+    stream->offset += length;
+  }
+
+  return true;
+}
+
+void input_stream_close(InputStream_t *stream) {
+  if (stream == NULL) {
+    return;
+  }
+
+  pthread_mutex_lock(&stream->lock);
+  stream->stop = true;
+  pthread_cond_signal(&stream->drained);
+  pthread_mutex_unlock(&stream->lock);
+
+  // a reader still waiting on a pipe is cancelled in read()
+  pthread_cancel(stream->reader);
+  pthread_join(stream->reader, NULL);
+
+  stop_decoder(stream);
+  if (stream->fd != STDIN_FILENO) {
+    close(stream->fd);
+  }
+
+  for (int i = 0; i < INPUT_STREAM_BLOCKS; i++) {
+    free(stream->blocks[i]);
+  }
+  free(stream->raw);
+  pthread_mutex_destroy(&stream->lock);
+  pthread_cond_destroy(&stream->filled);
+  pthread_cond_destroy(&stream->drained);
+  free(stream);
+}
@@ -0,0 +1,280 @@
+/**
+ * @file  interval_stats.c
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "interval_stats.h"
+
+#define CSV_HEADER "interval,start_cycle,cycles,scope,id,reads,writes,bandwidth_gbps,row_hit_rate,avg_latency,p99_latency,avg_queue,max_queue"
+
+static const char *format_names[] = {
+  [INTERVAL_CSV] = "csv",
+  [INTERVAL_BINARY] = "binary",
+};
+
+static const char *scope_names[] = {
+  [INTERVAL_CHANNEL] = "channel",
+  [INTERVAL_CORE] = "core",
+};
+
+/*** helper function(s) ***/
+static uint16_t latency_bucket(uint64_t latency) {
+  if (latency < INTERVAL_LATENCY_SUB_BUCKETS) {
+    return latency;
+  }
+
+  // the leading bit picks the power of two, the three bits below it the sub-bucket
+  int exponent = 63 - __builtin_clzll(latency);
+  return (exponent - 2) * INTERVAL_LATENCY_SUB_BUCKETS + ((latency >> (exponent - 3)) & (INTERVAL_LATENCY_SUB_BUCKETS - 1));
+}
+
+static uint64_t bucket_upper_bound(uint16_t bucket) {
+  if (bucket < 2 * INTERVAL_LATENCY_SUB_BUCKETS) {
+    return bucket;
+  }
+
+  int exponent = bucket / INTERVAL_LATENCY_SUB_BUCKETS + 2;
+  uint64_t lower = (uint64_t)(INTERVAL_LATENCY_SUB_BUCKETS + bucket % INTERVAL_LATENCY_SUB_BUCKETS) << (exponent - 3);
+  return lower + ((uint64_t)1 << (exponent - 3)) - 1;
+}
+
+static uint64_t p99_latency(IntervalCounters_t *counters) {
+  uint64_t completed = counters->reads + counters->writes;
+  if (completed == 0) {
+    return 0;
+  }
+
+  uint64_t rank = (completed * 99 + 99) / 100;  // ceil(0.99 * completed)
+  uint64_t seen = 0;
+  for (uint16_t bucket = 0; bucket < INTERVAL_LATENCY_BUCKETS; bucket++) {
+    seen += counters->latency_histogram[bucket];
+    if (seen >= rank) {
+      uint64_t upper = bucket_upper_bound(bucket);
+      return upper < counters->max_latency ? upper : counters->max_latency;
+    }
+  }
+
+  return counters->max_latency;
+}
+
+static void change_occupancy(IntervalCounters_t *counters, uint64_t cycle, int delta) {
+  counters->queue_cycles += counters->occupancy * (cycle - counters->queue_since);
+  counters->queue_since = cycle;
+  counters->occupancy += delta;
+  if (counters->occupancy > counters->max_occupancy) {
+    counters->max_occupancy = counters->occupancy;
+  }
+}
+
+static void reset_counters(IntervalCounters_t *counters, uint64_t start) {
+  // the queue carries over from one interval to the next
+  uint16_t occupancy = counters->occupancy;
+  bool has_latencies = counters->reads + counters->writes > 0;
+
+  counters->reads = 0;
+  counters->writes = 0;
+  counters->activates = 0;
+  counters->column_commands = 0;
+  counters->total_latency = 0;
+  counters->max_latency = 0;
+  counters->queue_cycles = 0;
+  counters->queue_since = start;
+  counters->occupancy = occupancy;
+  counters->max_occupancy = occupancy;
+  if (has_latencies) {
+    memset(counters->latency_histogram, 0, sizeof(counters->latency_histogram));
+  }
+}
+
+static void write_counters(IntervalStats_t *intervals, IntervalScope_t scope, uint8_t id, IntervalCounters_t *counters, uint64_t cycles) {
+  uint64_t completed = counters->reads + counters->writes;
+
+  if (intervals->format == INTERVAL_BINARY) {
+    IntervalRecord_t record = {
+      .interval = intervals->index,
+      .scope = scope,
+      .id = id,
+      .max_occupancy = counters->max_occupancy,
+      .cycles = cycles,
+      .reads = counters->reads,
+      .writes = counters->writes,
+      .activates = counters->activates,
+      .column_commands = counters->column_commands,
+      .p99_latency = p99_latency(counters),
+      .total_latency = counters->total_latency,
+      .queue_cycles = counters->queue_cycles,
+    };
+    fwrite(&record, sizeof(record), 1, intervals->file);
+    return;
+  }
+
+  // a DIMM cycle is two transfers, data_rate is in millions of them per second
+  double seconds = 2.0 * cycles / (intervals->data_rate * 1e6);
+  double hits = counters->column_commands > counters->activates ? counters->column_commands - counters->activates : 0;
+
+  fprintf(intervals->file, "%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%s,%u,%u,%u,%.3lf,%.3lf,%.1lf,%" PRIu64 ",%.2lf,%u\n",
+          intervals->index, intervals->start, cycles, scope_names[scope], id, counters->reads, counters->writes,
+          stats_bandwidth_gbps(completed, seconds),
+          counters->column_commands ? hits / counters->column_commands : 0.0,
+          completed ? (double)counters->total_latency / completed : 0.0,
+          p99_latency(counters),
+          (double)counters->queue_cycles / cycles,
+          counters->max_occupancy);
+}
+
+static void write_interval(IntervalStats_t *intervals, uint64_t end) {
+  uint64_t cycles = end - intervals->start;
+
+  for (uint8_t channel = 0; channel < NUM_CHANNELS; channel++) {
+    if (intervals->channel_seen[channel]) {
+      change_occupancy(&intervals->channels[channel], end, 0);
+      write_counters(intervals, INTERVAL_CHANNEL, channel, &intervals->channels[channel], cycles);
+    }
+  }
+
+  for (uint8_t core = 0; core < NUM_CORES; core++) {
+    change_occupancy(&intervals->cores[core], end, 0);
+    write_counters(intervals, INTERVAL_CORE, core, &intervals->cores[core], cycles);
+  }
+}
+
+static void start_interval(IntervalStats_t *intervals, uint64_t index) {
+  intervals->index = index;
+  intervals->start = index * intervals->interval_cycles;
+  intervals->end = intervals->start + intervals->interval_cycles;
+
+  for (int channel = 0; channel < NUM_CHANNELS; channel++) {
+    reset_counters(&intervals->channels[channel], intervals->start);
+  }
+  for (int core = 0; core < NUM_CORES; core++) {
+    reset_counters(&intervals->cores[core], intervals->start);
+  }
+}
+
+/*** function(s) ***/
+void interval_stats_init(IntervalStats_t *intervals, char *file_name, IntervalFormat_t format, uint64_t interval_cycles, DIMM_t *dimm) {
+  memset(intervals, 0, sizeof(IntervalStats_t));
+
+  intervals->file = fopen(file_name, format == INTERVAL_BINARY ? "wb" : "w");
+  if (intervals->file == NULL) {
+    fprintf(stderr, "%s:%d: fopen failed\n", __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  intervals->format = format;
+  intervals->interval_cycles = interval_cycles;
+  intervals->data_rate = dimm->time_base.data_rate;
+  start_interval(intervals, 0);
+
+  if (format == INTERVAL_BINARY) {
+    IntervalBinaryHeader_t header;
+    memset(&header, 0, sizeof(header));
+
+    memcpy(header.magic, INTERVAL_BINARY_MAGIC, sizeof(header.magic));
+    header.version = INTERVAL_BINARY_VERSION;
+    header.record_size = sizeof(IntervalRecord_t);
+    header.num_channels = NUM_CHANNELS;
+    header.num_cores = NUM_CORES;
+    header.interval_cycles = interval_cycles;
+    header.cpu_mhz = dimm->time_base.cpu_mhz;
+    header.data_rate = dimm->time_base.data_rate;
+    fwrite(&header, sizeof(header), 1, intervals->file);
+  }
+  else {
+    fprintf(intervals->file, "%s\n", CSV_HEADER);
+  }
+}
+
+void interval_stats_resume(IntervalStats_t *intervals, Queue_t *queue, uint64_t cycle) {
+  // the first interval is counted from the restore cycle on
+  start_interval(intervals, cycle / intervals->interval_cycles);
+  intervals->start = cycle;
+  for (int channel = 0; channel < NUM_CHANNELS; channel++) {
+    intervals->channels[channel].queue_since = cycle;
+  }
+  for (int core = 0; core < NUM_CORES; core++) {
+    intervals->cores[core].queue_since = cycle;
+  }
+
+  for (uint8_t i = 0; i < queue->size; i++) {
+    interval_stats_enqueue(intervals, queue_peek_at(queue, i), cycle);
+  }
+}
+
+void interval_stats_enqueue(IntervalStats_t *intervals, MemoryRequest_t *request, uint64_t cycle) {
+  intervals->channel_seen[request->channel] = true;
+  change_occupancy(&intervals->channels[request->channel], cycle, 1);
+
+  if (!request->is_prefetch) {
+    change_occupancy(&intervals->cores[request->core], cycle, 1);
+  }
+}
+
+void interval_stats_command(IntervalStats_t *intervals, MemoryRequest_t *request, CommandCode_t command) {
+  IntervalCounters_t *channel = &intervals->channels[request->channel];
+  IntervalCounters_t *core = request->is_prefetch ? NULL : &intervals->cores[request->core];
+
+  // the first half of each command is enough to count it
+  if (command == COMMAND_ACT0) {
+    channel->activates++;
+    if (core != NULL) {
+      core->activates++;
+    }
+  }
+  else if (command == COMMAND_RD0 || command == COMMAND_WR0) {
+    channel->column_commands++;
+    if (core != NULL) {
+      core->column_commands++;
+    }
+  }
+}
+
+void interval_stats_complete(IntervalStats_t *intervals, MemoryRequest_t *request, uint64_t cycle, uint64_t latency) {
+  IntervalCounters_t *scopes[2] = {
+    &intervals->channels[request->channel],
+    request->is_prefetch ? NULL : &intervals->cores[request->core]
+  };
+  uint16_t bucket = latency_bucket(latency);
+
+  for (int i = 0; i < 2 && scopes[i] != NULL; i++) {
+    IntervalCounters_t *counters = scopes[i];
+
+    change_occupancy(counters, cycle, -1);
+    if (request->operation == DATA_WRITE) {
+      counters->writes++;
+    }
+    else {
+      counters->reads++;
+    }
+    counters->total_latency += latency;
+    if (latency > counters->max_latency) {
+      counters->max_latency = latency;
+    }
+    counters->latency_histogram[bucket]++;
+  }
+}
+
+void interval_stats_flush(IntervalStats_t *intervals) {
+  write_interval(intervals, intervals->end);
+  start_interval(intervals, intervals->index + 1);
+}
+
+void interval_stats_close(IntervalStats_t *intervals, uint64_t cycle) {
+  interval_stats_advance(intervals, cycle);
+  write_interval(intervals, cycle + 1);
+
+  fclose(intervals->file);
+  intervals->file = NULL;
+}
+
+int interval_stats_parse_format(const char *name) {
+  for (int i = 0; i < (int)(sizeof(format_names) / sizeof(format_names[0])); i++) {
+    if (strcmp(name, format_names[i]) == 0) {
+      return i;
+    }
+  }
+
+  return -1;
+}
@@ -0,0 +1,310 @@
+/**
+ * @file  load_curve.c
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include <math.h>
+#include <unistd.h>
+#include "load_curve.h"
+
+/*** helper function(s) ***/
+static void scan_trace(Config_t *config, LoadTrace_t *trace) {
+  Parser_t *parser = parser_init(config->input_file, config->trace_format, config->address_policy);
+  MemoryRequest_t request;
+
+  memset(trace, 0, sizeof(LoadTrace_t));
+  while (parser_next_request(parser, UINT64_MAX, &request)) {
+    if (trace->requests == 0) {
+      trace->first_time = request.time;
+    }
+    trace->last_time = request.time;
+    trace->requests++;
+  }
+
+  parser_destroy(parser);
+}
+
+static double offered_gbps(LoadTrace_t *trace, TimeBase_t *time_base, double intensity) {
+  return stats_bandwidth_gbps(trace->requests, time_base_seconds(time_base, trace->last_time - trace->first_time) / intensity);
+}
+
+static bool meets_slo(LoadPoint_t *point, Config_t *config) {
+  return point->completed_requests > 0 && point->average_latency <= config->latency_slo;
+}
+
+static void simulate_point(LoadPoint_t *point, Config_t *base) {
+  Config_t config = *base;
+  config.scheduling_policy = point->level;
+  config.num_outputs = 0;  // only the statistics are kept
+  config.print_stats = false;
+  config.restore_file = NULL;
+
+  Simulator_t *sim = simulator_create(&config);
+  parser_set_intensity(sim->parser, point->intensity);
+  uint64_t first_arrival = sim->parser->status == OK ? sim->parser->next_request.time : 0;
+
+  while (simulator_step(sim)) {
+  }
+
+  Stats_t *stats = &sim->dimm->stats;
+  point->completed_requests = stats->completed_requests;
+  point->average_latency = stats_average_latency(stats);
+  point->max_latency = stats->max_latency;
+  point->final_cycle = sim->clock_cycle;
+  point->achieved_gbps = stats_bandwidth_gbps(stats->completed_requests,
+                                              time_base_seconds(&sim->dimm->time_base, sim->clock_cycle - first_arrival));
+  simulator_destroy(sim);
+}
+
+static void *load_worker(void *arg) {
+  LoadPool_t *pool = (LoadPool_t *)arg;
+
+  while (true) {
+    pthread_mutex_lock(&pool->lock);
+    uint64_t i = pool->next_point++;
+    pthread_mutex_unlock(&pool->lock);
+
+    if (i >= pool->num_points) {
+      return NULL;
+    }
+    simulate_point(&pool->points[i], pool->config);
+  }
+}
+
+static void run_points(LoadPool_t *pool, uint64_t first, uint64_t threads) {
+  pthread_t workers[threads];
+
+  pool->next_point = first;
+  if (threads > pool->num_points - first) {
+    threads = pool->num_points - first;
+  }
+
+  for (uint64_t i = 0; i < threads; i++) {
+    if (pthread_create(&workers[i], NULL, load_worker, pool) != 0) {
+      fprintf(stderr, "%s:%d: pthread_create failed\n", __FILE__, __LINE__);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  for (uint64_t i = 0; i < threads; i++) {
+    pthread_join(workers[i], NULL);
+  }
+}
+
+static void add_point(LoadPool_t *pool, uint8_t level, double intensity) {
+  LoadPoint_t *point = &pool->points[pool->num_points++];
+
+  memset(point, 0, sizeof(LoadPoint_t));
+  point->level = level;
+  point->intensity = intensity;
+}
+
+// the highest passing intensity below the lowest failing one, 0 if none passes
+static void find_bracket(LoadPool_t *pool, uint8_t level, double *passing, double *failing) {
+  *passing = 0.0;
+  *failing = INFINITY;
+
+  for (uint64_t i = 0; i < pool->num_points; i++) {
+    LoadPoint_t *point = &pool->points[i];
+    if (point->level == level && !meets_slo(point, pool->config) && point->intensity < *failing) {
+      *failing = point->intensity;
+    }
+  }
+
+  for (uint64_t i = 0; i < pool->num_points; i++) {
+    LoadPoint_t *point = &pool->points[i];
+    if (point->level == level && meets_slo(point, pool->config) && point->intensity < *failing && point->intensity > *passing) {
+      *passing = point->intensity;
+    }
+  }
+}
+
+static int compare_scales(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+static int compare_points(const void *a, const void *b) {
+  const LoadPoint_t *x = a, *y = b;
+
+  if (x->level != y->level) {
+    return x->level < y->level ? -1 : 1;
+  }
+  return (x->intensity > y->intensity) - (x->intensity < y->intensity);
+}
+
+static void print_curves(LoadPool_t *pool, LoadTrace_t *trace, TimeBase_t *time_base, uint8_t num_levels) {
+  Config_t *config = pool->config;
+
+  printf("--- Load-Latency Curve ---\n");
+  printf("Trace: %" PRIu64 " requests over %" PRIu64 " CPU cycles, %.3lf GB/s offered at intensity 1\n", trace->requests,
+         trace->last_time - trace->first_time, offered_gbps(trace, time_base, 1.0));
+  printf("Latency SLO: %" PRIu64 " CPU cycles average\n", config->latency_slo);
+
+  for (uint8_t level = 0; level < num_levels; level++) {
+    double passing, failing;
+    LoadPoint_t *best = NULL;
+
+    find_bracket(pool, level, &passing, &failing);
+    printf("Level %d (%s)\n", level, scheduler_get(level)->name);
+    printf("%10s %12s %13s %12s %12s %4s\n", "Intensity", "Offered GB/s", "Achieved GB/s", "Avg Latency", "Max Latency", "SLO");
+
+    for (uint64_t i = 0; i < pool->num_points; i++) {
+      LoadPoint_t *point = &pool->points[i];
+      if (point->level != level) {
+        continue;
+      }
+      if (point->intensity == passing) {
+        best = point;
+      }
+      printf("%10.4lf %12.3lf %13.3lf %12.2lf %12" PRIu64 " %4s\n", point->intensity, offered_gbps(trace, time_base, point->intensity),
+             point->achieved_gbps, point->average_latency, point->max_latency, meets_slo(point, config) ? "ok" : "miss");
+    }
+
+    if (best == NULL) {
+      printf("Max Sustainable: none, the SLO is missed at intensity %.4lf\n", failing);
+    }
+    else if (isinf(failing)) {
+      printf("Max Sustainable: at least %.3lf GB/s (intensity %.4lf, the SLO is met at every load tried)\n", best->achieved_gbps,
+             best->intensity);
+    }
+    else {
+      printf("Max Sustainable: %.3lf GB/s (intensity %.4lf, the SLO is missed at %.4lf)\n", best->achieved_gbps, best->intensity,
+             failing);
+    }
+  }
+  printf("--------------------------\n");
+}
+
+static void write_csv(LoadPool_t *pool, LoadTrace_t *trace, TimeBase_t *time_base) {
+  FILE *file = fopen(pool->config->load_curve_file, "w");
+  if (file == NULL) {
+    perror("Error opening load curve file");
+    exit(EXIT_FAILURE);
+  }
+
+  fprintf(file, "level,policy,intensity,offered_gbps,achieved_gbps,average_latency,max_latency,meets_slo\n");
+  for (uint64_t i = 0; i < pool->num_points; i++) {
+    LoadPoint_t *point = &pool->points[i];
+    fprintf(file, "%d,%s,%.6lf,%.6lf,%.6lf,%.4lf,%" PRIu64 ",%d\n", point->level, scheduler_get(point->level)->name, point->intensity,
+            offered_gbps(trace, time_base, point->intensity), point->achieved_gbps, point->average_latency, point->max_latency,
+            meets_slo(point, pool->config));
+  }
+
+  fclose(file);
+}
+
+/*** function(s) ***/
+void run_load_curve(Config_t *config) {
+  LoadTrace_t trace;
+  TimeBase_t time_base;
+  LoadPool_t pool;
+
+  // every simulator maps addresses with the same rank bits
+  memory_request_set_rank_bits(config_rank_bits(config));
+  scan_trace(config, &trace);
+  if (trace.requests == 0) {
+    fprintf(stderr, "Error: %s has no requests\n", config->input_file);
+    exit(EXIT_FAILURE);
+  }
+  time_base_init(&time_base, config->cpu_mhz, config->data_rate);
+
+  uint8_t num_levels = 0;
+  while (scheduler_get(num_levels) != NULL) {
+    num_levels++;
+  }
+
+  uint64_t threads = config->load_threads;
+  if (threads == 0) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = cpus > 0 ? (uint64_t)cpus : 1;
+  }
+
+  pool.config = config;
+  pool.num_points = 0;
+  pool.points = malloc(sizeof(LoadPoint_t) * num_levels * (config->num_load_scales + LOAD_SEARCH_ROUNDS * MAX_LOAD_SPLITS));
+  if (pool.points == NULL) {
+    fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+  pthread_mutex_init(&pool.lock, NULL);
+
+  for (uint8_t level = 0; level < num_levels; level++) {
+    for (int i = 0; i < config->num_load_scales; i++) {
+      add_point(&pool, level, config->load_scales[i]);
+    }
+  }
+  run_points(&pool, 0, threads);
+
+  // narrow each open bracket, the threads shared among the levels still searching
+  for (int round = 0; round < LOAD_SEARCH_ROUNDS; round++) {
+    double passing[num_levels], failing[num_levels];
+    uint64_t searching = 0;
+
+    for (uint8_t level = 0; level < num_levels; level++) {
+      find_bracket(&pool, level, &passing[level], &failing[level]);
+      if (!isinf(failing[level])) {
+        searching++;
+      }
+    }
+    if (searching == 0) {
+      break;
+    }
+
+    uint64_t splits = threads / searching;
+    splits = splits < 1 ? 1 : splits > MAX_LOAD_SPLITS ? MAX_LOAD_SPLITS : splits;
+
+    uint64_t first = pool.num_points;
+    for (uint8_t level = 0; level < num_levels; level++) {
+      if (isinf(failing[level])) {
+        continue;
+      }
+      for (uint64_t j = 1; j <= splits; j++) {
+        if (passing[level] > 0.0) {
+          add_point(&pool, level, passing[level] * pow(failing[level] / passing[level], (double)j / (splits + 1)));
+        }
+        else {
+          add_point(&pool, level, failing[level] / pow(LOAD_PROBE_FACTOR, j));  // nothing passes yet, probe lower loads
+        }
+      }
+    }
+    run_points(&pool, first, threads);
+  }
+
+  qsort(pool.points, pool.num_points, sizeof(LoadPoint_t), compare_points);
+  print_curves(&pool, &trace, &time_base, num_levels);
+  write_csv(&pool, &trace, &time_base);
+  printf("Simulations: %" PRIu64 " on %" PRIu64 " thread(s), points written to %s\n", pool.num_points, threads, config->load_curve_file);
+
+  pthread_mutex_destroy(&pool.lock);
+  free(pool.points);
+}
+
+int load_curve_parse_scales(const char *list, double *scales, int max_scales) {
+  int count = 0;
+  const char *cursor = list;
+
+  while (*cursor != '\0') {
+    char *end;
+    double scale = strtod(cursor, &end);
+
+    if (end == cursor || !(scale > 0.0) || isinf(scale) || count == max_scales || (*end != ',' && *end != '\0')) {
+      return -1;
+    }
+    scales[count++] = scale;
+    cursor = *end == ',' ? end + 1 : end;
+  }
+
+  // increasing, without repeats
+  qsort(scales, count, sizeof(double), compare_scales);
+  int unique = 0;
+  for (int i = 0; i < count; i++) {
+    if (unique == 0 || scales[i] != scales[unique - 1]) {
+      scales[unique++] = scales[i];
+    }
+  }
+
+  return unique;
+}
@@ -20,180 +20,792 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
+#include "checkpoint.h"
 #include "common.h"
-#include "dimm.h"
-#include "memory_request.h"
-#include "parser.h"
-#include "queue.h"
+#include "config.h"
+#include "epoch.h"
+#include "load_curve.h"
+#include "preset.h"
+#include "sampling.h"
+#include "simulator.h"
 
 /*** macro(s), enum(s), and struct(s) ***/
-#define MAX_QUEUE_SIZE 16
-#define DEFAULT_INPUT_FILE "trace.txt"
-#define DEFAULT_OUTPUT_FILE "dram.txt"
+enum LongOptions {
+  OPT_STATS = 256,
+  OPT_TRACE_FORMAT,
+  OPT_ADDRESS_MAP,
+  OPT_OUTPUT,
+  OPT_PRESET,
+  OPT_GENERIC_ENGINE,
+  OPT_COMMAND_RATE,
+  OPT_ADMIT_WIDTH,
+  OPT_CPU_MHZ,
+  OPT_DATA_RATE,
+  OPT_BURST_LENGTH,
+  OPT_BURST_CHOP,
+  OPT_DIMMS,
+  OPT_RANKS,
+  OPT_PREFETCH,
+  OPT_PREFETCH_DEGREE,
+  OPT_CLOSED_LOOP,
+  OPT_MLP,
+  OPT_DEPENDENCY,
+  OPT_CHECKPOINT,
+  OPT_CHECKPOINT_INTERVAL,
+  OPT_RESTORE,
+  OPT_SAMPLE,
+  OPT_SAMPLE_PERIOD,
+  OPT_SAMPLE_WARMUP,
+  OPT_SAMPLE_WINDOW,
+  OPT_TIMELINE,
+  OPT_TIMELINE_WINDOW,
+  OPT_INTERVAL_STATS,
+  OPT_INTERVAL_FILE,
+  OPT_INTERVAL_FORMAT,
+  OPT_HOT_ROWS,
+  OPT_HOT_ROWS_INTERVAL,
+  OPT_HOT_ROWS_FILE,
+  OPT_RFM,
+  OPT_RAA_IMT,
+  OPT_RAA_MMT,
+  OPT_PRAC,
+  OPT_PRAC_RFMS,
+  OPT_DUEL,
+  OPT_DUEL_EPOCH,
+  OPT_DUEL_SAMPLE,
+  OPT_LOAD_CURVE,
+  OPT_LATENCY_SLO,
+  OPT_LOAD_THREADS,
+  OPT_LOAD_CURVE_FILE,
+  OPT_EPOCHS,
+  OPT_EPOCH_WARMUP
+};
 
 /*** function prototype(s) ***/
-void process_args(int argc, char *argv[], char **input_file, char **output_file, int *scheduling_policy);
-void out_of_order(Queue_t *global_queue, MemoryRequest_t *current_request);
-void advance_clock(uint64_t *clock_cycle, Queue_t *global_queue, Parser_t *parser);
+void process_args(int argc, char *argv[], Config_t *config);
+void run_specialized_build(char *argv[], Config_t *config);
 
 /*** function(s) ***/
 int main(int argc, char *argv[]) {
   clock_t begin_execution = clock();
-  char *input_file_name, *output_file_name;
-  int scheduling_policy = 0;  // default is level 0
-  process_args(argc, argv, &input_file_name, &output_file_name, &scheduling_policy);
+  Config_t config;
+  config_init(&config);
+#ifdef FIXED_PRESET
+  // a specialized build starts from its preset and runs nothing else
+  config.preset = FIXED_PRESET;
+  preset_apply(&FIXED_PRESET_ENTRY, &config);
+#endif
+  process_args(argc, argv, &config);
+  run_specialized_build(argv, &config);
 
   printf("--- Simulation Parameters ---\n");
-  printf("Scheduling Policy Level: %d\n", scheduling_policy);
-  printf("Input File: %s\n", input_file_name);
-  printf("Output File: %s\n", output_file_name);
+  printf("Scheduling Policy Level: %d\n", config.scheduling_policy);
+#ifdef FIXED_PRESET
+  printf("Preset: %s (specialized build)\n", FIXED_PRESET_ENTRY.name);
+#else
+  if (config.preset >= 0) {
+    printf("Preset: %s\n", preset_get(config.preset)->name);
+  }
+#endif
+  printf("Input File: %s\n", config.input_file);
+  if (config.trace_format != TRACE_NATIVE || config.address_policy != ADDRESS_REJECT) {
+    printf("Trace Format: %s, %s out-of-range addresses\n", trace_format_name(config.trace_format),
+           address_policy_name(config.address_policy));
+  }
+  printf("Output File: %s\n", config.output_file);
+  if (config.num_outputs != 1 || config.output_kinds[0] != SINK_TEXT) {
+    printf("Outputs:");
+    for (int i = 0; i < config.num_outputs; i++) {
+      printf(" %s", output_sink_name(config.output_kinds[i]));
+      if (config.output_files[i] != NULL) {
+        printf(":%s", config.output_files[i]);
+      }
+    }
+    printf("\n");
+  }
+  printf("Command Rate: %dN\n", config.command_rate);
+  if (config.admit_width != 1) {
+    printf("Admission Width: %d requests per cycle\n", config.admit_width);
+  }
+  if (config.cpu_mhz != DEFAULT_CPU_MHZ || config.data_rate != DEFAULT_DATA_RATE) {
+    printf("Clocks: %u MHz CPU, DDR5-%u\n", config.cpu_mhz, config.data_rate);
+  }
+  if (config.dimms_per_channel * config.ranks_per_dimm > 1) {
+    printf("Topology: %dDPC, %d rank(s) per DIMM\n", config.dimms_per_channel, config.ranks_per_dimm);
+  }
+  if (config.closed_loop) {
+    printf("Closed Loop: MLP %d, %s dependencies\n", config.core_mlp, core_model_dependency_name(config.dependency));
+  }
+  if (config.prefetch) {
+    printf("Prefetcher: degree %d\n", config.prefetch_degree);
+  }
+  if (config.burst_length != 16 || config.burst_chop) {
+    printf("Burst Length: %s\n", config.burst_chop ? "BC8" : "BL32");
+  }
+  if (config.timeline_file != NULL) {
+    printf("Timeline: %s", config.timeline_file);
+    if (config.timeline_end != UINT64_MAX) {
+      printf(", DIMM cycles %" PRIu64 " to %" PRIu64, config.timeline_start, config.timeline_end);
+    }
+    printf("\n");
+  }
+  if (config.interval_cycles > 0) {
+    printf("Interval Statistics: every %" PRIu64 " DIMM cycles to %s\n", config.interval_cycles, config.interval_file);
+  }
+  if (config.rfm_mode != RFM_OFF) {
+    printf("RFM: RFM%s, RAAIMT %u, RAAMMT %u\n", rowhammer_mode_name(config.rfm_mode), config.raa_imt, config.raa_mmt);
+  }
+  if (config.prac_threshold > 0) {
+    printf("PRAC: back-off at %u activations, %u RFMab\n", config.prac_threshold, config.prac_rfms);
+  }
+  if (config.hot_rows > 0) {
+    printf("Hot Rows: top %d", config.hot_rows);
+    if (config.hot_rows_interval > 0) {
+      printf(", every %" PRIu64 " DIMM cycles to %s", config.hot_rows_interval, config.hot_rows_file);
+    }
+    printf("\n");
+  }
+  if (config.num_duel_policies > 0) {
+    printf("Policy Dueling: levels");
+    for (int i = 0; i < config.num_duel_policies; i++) {
+      printf("%s%d", i == 0 ? " " : ",", config.duel_policies[i]);
+    }
+    printf(", epochs of %" PRIu64 " CPU cycles, shadows follow 1 bank in %d\n", config.duel_epoch, config.duel_sample);
+  }
+  if (config.num_load_scales > 0) {
+    printf("Load Curve: intensities");
+    for (int i = 0; i < config.num_load_scales; i++) {
+      printf("%s%g", i == 0 ? " " : ",", config.load_scales[i]);
+    }
+    printf(", SLO %" PRIu64 " CPU cycles, every level to %s\n", config.latency_slo, config.load_curve_file);
+  }
+  if (config.restore_file != NULL) {
+    printf("Restored From: %s\n", config.restore_file);
+  }
   printf("-----------------------------\n");
 
-  Parser_t *parser = parser_init(input_file_name);
-  DIMM_t *PC5_38400 = NULL;
-  Queue_t *global_queue = NULL;
-
-  dimm_create(&PC5_38400, output_file_name);    // create DIMM
-  queue_create(&global_queue, MAX_QUEUE_SIZE);  // create queue of size 16
+  if (config.num_load_scales > 0) {
+    run_load_curve(&config);
+    clock_t end_execution = clock();
+    printf("Program Execution Time: %lf seconds\n", (double)(end_execution - begin_execution) / CLOCKS_PER_SEC);
+    return 0;
+  }
 
-  uint64_t clock_cycle = 0;  // tracking the clock cycle (CPU clock). DIMM clock cycle is 1/2.
-  MemoryRequest_t *current_request = NULL;
+  if (config.sample || config.epochs > 1) {
+    uint64_t clock_cycle = config.sample ? run_sampled_simulation(&config) : run_epoch_parallel_simulation(&config);
+    clock_t end_execution = clock();
+    printf("Total Clock Cycles: %" PRIu64 "\n", clock_cycle);
+    printf("Program Execution Time: %lf seconds\n", (double)(end_execution - begin_execution) / CLOCKS_PER_SEC);
+    return 0;
+  }
 
-  while (true) {
-    if (current_request == NULL) {
-      current_request = parser_next_request(parser, clock_cycle);  // only returns the request if the current cycle >= request's time
-    }
+  Simulator_t *sim = config.restore_file != NULL ? checkpoint_restore(&config) : simulator_create(&config);
 
-    // DIMM clock cycle - only process request if there is one in the queue
-    if (clock_cycle % 2 == 0 && !queue_is_empty(global_queue)) {
-      process_request(&PC5_38400, &global_queue, clock_cycle, scheduling_policy);
-      increment_aging_in_queue(global_queue);
-    }
+  // the dueling shadows are not checkpointed, so a restored run could not go on dueling
+  checkpoint_install_signal_handler(config.num_duel_policies == 0);
+  uint64_t next_checkpoint = config.checkpoint_interval ? sim->clock_cycle + config.checkpoint_interval : UINT64_MAX;
 
-    // CPU clock cycle - enqueue if there is a request and queue is not full
-    if (current_request != NULL && !queue_is_full(global_queue)) {
-      if (scheduling_policy == LEVEL_3) {
-        out_of_order(global_queue, current_request);
+  while (simulator_step(sim)) {
+    if (sim->clock_cycle >= next_checkpoint || checkpoint_requested()) {
+      checkpoint_save(sim, config.checkpoint_file);
 
-      } else {
-        enqueue(&global_queue, *current_request);
+      if (config.checkpoint_interval) {
+        next_checkpoint = sim->clock_cycle + config.checkpoint_interval;
       }
-      log_memory_request("Enqueued:", current_request, clock_cycle);
-      free(current_request);
-      current_request = NULL;
-    }
-
-    if (parser->status == END_OF_FILE && queue_is_empty(global_queue)) {
-      LOG("END OF SIMULATION\n");
-      break;
     }
+  }
 
-    advance_clock(&clock_cycle, global_queue, parser);
+  if (config.print_stats) {
+    dimm_print_stats(sim->dimm, sim->clock_cycle, stdout);
   }
+  dimm_report_stats(sim->dimm, sim->clock_cycle);
 
-  parser_destroy(parser);
-  queue_destroy(&global_queue);
-  dimm_destroy(&PC5_38400);
+  uint64_t clock_cycle = sim->clock_cycle;
+  simulator_destroy(sim);
   clock_t end_execution = clock();
   printf("Total Clock Cycles: %" PRIu64 "\n", clock_cycle);
   printf("Program Execution Time: %lf seconds\n", (double)(end_execution - begin_execution) / CLOCKS_PER_SEC);
   return 0;
 }
 
-void advance_clock(uint64_t *clock_cycle, Queue_t *global_queue, Parser_t *parser) {
-  if (queue_is_empty(global_queue) && parser->next_request->time > *clock_cycle) {
-    LOG("No requests are processing. Advancing clock to next request time (%" PRIu64 ")\n", parser->next_request->time);
-    *clock_cycle = parser->next_request->time;
-  } else {
-    *clock_cycle += 1;
-  }
-}
-
-void process_args(int argc, char *argv[], char **input_file, char **output_file, int *scheduling_policy) {
+void process_args(int argc, char *argv[], Config_t *config) {
   int opt;
-  *input_file = DEFAULT_INPUT_FILE;
-  *output_file = DEFAULT_OUTPUT_FILE;
+  int scheduling_policy;
+
+  static struct option long_options[] = {
+    {"stats", no_argument, NULL, OPT_STATS},
+    {"trace-format", required_argument, NULL, OPT_TRACE_FORMAT},
+    {"address-map", required_argument, NULL, OPT_ADDRESS_MAP},
+    {"output", required_argument, NULL, OPT_OUTPUT},
+    {"preset", required_argument, NULL, OPT_PRESET},
+    {"generic-engine", no_argument, NULL, OPT_GENERIC_ENGINE},
+    {"command-rate", required_argument, NULL, OPT_COMMAND_RATE},
+    {"admit-width", required_argument, NULL, OPT_ADMIT_WIDTH},
+    {"cpu-mhz", required_argument, NULL, OPT_CPU_MHZ},
+    {"data-rate", required_argument, NULL, OPT_DATA_RATE},
+    {"burst-length", required_argument, NULL, OPT_BURST_LENGTH},
+    {"burst-chop", no_argument, NULL, OPT_BURST_CHOP},
+    {"dimms", required_argument, NULL, OPT_DIMMS},
+    {"ranks", required_argument, NULL, OPT_RANKS},
+    {"prefetch", no_argument, NULL, OPT_PREFETCH},
+    {"prefetch-degree", required_argument, NULL, OPT_PREFETCH_DEGREE},
+    {"closed-loop", no_argument, NULL, OPT_CLOSED_LOOP},
+    {"mlp", required_argument, NULL, OPT_MLP},
+    {"dependency", required_argument, NULL, OPT_DEPENDENCY},
+    {"checkpoint", required_argument, NULL, OPT_CHECKPOINT},
+    {"checkpoint-interval", required_argument, NULL, OPT_CHECKPOINT_INTERVAL},
+    {"restore", required_argument, NULL, OPT_RESTORE},
+    {"sample", no_argument, NULL, OPT_SAMPLE},
+    {"sample-period", required_argument, NULL, OPT_SAMPLE_PERIOD},
+    {"sample-warmup", required_argument, NULL, OPT_SAMPLE_WARMUP},
+    {"sample-window", required_argument, NULL, OPT_SAMPLE_WINDOW},
+    {"timeline", required_argument, NULL, OPT_TIMELINE},
+    {"timeline-window", required_argument, NULL, OPT_TIMELINE_WINDOW},
+    {"interval-stats", required_argument, NULL, OPT_INTERVAL_STATS},
+    {"interval-file", required_argument, NULL, OPT_INTERVAL_FILE},
+    {"interval-format", required_argument, NULL, OPT_INTERVAL_FORMAT},
+    {"hot-rows", required_argument, NULL, OPT_HOT_ROWS},
+    {"hot-rows-interval", required_argument, NULL, OPT_HOT_ROWS_INTERVAL},
+    {"hot-rows-file", required_argument, NULL, OPT_HOT_ROWS_FILE},
+    {"rfm", required_argument, NULL, OPT_RFM},
+    {"raa-imt", required_argument, NULL, OPT_RAA_IMT},
+    {"raa-mmt", required_argument, NULL, OPT_RAA_MMT},
+    {"prac", required_argument, NULL, OPT_PRAC},
+    {"prac-rfms", required_argument, NULL, OPT_PRAC_RFMS},
+    {"duel", required_argument, NULL, OPT_DUEL},
+    {"duel-epoch", required_argument, NULL, OPT_DUEL_EPOCH},
+    {"duel-sample", required_argument, NULL, OPT_DUEL_SAMPLE},
+    {"load-curve", required_argument, NULL, OPT_LOAD_CURVE},
+    {"latency-slo", required_argument, NULL, OPT_LATENCY_SLO},
+    {"load-threads", required_argument, NULL, OPT_LOAD_THREADS},
+    {"load-curve-file", required_argument, NULL, OPT_LOAD_CURVE_FILE},
+    {"epochs", required_argument, NULL, OPT_EPOCHS},
+    {"epoch-warmup", required_argument, NULL, OPT_EPOCH_WARMUP},
+    {"help", no_argument, NULL, 'h'},
+    {NULL, 0, NULL, 0}
+  };
 
-  while ((opt = getopt(argc, argv, "i:o:s:h")) != -1) {
+  while ((opt = getopt_long(argc, argv, "i:o:s:h", long_options, NULL)) != -1) {
     switch (opt) {
       case 'i':  // Input file
-        *input_file = optarg;
+        config->input_file = optarg;
         break;
       case 'o':  // Output file
-        *output_file = optarg;
+        config->output_file = optarg;
         break;
       case 's':  // Scheduling policy
-        *scheduling_policy = atoi(optarg);
-        if (*scheduling_policy < 0 || *scheduling_policy > 3) {
-          fprintf(stderr, "Invalid scheduling policy: %d. Must be between 0 and 3.\n", *scheduling_policy);
+        scheduling_policy = scheduler_find(optarg);
+        if (scheduling_policy < 0) {
+          fprintf(stderr, "Invalid scheduling policy: %s. Must be one of:\n", optarg);
+          scheduler_print_list(stderr);
+          exit(EXIT_FAILURE);
+        }
+        config->scheduling_policy = scheduling_policy;
+        break;
+      case OPT_TRACE_FORMAT:  // Format of the input trace
+        if (trace_format_parse(optarg) < 0) {
+          fprintf(stderr, "Invalid trace format: %s. Must be native, ramulator, dramsim3, champsim or perf-mem.\n", optarg);
+          exit(EXIT_FAILURE);
+        }
+        config->trace_format = trace_format_parse(optarg);
+        break;
+      case OPT_ADDRESS_MAP:  // Addresses the DIMM cannot hold
+        if (address_policy_parse(optarg) < 0) {
+          fprintf(stderr, "Invalid address map: %s. Must be reject, mask or fold.\n", optarg);
+          exit(EXIT_FAILURE);
+        }
+        config->address_policy = address_policy_parse(optarg);
+        break;
+      case OPT_STATS:  // Statistics summary
+        config->print_stats = true;
+        break;
+      case OPT_OUTPUT:  // Output sink, kind[:file]
+        if (config->num_outputs == MAX_OUTPUT_SINKS) {
+          fprintf(stderr, "Too many outputs: at most %d.\n", MAX_OUTPUT_SINKS);
+          exit(EXIT_FAILURE);
+        }
+        else {
+          // split a copy: argv is handed on unchanged to a specialized build
+          char *sink = strdup(optarg);
+          char *file_name = strchr(sink, ':');
+          if (file_name != NULL) {
+            *file_name++ = '\0';
+          }
+
+          int kind = output_parse_sink(sink);
+          if (kind < 0 || (kind == SINK_NONE && file_name != NULL)) {
+            fprintf(stderr, "Invalid output: %s. Must be none, text[:file], binary[:file] or stats[:file].\n", optarg);
+            exit(EXIT_FAILURE);
+          }
+          config->output_kinds[config->num_outputs] = kind;
+          config->output_files[config->num_outputs] = file_name;
+          config->num_outputs++;
+        }
+        break;
+      case OPT_PRESET:  // Named DIMM configuration
+        config->preset = preset_find(optarg);
+        if (config->preset < 0) {
+          fprintf(stderr, "Invalid preset: %s. Must be one of:\n", optarg);
+          preset_print_list(stderr);
+          exit(EXIT_FAILURE);
+        }
+        preset_apply(preset_get(config->preset), config);
+        break;
+      case OPT_GENERIC_ENGINE:  // Stay in this binary
+        config->generic_engine = true;
+        break;
+      case OPT_COMMAND_RATE:  // 1N or 2N
+        config->command_rate = atoi(optarg);
+        if (config->command_rate != 1 && config->command_rate != 2) {
+          fprintf(stderr, "Invalid command rate: %s. Must be 1 (1N) or 2 (2N).\n", optarg);
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_ADMIT_WIDTH:  // Requests admitted per CPU cycle
+        config->admit_width = atoi(optarg);
+        if (config->admit_width < 1 || config->admit_width > MAX_ADMIT_WIDTH) {
+          fprintf(stderr, "Invalid admission width: %s. Must be between 1 and %d.\n", optarg, MAX_ADMIT_WIDTH);
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_CPU_MHZ:  // CPU clock
+        config->cpu_mhz = strtoul(optarg, NULL, 10);
+        if (config->cpu_mhz == 0) {
+          fprintf(stderr, "Invalid CPU clock: %s. Must be a positive number of MHz.\n", optarg);
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_DATA_RATE:  // DDR5 MT/s
+        config->data_rate = strtoul(optarg, NULL, 10);
+        if (config->data_rate == 0) {
+          fprintf(stderr, "Invalid data rate: %s. Must be a positive number of MT/s.\n", optarg);
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_BURST_LENGTH:  // BL16 or BL32
+        config->burst_length = atoi(optarg);
+        if (config->burst_length != 16 && config->burst_length != 32) {
+          fprintf(stderr, "Invalid burst length: %s. Must be 16 or 32.\n", optarg);
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_BURST_CHOP:  // BC8
+        config->burst_chop = true;
+        break;
+      case OPT_DIMMS:  // DIMMs per channel
+        config->dimms_per_channel = atoi(optarg);
+        if (config->dimms_per_channel < 1 || config->dimms_per_channel > MAX_DIMMS_PER_CHANNEL) {
+          fprintf(stderr, "Invalid DIMMs per channel: %s. Must be 1 or 2.\n", optarg);
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_RANKS:  // Ranks per DIMM
+        config->ranks_per_dimm = atoi(optarg);
+        if (config->ranks_per_dimm != 1 && config->ranks_per_dimm != 2 && config->ranks_per_dimm != 4) {
+          fprintf(stderr, "Invalid ranks per DIMM: %s. Must be 1, 2 or 4.\n", optarg);
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_PREFETCH:  // Stream prefetcher
+        config->prefetch = true;
+        break;
+      case OPT_PREFETCH_DEGREE:
+        config->prefetch_degree = atoi(optarg);
+        if (config->prefetch_degree < 1 || config->prefetch_degree > PREFETCH_QUEUE_SIZE) {
+          fprintf(stderr, "Invalid prefetch degree: %s. Must be between 1 and %d.\n", optarg, PREFETCH_QUEUE_SIZE);
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_CLOSED_LOOP:  // Closed-loop core model
+        config->closed_loop = true;
+        break;
+      case OPT_MLP:  // Outstanding reads per core
+        config->core_mlp = atoi(optarg);
+        if (config->core_mlp < 1) {
+          fprintf(stderr, "Invalid MLP: %s. Must be at least 1.\n", optarg);
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_DEPENDENCY:  // none, ifetch or loads
+        if ((int)core_model_parse_dependency(optarg) < 0) {
+          fprintf(stderr, "Invalid dependency model: %s. Must be none, ifetch or loads.\n", optarg);
+          exit(EXIT_FAILURE);
+        }
+        config->dependency = core_model_parse_dependency(optarg);
+        break;
+      case OPT_CHECKPOINT:  // Checkpoint file
+        config->checkpoint_file = optarg;
+        break;
+      case OPT_CHECKPOINT_INTERVAL:  // CPU cycles between checkpoints
+        config->checkpoint_interval = strtoull(optarg, NULL, 10);
+        break;
+      case OPT_RESTORE:  // Resume from checkpoint
+        config->restore_file = optarg;
+        break;
+      case OPT_SAMPLE:  // Sampled simulation
+        config->sample = true;
+        break;
+      case OPT_SAMPLE_PERIOD:
+        config->sample_period = strtoull(optarg, NULL, 10);
+        break;
+      case OPT_SAMPLE_WARMUP:
+        config->sample_warmup = strtoull(optarg, NULL, 10);
+        break;
+      case OPT_SAMPLE_WINDOW:
+        config->sample_window = strtoull(optarg, NULL, 10);
+        if (config->sample_window == 0) {
+          fprintf(stderr, "Invalid sample window: must be at least 1 request.\n");
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_TIMELINE:  // Chrome trace-event export
+        config->timeline_file = optarg;
+        break;
+      case OPT_TIMELINE_WINDOW:  // DIMM cycles start:end
+        {
+          char *end = NULL;
+          config->timeline_start = strtoull(optarg, &end, 10);
+          config->timeline_end = *end == ':' ? strtoull(end + 1, &end, 10) : 0;
+          if (*end != '\0' || config->timeline_end <= config->timeline_start) {
+            fprintf(stderr, "Invalid timeline window: %s. Must be start:end in DIMM cycles with start < end.\n", optarg);
+            exit(EXIT_FAILURE);
+          }
+        }
+        break;
+      case OPT_INTERVAL_STATS:  // DIMM cycles per interval
+        config->interval_cycles = strtoull(optarg, NULL, 10);
+        if (config->interval_cycles == 0) {
+          fprintf(stderr, "Invalid interval: %s. Must be at least 1 DIMM cycle.\n", optarg);
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_INTERVAL_FILE:
+        config->interval_file = optarg;
+        break;
+      case OPT_INTERVAL_FORMAT:  // csv or binary
+        if (interval_stats_parse_format(optarg) < 0) {
+          fprintf(stderr, "Invalid interval format: %s. Must be csv or binary.\n", optarg);
+          exit(EXIT_FAILURE);
+        }
+        config->interval_format = interval_stats_parse_format(optarg);
+        break;
+      case OPT_HOT_ROWS:  // rows reported, printed with the statistics
+        config->hot_rows = strtoul(optarg, NULL, 10);
+        if (config->hot_rows == 0 || strtoul(optarg, NULL, 10) > MAX_HOT_ROWS) {
+          fprintf(stderr, "Invalid number of hot rows: %s. Must be between 1 and %d.\n", optarg, MAX_HOT_ROWS);
+          exit(EXIT_FAILURE);
+        }
+        config->print_stats = true;
+        break;
+      case OPT_HOT_ROWS_INTERVAL:  // DIMM cycles per CSV interval
+        config->hot_rows_interval = strtoull(optarg, NULL, 10);
+        if (config->hot_rows_interval == 0) {
+          fprintf(stderr, "Invalid hot-row interval: %s. Must be at least 1 DIMM cycle.\n", optarg);
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_HOT_ROWS_FILE:
+        config->hot_rows_file = optarg;
+        break;
+      case OPT_RFM:  // all-bank or same-bank RFM, reported with the statistics
+        if (rowhammer_parse_mode(optarg) < 0) {
+          fprintf(stderr, "Invalid RFM mode: %s. Must be ab, sb or off.\n", optarg);
+          exit(EXIT_FAILURE);
+        }
+        config->rfm_mode = rowhammer_parse_mode(optarg);
+        config->print_stats = config->print_stats || config->rfm_mode != RFM_OFF;
+        break;
+      case OPT_RAA_IMT:  // ACTs per bank before an RFM is due
+        config->raa_imt = strtoul(optarg, NULL, 10);
+        if (config->raa_imt == 0 || strtoul(optarg, NULL, 10) > UINT16_MAX / RAA_MMT_FACTOR) {
+          fprintf(stderr, "Invalid RAAIMT: %s. Must be between 1 and %d.\n", optarg, UINT16_MAX / RAA_MMT_FACTOR);
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_RAA_MMT:  // ACTs per bank before new requests wait for the RFM
+        config->raa_mmt = strtoul(optarg, NULL, 10);
+        if (config->raa_mmt == 0 || strtoul(optarg, NULL, 10) > UINT16_MAX) {
+          fprintf(stderr, "Invalid RAAMMT: %s. Must be between 1 and %d.\n", optarg, UINT16_MAX);
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_PRAC:  // row activations that raise ALERT
+        config->prac_threshold = strtoul(optarg, NULL, 10);
+        if (config->prac_threshold == 0 || strtoul(optarg, NULL, 10) > UINT16_MAX) {
+          fprintf(stderr, "Invalid PRAC threshold: %s. Must be between 1 and %d.\n", optarg, UINT16_MAX);
+          exit(EXIT_FAILURE);
+        }
+        config->print_stats = true;
+        break;
+      case OPT_PRAC_RFMS:  // RFMab per back-off
+        config->prac_rfms = atoi(optarg);
+        if (config->prac_rfms != 1 && config->prac_rfms != 2 && config->prac_rfms != 4) {
+          fprintf(stderr, "Invalid number of back-off RFMs: %s. Must be 1, 2 or 4.\n", optarg);
           exit(EXIT_FAILURE);
         }
         break;
+      case OPT_DUEL:  // candidate levels, reported with the statistics
+        {
+          int num_policies = dueling_parse_policies(optarg, config->duel_policies);
+          if (num_policies < 2) {
+            fprintf(stderr, "Invalid dueling policies: %s. Must be 2 to %d different levels or names separated by commas.\n", optarg,
+                    MAX_DUEL_POLICIES);
+            exit(EXIT_FAILURE);
+          }
+          config->num_duel_policies = num_policies;
+          config->print_stats = true;
+        }
+        break;
+      case OPT_DUEL_EPOCH:  // CPU cycles between decisions
+        config->duel_epoch = strtoull(optarg, NULL, 10);
+        if (config->duel_epoch == 0) {
+          fprintf(stderr, "Invalid dueling epoch: %s. Must be at least 1 CPU cycle.\n", optarg);
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_DUEL_SAMPLE:  // one bank in N
+        config->duel_sample = strtoul(optarg, NULL, 10);
+        if (config->duel_sample == 0 || strtoul(optarg, NULL, 10) > NUM_BANKS) {
+          fprintf(stderr, "Invalid dueling sample: %s. Must be between 1 and %d banks.\n", optarg, NUM_BANKS);
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_LOAD_CURVE:  // intensities replayed under every level
+        {
+          int num_scales = load_curve_parse_scales(optarg, config->load_scales, MAX_LOAD_SCALES);
+          if (num_scales <= 0) {
+            fprintf(stderr, "Invalid load scales: %s. Must be up to %d positive intensities separated by commas.\n", optarg,
+                    MAX_LOAD_SCALES);
+            exit(EXIT_FAILURE);
+          }
+          config->num_load_scales = num_scales;
+        }
+        break;
+      case OPT_LATENCY_SLO:  // average CPU cycles
+        config->latency_slo = strtoull(optarg, NULL, 10);
+        if (config->latency_slo == 0) {
+          fprintf(stderr, "Invalid latency SLO: %s. Must be a positive number of CPU cycles.\n", optarg);
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_LOAD_THREADS:
+        config->load_threads = strtoul(optarg, NULL, 10);
+        if (config->load_threads == 0 || strtoul(optarg, NULL, 10) > UINT16_MAX) {
+          fprintf(stderr, "Invalid number of load threads: %s. Must be between 1 and %d.\n", optarg, UINT16_MAX);
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_LOAD_CURVE_FILE:
+        config->load_curve_file = optarg;
+        break;
+      case OPT_EPOCHS:  // Epoch-parallel simulation
+        config->epochs = strtoull(optarg, NULL, 10);
+        if (config->epochs == 0) {
+          fprintf(stderr, "Invalid number of epochs: must be at least 1.\n");
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_EPOCH_WARMUP:
+        config->epoch_warmup = strtoull(optarg, NULL, 10);
+        break;
       case 'h':
       case '?':
         fprintf(stderr, "Usage: %s [-i input_file] [-o output_file] [-s scheduling_policy]\n", argv[0]);
+        fprintf(stderr, "          [--trace-format native|ramulator|dramsim3|champsim|perf-mem] [--address-map reject|mask|fold]\n");
+        fprintf(stderr, "          [--stats] [--output none|text[:file]|binary[:file]|stats[:file]] [--preset name] [--generic-engine]\n");
+        fprintf(stderr, "          [--command-rate 1|2] [--admit-width requests] [--cpu-mhz mhz] [--data-rate mts]\n");
+        fprintf(stderr, "          [--burst-length 16|32] [--burst-chop]\n");
+        fprintf(stderr, "          [--dimms 1|2] [--ranks 1|2|4] [--prefetch] [--prefetch-degree lines]\n");
+        fprintf(stderr, "          [--closed-loop] [--mlp requests] [--dependency none|ifetch|loads]\n");
+        fprintf(stderr, "          [--checkpoint file] [--checkpoint-interval cycles] [--restore file]\n");
+        fprintf(stderr, "          [--sample] [--sample-period requests] [--sample-warmup requests] [--sample-window requests]\n");
+        fprintf(stderr, "          [--timeline file] [--timeline-window start:end]\n");
+        fprintf(stderr, "          [--interval-stats cycles] [--interval-file file] [--interval-format csv|binary]\n");
+        fprintf(stderr, "          [--hot-rows count] [--hot-rows-interval cycles] [--hot-rows-file file]\n");
+        fprintf(stderr, "          [--rfm ab|sb|off] [--raa-imt acts] [--raa-mmt acts] [--prac threshold] [--prac-rfms 1|2|4]\n");
+        fprintf(stderr, "          [--duel levels] [--duel-epoch cycles] [--duel-sample banks]\n");
+        fprintf(stderr, "          [--load-curve scales] [--latency-slo cycles] [--load-threads count] [--load-curve-file file]\n");
+        fprintf(stderr, "          [--epochs count] [--epoch-warmup cycles]\n");
         exit(EXIT_FAILURE);
     }
   }
-}
 
-void out_of_order(Queue_t *global_queue, MemoryRequest_t *current_request) {
-  check_requests_age(global_queue);
+  if (config->dimms_per_channel * config->ranks_per_dimm > MAX_RANKS_PER_CHANNEL) {
+    fprintf(stderr, "Too many ranks: %d DIMM(s) x %d rank(s) exceeds %d ranks per channel.\n", config->dimms_per_channel,
+            config->ranks_per_dimm, MAX_RANKS_PER_CHANNEL);
+    exit(EXIT_FAILURE);
+  }
 
-  bool inserted = false;  // flag so we dont insert it twice
+  // without --output the command trace goes to the -o file as text
+  if (config->num_outputs == 0) {
+    config->output_kinds[config->num_outputs++] = SINK_TEXT;
+  }
 
-  // this if else is for reads>writes when valid
-  if (current_request->operation == DATA_WRITE) {
-    for (int i = 0; i < global_queue->size && !inserted; i++) {
-      MemoryRequest_t *read_request = queue_peek_at(global_queue, i);
-      if (read_request->operation != DATA_WRITE && read_request->bank_group == current_request->bank_group &&
-          read_request->bank == current_request->bank && (read_request->row != current_request->row)) {
-        // we put DATA_WRITE after the DATA_READ or IFETCH
-        queue_insert_at(&global_queue, i + 1, *current_request);
-        inserted = true;
-        break;
-      }
+  for (int i = 0; i < config->num_outputs; i++) {
+    if (config->output_files[i] == NULL && config->output_kinds[i] == SINK_TEXT) {
+      config->output_files[i] = config->output_file;
     }
-  } else {
-    for (int i = 0; i < global_queue->size && !inserted; i++) {
-      MemoryRequest_t *write_request = queue_peek_at(global_queue, i);
-      if (write_request->operation == DATA_WRITE && write_request->bank_group == current_request->bank_group &&
-          write_request->bank == current_request->bank && (write_request->row != current_request->row)) {
-        // we put the DATA_READ or IFETCH before the DATA_WRITE
-        queue_insert_at(&global_queue, i, *current_request);
-        inserted = true;
-        break;
-      }
+    else if (config->output_files[i] == NULL && config->output_kinds[i] == SINK_BINARY) {
+      config->output_files[i] = DEFAULT_BINARY_OUTPUT_FILE;
     }
+
+    // epochs stitch text command traces; sampled runs print their own report
+    if (config->epochs > 1 && config->output_kinds[i] != SINK_TEXT && config->output_kinds[i] != SINK_NONE) {
+      fprintf(stderr, "Epoch-parallel runs only write text output.\n");
+      exit(EXIT_FAILURE);
+    }
+    if (config->sample && config->output_kinds[i] == SINK_STATS) {
+      fprintf(stderr, "Sampled runs report their own statistics; drop the stats output.\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  // every epoch seeks to its own part of the trace
+  if (config->epochs > 1 && input_stream_needed(config->input_file)) {
+    fprintf(stderr, "Epoch-parallel runs need a plain trace file, not stdin, a pipe or a compressed file.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if (config->address_policy == NUM_ADDRESS_POLICIES) {
+    config->address_policy = config->trace_format == TRACE_NATIVE ? ADDRESS_REJECT : ADDRESS_FOLD;
+  }
+
+  // the epoch boundaries are found by scanning native trace lines
+  if (config->epochs > 1 && config->trace_format != TRACE_NATIVE) {
+    fprintf(stderr, "Epoch-parallel runs need a native trace; import it with a sequential run.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  // the epochs run on their own simulators, one timeline cannot follow them all
+  if (config->timeline_file != NULL && config->epochs > 1) {
+    fprintf(stderr, "Epoch-parallel runs cannot export a timeline.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if (config->interval_file == NULL) {
+    config->interval_file = config->interval_format == INTERVAL_BINARY ? DEFAULT_INTERVAL_BINARY_FILE : DEFAULT_INTERVAL_CSV_FILE;
+  }
+
+  // a time series needs every cycle of a single run
+  if (config->interval_cycles > 0 && (config->sample || config->epochs > 1)) {
+    fprintf(stderr, "Interval statistics cannot be collected from sampled or epoch-parallel runs.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  // the sketches count every ACT of one run
+  if (config->hot_rows > 0 && (config->sample || config->epochs > 1)) {
+    fprintf(stderr, "Hot rows cannot be tracked in sampled or epoch-parallel runs.\n");
+    exit(EXIT_FAILURE);
+  }
+  if (config->hot_rows_interval > 0 && config->hot_rows == 0) {
+    fprintf(stderr, "--hot-rows-interval needs --hot-rows.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if (config->raa_mmt == 0) {
+    config->raa_mmt = RAA_MMT_FACTOR * config->raa_imt;
+  }
+  if (config->raa_mmt < config->raa_imt) {
+    fprintf(stderr, "RAAMMT (%u) must be at least RAAIMT (%u).\n", config->raa_mmt, config->raa_imt);
+    exit(EXIT_FAILURE);
+  }
+
+  // the counters follow every ACT of one run
+  if ((config->rfm_mode != RFM_OFF || config->prac_threshold > 0) && (config->sample || config->epochs > 1)) {
+    fprintf(stderr, "RowHammer mitigation cannot be modeled in sampled or epoch-parallel runs.\n");
+    exit(EXIT_FAILURE);
   }
-  // if read > write is not valid, we want to prioritize hits.
-  // put the read after write so we dont read stale data
-  if (!inserted && current_request->operation != DATA_WRITE) {
-    for (int i = 0; i < global_queue->size && !inserted; i++) {
-      MemoryRequest_t *write_request = queue_peek_at(global_queue, i);
-      if (write_request->operation == DATA_WRITE && write_request->bank_group == current_request->bank_group &&
-          write_request->bank == current_request->bank && (write_request->row == current_request->row)) {
-        queue_insert_at(&global_queue, i + 1, *current_request);
-        inserted = true;
+
+  // the shadows replay the trace next to the live run, which starts with the first candidate
+  if (config->num_duel_policies > 0) {
+    for (int i = 1; i < config->num_duel_policies; i++) {
+      if (scheduler_get(config->duel_policies[i])->open_page != scheduler_get(config->duel_policies[0])->open_page) {
+        fprintf(stderr, "Dueling levels must share their page policy; a closed-page level cannot take over open rows.\n");
+        exit(EXIT_FAILURE);
       }
     }
+    if (config->sample || config->epochs > 1 || config->num_load_scales > 0 || config->closed_loop) {
+      fprintf(stderr, "Policy dueling cannot be combined with sampling, epochs, load curves or the closed-loop model.\n");
+      exit(EXIT_FAILURE);
+    }
+    if (config->restore_file != NULL || config->checkpoint_interval > 0) {
+      fprintf(stderr, "Policy dueling keeps its shadows out of checkpoints; run without --restore and --checkpoint-interval.\n");
+      exit(EXIT_FAILURE);
+    }
+    if (input_stream_needed(config->input_file)) {
+      fprintf(stderr, "Policy dueling reads the trace once per shadow; it needs a plain trace file, not stdin, a pipe or a compressed file.\n");
+      exit(EXIT_FAILURE);
+    }
+    config->scheduling_policy = config->duel_policies[0];
   }
-  // if read > write is not valid, we want to prioritize hits.
-  // put the read next to the other read
-  if (!inserted && current_request->operation != DATA_WRITE) {
-    for (int i = 0; i < global_queue->size && !inserted; i++) {
-      MemoryRequest_t *read_request = queue_peek_at(global_queue, i);
-      if (read_request->operation != DATA_WRITE && read_request->bank_group == current_request->bank_group &&
-          read_request->bank == current_request->bank && (read_request->row == current_request->row)) {
-        queue_insert_at(&global_queue, i + 1, *current_request);
-        inserted = true;
-        break;
-      }
+
+  // every level and intensity is a whole run of its own
+  if (config->num_load_scales > 0) {
+    if (config->sample || config->epochs > 1 || config->restore_file != NULL || config->checkpoint_interval > 0) {
+      fprintf(stderr, "Load curves cannot be sampled, split into epochs, checkpointed or restored.\n");
+      exit(EXIT_FAILURE);
+    }
+    if (config->timeline_file != NULL || config->interval_cycles > 0 || config->hot_rows > 0) {
+      fprintf(stderr, "Load curves keep no timeline, interval statistics or hot rows; run one intensity on its own for those.\n");
+      exit(EXIT_FAILURE);
     }
+    if (config->closed_loop) {
+      fprintf(stderr, "Load curves scale the trace times, which closed-loop runs do not follow.\n");
+      exit(EXIT_FAILURE);
+    }
+    if (input_stream_needed(config->input_file)) {
+      fprintf(stderr, "Load curves read the trace once per run; they need a plain trace file, not stdin, a pipe or a compressed file.\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  // both cut the trace by its timestamps, which closed-loop runs no longer follow
+  if (config->closed_loop && (config->sample || config->epochs > 1)) {
+    fprintf(stderr, "Closed-loop runs cannot be sampled or split into epochs.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  // the controller issues at most one command per CPU cycle
+  if ((uint64_t)config->cpu_mhz * 2 < config->data_rate) {
+    fprintf(stderr, "CPU clock (%u MHz) must be at least the DIMM clock (%u MHz).\n", config->cpu_mhz, config->data_rate / 2);
+    exit(EXIT_FAILURE);
+  }
+
+  if (config->burst_chop && config->burst_length != 16) {
+    fprintf(stderr, "Burst chop is only defined for BL16.\n");
+    exit(EXIT_FAILURE);
+  }
+
+#ifdef FIXED_PRESET
+  if (config->preset != FIXED_PRESET || !preset_matches(&FIXED_PRESET_ENTRY, config)) {
+    fprintf(stderr, "This build only runs the %s preset; use the generic build for other settings.\n", FIXED_PRESET_ENTRY.name);
+    exit(EXIT_FAILURE);
+  }
+#endif
+}
+
+void run_specialized_build(char *argv[], Config_t *config) {
+#ifndef FIXED_PRESET
+  // a run that kept every setting of its preset goes to the preset's build, if there is one
+  if (config->generic_engine || config->preset < 0 || !preset_matches(preset_get(config->preset), config)) {
+    return;
+  }
+
+  // bin/main looks for bin/main-<preset>; a bare name was found on PATH and has no directory to look in
+  if (strchr(argv[0], '/') == NULL) {
+    return;
   }
 
-  // flag not up we do it normally
-  if (!inserted) {
-    enqueue(&global_queue, *current_request);
+  char path[4096];
+  snprintf(path, sizeof(path), "%s-%s", argv[0], preset_get(config->preset)->name);
+  if (access(path, X_OK) == 0) {
+    fflush(stdout);
+    execv(path, argv);
   }
+  // fall back to the generic engine
+#else
+  (void)argv;
+  (void)config;
+#endif
 }
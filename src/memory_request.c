@@ -7,14 +7,26 @@
 
 #include "memory_request.h"
 
+// rank bits sit between the bank and the high column bits, so neighbouring pages interleave across ranks
+static uint8_t rank_bits = 0;
+
 static void map_address(MemoryRequest_t *memory_request, uint64_t address) {
   memory_request->byte_select = address & ((1 << 2) - 1);
   memory_request->column_low = (address >> 2) & ((1 << 4) - 1);
   memory_request->channel = (address >> 6) & 1;
   memory_request->bank_group = (address >> 7) & ((1 << 3) - 1);
   memory_request->bank = (address >> 10) & ((1 << 2) - 1);
-  memory_request->column_high = (address >> 12) & ((1 << 6) - 1);
-  memory_request->row = (address >> 18) & ((1 << 16) - 1);
+  memory_request->rank = (address >> 12) & ((1 << rank_bits) - 1);
+  memory_request->column_high = (address >> (12 + rank_bits)) & ((1 << 6) - 1);
+  memory_request->row = (address >> (18 + rank_bits)) & ((1 << 16) - 1);
+}
+
+void memory_request_set_rank_bits(uint8_t bits) {
+  rank_bits = bits;
+}
+
+uint8_t memory_request_address_bits(void) {
+  return 34 + rank_bits;
 }
 
 void memory_request_init(MemoryRequest_t *memory_request, uint64_t time, uint8_t core, uint8_t operation, uint64_t address) {
@@ -25,12 +37,27 @@ void memory_request_init(MemoryRequest_t *memory_request, uint64_t time, uint8_t
   memory_request->state = PENDING;
   memory_request->aging = 0;
   memory_request->is_finished = false;
+  memory_request->is_prefetch = false;
+  memory_request->sequence = 0;
 }
 
 uint16_t get_column(MemoryRequest_t *memory_request) {
   return ((memory_request->column_high << 4) | memory_request->column_low);
 }
 
+uint64_t memory_request_address(MemoryRequest_t *memory_request) {
+  // inverse of map_address
+  uint64_t address = memory_request->byte_select;
+  address |= (uint64_t)memory_request->column_low << 2;
+  address |= (uint64_t)memory_request->channel << 6;
+  address |= (uint64_t)memory_request->bank_group << 7;
+  address |= (uint64_t)memory_request->bank << 10;
+  address |= (uint64_t)memory_request->rank << 12;
+  address |= (uint64_t)memory_request->column_high << (12 + rank_bits);
+  address |= (uint64_t)memory_request->row << (18 + rank_bits);
+  return address;
+}
+
 /**
  * Logs the memory request to stdout
  * Format: [cycle] prefix core operation [bank_group bank row column]
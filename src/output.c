@@ -0,0 +1,221 @@
+/**
+ * @file  output.c
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include <unistd.h>
+#include "output.h"
+
+static const char *command_names[NUM_COMMAND_CODES] = {
+  [COMMAND_ACT0] = "ACT0",
+  [COMMAND_ACT1] = "ACT1",
+  [COMMAND_RD0] = "RD0",
+  [COMMAND_RD1] = "RD1",
+  [COMMAND_WR0] = "WR0",
+  [COMMAND_WR1] = "WR1",
+  [COMMAND_PRE] = "PRE",
+  [COMMAND_RFM] = "RFM",
+};
+
+static const char *sink_names[] = {
+  [SINK_NONE] = "none",
+  [SINK_TEXT] = "text",
+  [SINK_BINARY] = "binary",
+  [SINK_STATS] = "stats",
+};
+
+/*** helper function(s) ***/
+static void write_binary_header(Output_t *output, FILE *file) {
+  BinaryOutputHeader_t header;
+  memset(&header, 0, sizeof(header));
+
+  memcpy(header.magic, BINARY_OUTPUT_MAGIC, sizeof(header.magic));
+  header.version = BINARY_OUTPUT_VERSION;
+  header.record_size = sizeof(CommandRecord_t);
+  header.num_ranks = output->num_ranks;
+  fwrite(&header, sizeof(header), 1, file);
+}
+
+static OutputSink_t *new_sink(Output_t *output, SinkKind_t kind) {
+  if (output->num_sinks == MAX_OUTPUT_SINKS) {
+    fprintf(stderr, "Error: at most %d outputs\n", MAX_OUTPUT_SINKS);
+    exit(EXIT_FAILURE);
+  }
+
+  OutputSink_t *sink = &output->sinks[output->num_sinks++];
+  sink->kind = kind;
+  sink->file = NULL;
+  return sink;
+}
+
+static FILE *open_file(char *file_name, const char *mode) {
+  FILE *file = fopen(file_name, mode);
+  if (file == NULL) {
+    fprintf(stderr, "%s:%d: fopen failed\n", __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  return file;
+}
+
+/*** function(s) ***/
+void output_init(Output_t *output, uint8_t num_ranks) {
+  memset(output, 0, sizeof(Output_t));
+  output->num_ranks = num_ranks;
+}
+
+void output_add_sink(Output_t *output, SinkKind_t kind, char *file_name) {
+  OutputSink_t *sink = new_sink(output, kind);
+
+  switch (kind) {
+    case SINK_TEXT:
+      sink->file = open_file(file_name, "w");
+      break;
+    case SINK_BINARY:
+      sink->file = open_file(file_name, "wb");
+      write_binary_header(output, sink->file);
+      break;
+    case SINK_STATS:
+      sink->file = file_name != NULL ? open_file(file_name, "w") : stdout;
+      break;
+    case SINK_NONE:
+    default:
+      break;
+  }
+}
+
+void output_attach_sink(Output_t *output, SinkKind_t kind, FILE *file) {
+  OutputSink_t *sink = new_sink(output, kind);
+  sink->file = file;
+
+  if (kind == SINK_BINARY) {
+    write_binary_header(output, file);
+  }
+}
+
+void output_resume_sink(Output_t *output, SinkKind_t kind, char *file_name, uint64_t offset) {
+  // nothing was logged before the checkpoint
+  if (kind == SINK_NONE || kind == SINK_STATS) {
+    output_add_sink(output, kind, file_name);
+    return;
+  }
+
+  OutputSink_t *sink = new_sink(output, kind);
+  sink->file = fopen(file_name, "r+");
+  if (sink->file != NULL) {
+    fseeko(sink->file, 0, SEEK_END);
+
+    if (ftello(sink->file) >= (off_t)offset && ftruncate(fileno(sink->file), offset) == 0) {
+      fseeko(sink->file, offset, SEEK_SET);
+      return;
+    }
+
+    fclose(sink->file);
+  }
+
+  // the commands before the checkpoint are lost, keep the rest
+  fprintf(stderr, "Warning: %s does not hold the output before the checkpoint, writing from the checkpoint cycle on\n", file_name);
+  output->num_sinks--;
+  output_add_sink(output, kind, file_name);
+}
+
+void output_command(Output_t *output, const CommandRecord_t *record) {
+  for (int i = 0; i < output->num_sinks; i++) {
+    OutputSink_t *sink = &output->sinks[i];
+
+    switch (sink->kind) {
+      case SINK_TEXT:
+        output_format_text(sink->file, record, output->num_ranks > 1);
+        fputc('\n', sink->file);
+        break;
+      case SINK_BINARY:
+        fwrite(record, sizeof(CommandRecord_t), 1, sink->file);
+        break;
+      case SINK_STATS:
+      case SINK_NONE:
+      default:
+        break;
+    }
+  }
+}
+
+void output_offsets(Output_t *output, uint64_t offsets[MAX_OUTPUT_SINKS]) {
+  memset(offsets, 0, sizeof(uint64_t) * MAX_OUTPUT_SINKS);
+
+  for (int i = 0; i < output->num_sinks; i++) {
+    OutputSink_t *sink = &output->sinks[i];
+    if (sink->kind == SINK_TEXT || sink->kind == SINK_BINARY) {
+      fflush(sink->file);
+      offsets[i] = ftello(sink->file);
+    }
+  }
+}
+
+void output_close(Output_t *output) {
+  for (int i = 0; i < output->num_sinks; i++) {
+    OutputSink_t *sink = &output->sinks[i];
+    if (sink->file != NULL && sink->file != stdout) {
+      fclose(sink->file);
+    }
+    sink->file = NULL;
+  }
+
+  output->num_sinks = 0;
+}
+
+void output_format_text(FILE *file, const CommandRecord_t *record, bool show_rank) {
+  const char *name = output_command_name(record->command);
+  if (record->command == COMMAND_RFM) {
+    name = record->address ? "RFMsb" : "RFMab";
+  }
+
+  uint64_t cycle = record->cycle;
+  unsigned channel = record->channel, rank = record->rank;
+  unsigned bank_group = record->bank_group, bank = record->bank;
+
+  if (show_rank) {
+    fprintf(file, "%10" PRIu64 " %u %u %4s", cycle, channel, rank, name);
+  }
+  else {
+    fprintf(file, "%10" PRIu64 " %u %4s", cycle, channel, name);
+  }
+
+  if (record->command == COMMAND_PRE) {
+    fprintf(file, " %u %u", bank_group, bank);
+  }
+  else if (record->command == COMMAND_RFM) {
+    if (record->address) {
+      fprintf(file, " %u", bank);
+    }
+  }
+  else {
+    fprintf(file, " %u %u 0x%04X", bank_group, bank, record->address);
+  }
+}
+
+bool output_read_binary_header(FILE *file, BinaryOutputHeader_t *header) {
+  return fread(header, sizeof(BinaryOutputHeader_t), 1, file) == 1 &&
+         memcmp(header->magic, BINARY_OUTPUT_MAGIC, sizeof(header->magic)) == 0 &&
+         header->version == BINARY_OUTPUT_VERSION &&
+         header->record_size == sizeof(CommandRecord_t);
+}
+
+int output_parse_sink(const char *name) {
+  for (int i = 0; i < (int)(sizeof(sink_names) / sizeof(sink_names[0])); i++) {
+    if (strcmp(name, sink_names[i]) == 0) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+const char *output_sink_name(SinkKind_t kind) {
+  return sink_names[kind];
+}
+
+const char *output_command_name(CommandCode_t command) {
+  return command < NUM_COMMAND_CODES ? command_names[command] : "?";
+}
@@ -6,13 +6,20 @@
  */
 
 #include "parser.h"
+#include "dimm.h"
 
 /** helper function(s) **/
 FILE *open_file(char *file_name, char *mode);
 void parser_next_line(Parser_t *parser);
-MemoryRequest_t parse_line(char *line);
+void parser_read_request(Parser_t *parser);
+void seek_input(Parser_t *parser, uint64_t offset);
+bool read_line(Parser_t *parser);
+bool read_record(Parser_t *parser, void *record, size_t size);
+bool import_next_request(Parser_t *parser);
+void scale_request_time(Parser_t *parser);
+MemoryRequest_t parse_line(char *line, AddressPolicy_t policy);
 
-Parser_t *parser_init(char *input_file) {
+Parser_t *parser_init(char *input_file, TraceFormat_t format, AddressPolicy_t policy) {
   Parser_t *parser = malloc(sizeof(Parser_t));
 
   if (parser == NULL) {
@@ -20,8 +27,18 @@ Parser_t *parser_init(char *input_file) {
     exit(EXIT_FAILURE);
   }
 
-  parser->file = open_file(input_file, "r");
-  parser->next_request = NULL;
+  parser->file = NULL;
+  parser->stream = NULL;
+  if (input_stream_needed(input_file)) {
+    parser->stream = input_stream_open(input_file);
+  }
+  else {
+    parser->file = open_file(input_file, "r");
+  }
+  parser->end_time = UINT64_MAX;
+  parser->intensity = 1.0;
+  parser->bank_sample = 1;
+  trace_importer_init(&parser->importer, format, policy);
 
   parser_next_line(parser);
 
@@ -30,19 +47,80 @@ Parser_t *parser_init(char *input_file) {
 
 void parser_destroy(Parser_t *parser) {
   if (parser != NULL) {
-    fclose(parser->file);
+    if (parser->stream != NULL) {
+      input_stream_close(parser->stream);
+    }
+    else {
+      fclose(parser->file);
+    }
     free(parser);
   }
 }
 
-MemoryRequest_t *parser_next_request(Parser_t *parser, uint64_t cycle) {
-  if (parser->status == OK && parser->next_request->time <= cycle) {
-    MemoryRequest_t *request = parser->next_request;
+bool parser_next_request(Parser_t *parser, uint64_t cycle, MemoryRequest_t *request) {
+  if (parser->status == OK && parser->next_request.time <= cycle) {
+    *request = parser->next_request;
+    parser_next_line(parser);
+    return true;
+  }
+
+  return false;
+}
+
+uint16_t parser_next_requests(Parser_t *parser, uint64_t cycle, MemoryRequest_t *requests, uint16_t max_requests) {
+  uint16_t count = 0;
+
+  while (count < max_requests && parser_next_request(parser, cycle, &requests[count])) {
+    count++;
+  }
+
+  return count;
+}
+
+uint64_t parser_tell(Parser_t *parser) {
+  return parser->stream != NULL ? input_stream_tell(parser->stream) : (uint64_t)ftello(parser->file);
+}
+
+void parser_seek(Parser_t *parser, uint64_t offset, MemoryRequest_t *next_request) {
+  seek_input(parser, offset);
+
+  // replaces whatever parser_init() read ahead
+  if (next_request == NULL) {
+    parser->status = END_OF_FILE;
+    return;
+  }
+
+  parser->next_request = *next_request;
+  parser->status = OK;
+}
+
+void parser_seek_line(Parser_t *parser, uint64_t offset) {
+  seek_input(parser, offset);
+  parser->importer.num_pending = 0;
+  parser->importer.next_pending = 0;
+
+  parser_next_line(parser);
+}
+
+void parser_set_intensity(Parser_t *parser, double intensity) {
+  // the pending request was read at the old intensity
+  if (parser->status == OK) {
+    parser->next_request.time = (uint64_t)(parser->next_request.time * parser->intensity / intensity);
+  }
+  parser->intensity = intensity;
+}
+
+void parser_set_bank_sample(Parser_t *parser, uint8_t bank_sample) {
+  parser->bank_sample = bank_sample;
+  if (parser->status == OK && !parser_is_sampled(&parser->next_request, bank_sample)) {
     parser_next_line(parser);
-    return request;
   }
+}
 
-  return NULL;
+bool parser_is_sampled(MemoryRequest_t *request, uint8_t bank_sample) {
+  uint32_t bank = ((uint32_t)request->channel * MAX_RANKS_PER_CHANNEL + request->rank) * NUM_BANKS +
+                  request->bank_group * NUM_BANKS_PER_GROUP + request->bank;
+  return bank % bank_sample == 0;
 }
 
 FILE *open_file(char *file_name, char *mode) {
@@ -55,30 +133,119 @@ FILE *open_file(char *file_name, char *mode) {
   return file;
 }
 
+void seek_input(Parser_t *parser, uint64_t offset) {
+  if (parser->stream != NULL) {
+    if (!input_stream_skip(parser->stream, offset)) {
+      fprintf(stderr, "Error seeking in input stream: offset %" PRIu64 " is behind the stream or past its end\n", offset);
+      exit(EXIT_FAILURE);
+    }
+    return;
+  }
+
+  if (fseeko(parser->file, offset, SEEK_SET) != 0) {
+    perror("Error seeking in input file");
+    exit(EXIT_FAILURE);
+  }
+}
+
+bool read_line(Parser_t *parser) {
+  bool has_line = parser->stream != NULL ? input_stream_gets(parser->stream, parser->line, sizeof(parser->line))
+                                         : fgets(parser->line, sizeof(parser->line), parser->file) != NULL;
+
+  // only the leading fields matter, drop the rest of an overlong line (perf symbols can be long)
+  if (has_line && strchr(parser->line, '\n') == NULL && strlen(parser->line) == sizeof(parser->line) - 1) {
+    char rest[LINE_LENGTH];
+    bool more = true;
+    while (more) {
+      more = parser->stream != NULL ? input_stream_gets(parser->stream, rest, sizeof(rest))
+                                    : fgets(rest, sizeof(rest), parser->file) != NULL;
+      more = more && strchr(rest, '\n') == NULL;
+    }
+  }
+
+  return has_line;
+}
+
+bool read_record(Parser_t *parser, void *record, size_t size) {
+  size_t length = parser->stream != NULL ? input_stream_read(parser->stream, record, size) : fread(record, 1, size, parser->file);
+
+  if (length != 0 && length != size) {
+    fprintf(stderr, "Error: input ends in the middle of a %zu-byte record\n", size);
+    exit(EXIT_FAILURE);
+  }
+
+  return length == size;
+}
+
+bool import_next_request(Parser_t *parser) {
+  TraceImporter_t *importer = &parser->importer;
+
+  // a record can give several requests or none
+  while (!trace_import_next(importer, &parser->next_request)) {
+    if (importer->format == TRACE_CHAMPSIM) {
+      ChampSimInstruction_t instruction;
+      if (!read_record(parser, &instruction, sizeof(instruction))) {
+        return false;
+      }
+      trace_import_champsim(importer, &instruction);
+    }
+    else {
+      if (!read_line(parser)) {
+        return false;
+      }
+      trace_import_line(importer, parser->line);
+    }
+  }
+
+  return true;
+}
+
+void scale_request_time(Parser_t *parser) {
+  if (parser->intensity != 1.0) {
+    parser->next_request.time = (uint64_t)(parser->next_request.time / parser->intensity);
+  }
+}
+
 void parser_next_line(Parser_t *parser) {
-  if (fgets(parser->line, sizeof(parser->line), parser->file)) {
-    // skip empty lines
-    if (strlen(parser->line) == 1) {
-      parser_next_line(parser);
+  do {
+    parser_read_request(parser);
+  } while (parser->bank_sample > 1 && parser->status == OK && !parser_is_sampled(&parser->next_request, parser->bank_sample));
+}
+
+void parser_read_request(Parser_t *parser) {
+  if (parser->importer.format != TRACE_NATIVE) {
+    if (!import_next_request(parser)) {
+      parser->status = END_OF_FILE;
       return;
     }
+    scale_request_time(parser);
+    parser->status = parser->next_request.time < parser->end_time ? OK : END_OF_FILE;
+    return;
+  }
 
-    parser->next_request = malloc(sizeof(MemoryRequest_t));
+  bool has_line = read_line(parser);
 
-    if (parser->next_request == NULL) {
-      perror("Error allocating memory for next request");
-      exit(EXIT_FAILURE);
+  if (has_line) {
+    // skip empty lines
+    if (strlen(parser->line) == 1) {
+      parser_read_request(parser);
+      return;
     }
 
-    *parser->next_request = parse_line(parser->line);
+    parser->next_request = parse_line(parser->line, parser->importer.policy);
     parser->status = OK;
+    scale_request_time(parser);
+
+    if (parser->next_request.time >= parser->end_time) {
+      parser->status = END_OF_FILE;
+    }
 
   } else {
     parser->status = END_OF_FILE;
   }
 }
 
-MemoryRequest_t parse_line(char *line) {
+MemoryRequest_t parse_line(char *line, AddressPolicy_t policy) {
   char time_str[21], core_str[4], operation_str[3], address_str[21];
   uint64_t time, address;
   uint8_t core, operation;
@@ -101,7 +268,7 @@ MemoryRequest_t parse_line(char *line) {
   address = strtoull(address_str, NULL, 16);
 
   // Check if core is out of range
-  if (core > 11) {
+  if (core >= NUM_CORES) {
     fprintf(stderr, "Error: core value out of range (0-11): %u\n", core);
     exit(EXIT_FAILURE);
   }
@@ -112,19 +279,14 @@ MemoryRequest_t parse_line(char *line) {
     exit(EXIT_FAILURE);
   }
 
-  // Check if address is more than 34 bits
-  if (address > ((uint64_t)1 << 34) - 1) {
-    fprintf(stderr, "Error: address is more than 34 bits: %" PRIx64 "\n", address);
-    exit(EXIT_FAILURE);
+  if (policy == ADDRESS_REJECT) {
+    trace_check_address(time, address);
+  }
+  else {
+    address = trace_remap_address(address, policy);
   }
 
   memory_request_init(&memory_request, time, core, operation, address);
 
-  // Check if channel is out of range
-  if (memory_request.channel != 0) {
-    fprintf(stderr, "Error: request at time %" PRIu64 " has channel %u != 0\n", memory_request.time, memory_request.channel);
-    exit(EXIT_FAILURE);
-  }
-
   return memory_request;
 }
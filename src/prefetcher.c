@@ -0,0 +1,215 @@
+/**
+ * @file  prefetcher.c
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "prefetcher.h"
+
+/*** helper function(s) ***/
+static uint64_t request_line(MemoryRequest_t *request) {
+  return memory_request_address(request) / BYTES_PER_LINE;
+}
+
+static PrefetchEntry_t *find_entry(Prefetcher_t *prefetcher, uint64_t line) {
+  for (int i = 0; i < PREFETCH_BUFFER_SIZE; i++) {
+    if (prefetcher->buffer[i].state != PREFETCH_EMPTY && prefetcher->buffer[i].line == line) {
+      return &prefetcher->buffer[i];
+    }
+  }
+
+  return NULL;
+}
+
+static bool is_candidate(Prefetcher_t *prefetcher, uint64_t line) {
+  for (int i = 0; i < prefetcher->num_candidates; i++) {
+    if (prefetcher->candidates[(prefetcher->candidate_head + i) % PREFETCH_QUEUE_SIZE].line == line) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static void remove_candidate(Prefetcher_t *prefetcher, int index) {
+  // shift the younger candidates down to keep the ring in arrival order
+  for (int i = index; i < prefetcher->num_candidates - 1; i++) {
+    prefetcher->candidates[(prefetcher->candidate_head + i) % PREFETCH_QUEUE_SIZE] =
+      prefetcher->candidates[(prefetcher->candidate_head + i + 1) % PREFETCH_QUEUE_SIZE];
+  }
+  prefetcher->num_candidates--;
+}
+
+static void push_candidate(Prefetcher_t *prefetcher, uint64_t line, uint8_t core) {
+  if (find_entry(prefetcher, line) != NULL || is_candidate(prefetcher, line)) {
+    return;
+  }
+
+  // a full queue drops its oldest candidate, the stream has moved past it
+  if (prefetcher->num_candidates == PREFETCH_QUEUE_SIZE) {
+    prefetcher->candidate_head = (prefetcher->candidate_head + 1) % PREFETCH_QUEUE_SIZE;
+    prefetcher->num_candidates--;
+    prefetcher->dropped++;
+  }
+
+  PrefetchCandidate_t *candidate = &prefetcher->candidates[(prefetcher->candidate_head + prefetcher->num_candidates) % PREFETCH_QUEUE_SIZE];
+  candidate->line = line;
+  candidate->core = core;
+  prefetcher->num_candidates++;
+}
+
+static void train(Prefetcher_t *prefetcher, MemoryRequest_t *request, uint64_t line) {
+  Stream_t *streams = prefetcher->streams[request->core];
+  Stream_t *stream = NULL;
+  uint64_t distance = PREFETCH_MAX_STRIDE + 1;
+
+  // the stream whose last line is closest continues here
+  for (int i = 0; i < PREFETCH_STREAMS_PER_CORE; i++) {
+    uint64_t d = line > streams[i].last_line ? line - streams[i].last_line : streams[i].last_line - line;
+    if (streams[i].last_use != 0 && d != 0 && d < distance) {
+      stream = &streams[i];
+      distance = d;
+    }
+  }
+
+  if (stream == NULL) {
+    stream = &streams[0];
+    for (int i = 1; i < PREFETCH_STREAMS_PER_CORE; i++) {
+      if (streams[i].last_use < stream->last_use) {
+        stream = &streams[i];
+      }
+    }
+
+    stream->last_line = line;
+    stream->stride = 0;
+    stream->confidence = 0;
+    stream->last_use = ++prefetcher->accesses;
+    return;
+  }
+
+  int64_t stride = (int64_t)(line - stream->last_line);
+  if (stride == stream->stride) {
+    if (stream->confidence < PREFETCH_CONFIDENCE) {
+      stream->confidence++;
+    }
+  }
+  else {
+    stream->stride = stride;
+    stream->confidence = 0;
+  }
+  stream->last_line = line;
+  stream->last_use = ++prefetcher->accesses;
+
+  if (stream->confidence < PREFETCH_CONFIDENCE) {
+    return;
+  }
+
+  uint64_t max_line = ((uint64_t)1 << memory_request_address_bits()) / BYTES_PER_LINE;
+  for (int k = 1; k <= prefetcher->degree; k++) {
+    uint64_t target = line + stride * k;
+    if (target >= max_line) {  // also catches running below line 0
+      break;
+    }
+    push_candidate(prefetcher, target, request->core);
+  }
+}
+
+/*** function(s) ***/
+void prefetcher_init(Prefetcher_t *prefetcher, uint8_t degree) {
+  memset(prefetcher, 0, sizeof(Prefetcher_t));
+  prefetcher->degree = degree;
+}
+
+bool prefetcher_demand(Prefetcher_t *prefetcher, MemoryRequest_t *request) {
+  uint64_t line = request_line(request);
+  PrefetchEntry_t *entry = find_entry(prefetcher, line);
+
+  // the demand request fetches the line itself, a prefetch for it would be wasted
+  for (int i = 0; i < prefetcher->num_candidates; i++) {
+    if (prefetcher->candidates[(prefetcher->candidate_head + i) % PREFETCH_QUEUE_SIZE].line == line) {
+      remove_candidate(prefetcher, i);
+      break;
+    }
+  }
+
+  if (request->operation == DATA_WRITE) {
+    if (entry != NULL) {
+      entry->state = PREFETCH_EMPTY;
+      prefetcher->invalidated++;
+    }
+    return false;
+  }
+
+  prefetcher->demand_reads++;
+  train(prefetcher, request, line);
+
+  if (entry == NULL) {
+    return false;
+  }
+
+  if (entry->state == PREFETCH_IN_FLIGHT) {
+    prefetcher->late++;
+    return false;
+  }
+
+  // each prefetched line serves one demand read
+  entry->state = PREFETCH_EMPTY;
+  prefetcher->hits++;
+  return true;
+}
+
+bool prefetcher_next(Prefetcher_t *prefetcher, DIMM_t *dimm, MemoryRequest_t *prefetch, uint64_t cycle) {
+  // never displace a line that is still on its way
+  PrefetchEntry_t *victim = &prefetcher->buffer[prefetcher->next_victim];
+  if (victim->state == PREFETCH_IN_FLIGHT) {
+    return false;
+  }
+
+  for (int i = 0; i < prefetcher->num_candidates; i++) {
+    PrefetchCandidate_t *candidate = &prefetcher->candidates[(prefetcher->candidate_head + i) % PREFETCH_QUEUE_SIZE];
+
+    // only channel 0 is populated (see parse_line), and a prefetch never closes a row a demand request may be using
+    memory_request_init(prefetch, cycle, candidate->core, DATA_READ, candidate->line * BYTES_PER_LINE);
+    if (prefetch->channel != 0 || dimm_is_page_miss(dimm, prefetch)) {
+      continue;
+    }
+
+    prefetch->is_prefetch = true;
+
+    if (victim->state == PREFETCH_READY) {
+      prefetcher->evicted_unused++;
+    }
+    victim->line = candidate->line;
+    victim->state = PREFETCH_IN_FLIGHT;
+    prefetcher->next_victim = (prefetcher->next_victim + 1) % PREFETCH_BUFFER_SIZE;
+
+    remove_candidate(prefetcher, i);
+    prefetcher->issued++;
+    return true;
+  }
+
+  return false;
+}
+
+void prefetcher_fill(Prefetcher_t *prefetcher, MemoryRequest_t *prefetch) {
+  // a write to the line while the prefetch was in flight already freed the entry
+  PrefetchEntry_t *entry = find_entry(prefetcher, request_line(prefetch));
+  if (entry != NULL && entry->state == PREFETCH_IN_FLIGHT) {
+    entry->state = PREFETCH_READY;
+  }
+}
+
+void prefetcher_print_stats(Prefetcher_t *prefetcher, FILE *stream) {
+  uint64_t useful = prefetcher->hits;
+  uint64_t wasted = prefetcher->issued > useful ? prefetcher->issued - useful : 0;
+  uint64_t demand_misses = prefetcher->demand_reads - prefetcher->hits;
+
+  fprintf(stream, "Prefetches Issued: %" PRIu64 " (degree %u, %" PRIu64 " candidates dropped)\n", prefetcher->issued, prefetcher->degree,
+         prefetcher->dropped);
+  fprintf(stream, "Prefetch Hits: %" PRIu64 " (%" PRIu64 " late, %" PRIu64 " evicted unused, %" PRIu64 " invalidated by writes)\n", prefetcher->hits,
+         prefetcher->late, prefetcher->evicted_unused, prefetcher->invalidated);
+  fprintf(stream, "Prefetch Coverage: %.2lf%% of demand reads\n", prefetcher->demand_reads ? 100.0 * useful / prefetcher->demand_reads : 0.0);
+  fprintf(stream, "Prefetch Accuracy: %.2lf%%\n", prefetcher->issued ? 100.0 * useful / prefetcher->issued : 0.0);
+  fprintf(stream, "Prefetch Bandwidth Overhead: %.2lf%% extra reads\n", demand_misses ? 100.0 * wasted / demand_misses : 0.0);
+}
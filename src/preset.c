@@ -0,0 +1,49 @@
+/**
+ * @file  preset.c
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "preset.h"
+
+/*** function(s) ***/
+const Preset_t *preset_get(uint8_t id) {
+  return id < NUM_PRESETS ? &preset_table[id] : NULL;
+}
+
+int preset_find(const char *name) {
+  for (int i = 0; i < NUM_PRESETS; i++) {
+    if (strcmp(name, preset_table[i].name) == 0) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+void preset_apply(const Preset_t *preset, Config_t *config) {
+  config->cpu_mhz = preset->cpu_mhz;
+  config->data_rate = preset->data_rate;
+  config->command_rate = preset->command_rate;
+  config->burst_length = preset->burst_length;
+  config->burst_chop = preset->burst_chop;
+  config->dimms_per_channel = preset->dimms_per_channel;
+  config->ranks_per_dimm = preset->ranks_per_dimm;
+}
+
+bool preset_matches(const Preset_t *preset, Config_t *config) {
+  return config->cpu_mhz == preset->cpu_mhz &&
+         config->data_rate == preset->data_rate &&
+         config->command_rate == preset->command_rate &&
+         config->burst_length == preset->burst_length &&
+         config->burst_chop == preset->burst_chop &&
+         config->dimms_per_channel == preset->dimms_per_channel &&
+         config->ranks_per_dimm == preset->ranks_per_dimm;
+}
+
+void preset_print_list(FILE *stream) {
+  for (int i = 0; i < NUM_PRESETS; i++) {
+    fprintf(stream, "  %-14s %s\n", preset_table[i].name, preset_table[i].description);
+  }
+}
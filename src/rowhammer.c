@@ -0,0 +1,234 @@
+/**
+ * @file  rowhammer.c
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "rowhammer.h"
+
+static const char *mode_names[] = {
+  [RFM_OFF] = "off",
+  [RFM_ALL_BANK] = "ab",
+  [RFM_SAME_BANK] = "sb",
+};
+
+/*** helper function(s) ***/
+// the row's count after one more activation; a full table gives up its coldest entry
+static uint16_t prac_count(PracBank_t *bank, uint16_t row) {
+  uint16_t coldest = 0;
+
+  for (uint16_t i = 0; i < bank->num_rows; i++) {
+    if (bank->rows[i].row == row) {
+      if (bank->rows[i].activations < UINT16_MAX) {
+        bank->rows[i].activations++;
+      }
+      return bank->rows[i].activations;
+    }
+    if (bank->rows[i].activations < bank->rows[coldest].activations) {
+      coldest = i;
+    }
+  }
+
+  if (bank->num_rows < PRAC_TRACKED_ROWS) {
+    bank->rows[bank->num_rows++] = (PracRow_t){row, 1};
+    return 1;
+  }
+
+  bank->rows[coldest].row = row;
+  bank->rows[coldest].activations++;
+  return bank->rows[coldest].activations;
+}
+
+// an RFM lets the DRAM refresh the neighbours of the bank's hottest row
+static void prac_mitigate(PracBank_t *bank) {
+  uint16_t hottest = 0;
+
+  if (bank->num_rows == 0) {
+    return;
+  }
+
+  for (uint16_t i = 1; i < bank->num_rows; i++) {
+    if (bank->rows[i].activations > bank->rows[hottest].activations) {
+      hottest = i;
+    }
+  }
+  bank->rows[hottest].activations = 0;
+}
+
+/*** function(s) ***/
+void rowhammer_init(RowHammer_t *rowhammer, RfmMode_t rfm_mode, uint16_t raa_imt, uint16_t raa_mmt, uint16_t prac_threshold,
+                    uint8_t prac_rfms, const TimeBase_t *time_base) {
+  memset(rowhammer, 0, sizeof(RowHammer_t));
+  rowhammer->rfm_mode = rfm_mode;
+  rowhammer->raa_imt = raa_imt;
+  rowhammer->raa_mmt = raa_mmt;
+  rowhammer->prac_threshold = prac_threshold;
+  rowhammer->prac_rfms = prac_rfms;
+  rowhammer->trfm_ab = time_base_ps_to_dimm(time_base, TRFM_AB_PS);
+  rowhammer->trfm_sb = time_base_ps_to_dimm(time_base, TRFM_SB_PS);
+  rowhammer->tabo_act = time_base_ps_to_dimm(time_base, TABO_ACT_PS);
+  rowhammer->trefi = time_base_ps_to_dimm(time_base, TREFI_PS);
+  rowhammer->trefw = time_base_ps_to_dimm(time_base, TREFW_PS);
+}
+
+void rowhammer_refresh(RowHammer_t *rowhammer, uint64_t cycle) {
+  uint64_t refreshes = cycle / rowhammer->trefi;
+  uint64_t windows = cycle / rowhammer->trefw;
+
+  if (refreshes > rowhammer->refreshes) {
+    uint64_t credit = (refreshes - rowhammer->refreshes) * rowhammer->raa_imt;
+    for (int channel = 0; channel < NUM_CHANNELS; channel++) {
+      for (int rank = 0; rank < MAX_RANKS_PER_CHANNEL; rank++) {
+        uint16_t *raa = rowhammer->ranks[channel][rank].raa;
+        for (int bank = 0; bank < NUM_BANKS; bank++) {
+          raa[bank] = raa[bank] > credit ? raa[bank] - credit : 0;
+        }
+      }
+    }
+    rowhammer->refreshes = refreshes;
+  }
+
+  if (windows > rowhammer->refresh_windows) {
+    for (int channel = 0; channel < NUM_CHANNELS; channel++) {
+      for (int rank = 0; rank < MAX_RANKS_PER_CHANNEL; rank++) {
+        for (int bank = 0; bank < NUM_BANKS; bank++) {
+          rowhammer->prac[channel][rank][bank].num_rows = 0;
+        }
+      }
+    }
+    rowhammer->refresh_windows = windows;
+  }
+}
+
+void rowhammer_activate(RowHammer_t *rowhammer, MemoryRequest_t *request, uint64_t cycle) {
+  RankMitigation_t *rank = &rowhammer->ranks[request->channel][request->rank];
+  uint8_t bank = request->bank_group * NUM_BANKS_PER_GROUP + request->bank;
+
+  if (rowhammer->rfm_mode != RFM_OFF && rank->raa[bank] < UINT16_MAX) {
+    rank->raa[bank]++;
+  }
+
+  if (rowhammer->prac_threshold > 0) {
+    uint16_t count = prac_count(&rowhammer->prac[request->channel][request->rank][bank], request->row);
+    if (count >= rowhammer->prac_threshold && rank->backoff_rfms == 0) {
+      rank->backoff_rfms = rowhammer->prac_rfms;
+      rank->window_end = cycle + rowhammer->tabo_act;
+      rowhammer->alerts++;
+    }
+  }
+}
+
+RfmMode_t rowhammer_due(RowHammer_t *rowhammer, uint8_t channel, uint8_t rank, uint64_t cycle, uint8_t *bank, bool *forced) {
+  RankMitigation_t *mitigation = &rowhammer->ranks[channel][rank];
+
+  // an ALERT comes first: its RFMs may go out early and must go out once tABO_ACT is over
+  if (mitigation->backoff_rfms > 0) {
+    *bank = 0;
+    *forced = cycle >= mitigation->window_end;
+    return RFM_ALL_BANK;
+  }
+
+  if (rowhammer->rfm_mode == RFM_OFF) {
+    return RFM_OFF;
+  }
+
+  uint8_t busiest = 0;
+  for (uint8_t i = 1; i < NUM_BANKS; i++) {
+    if (mitigation->raa[i] > mitigation->raa[busiest]) {
+      busiest = i;
+    }
+  }
+  if (mitigation->raa[busiest] < rowhammer->raa_imt) {
+    return RFM_OFF;
+  }
+
+  *bank = busiest % NUM_BANKS_PER_GROUP;
+  *forced = mitigation->raa[busiest] >= rowhammer->raa_mmt;
+  return rowhammer->rfm_mode;
+}
+
+BankMask_t rowhammer_targets(RfmMode_t mode, uint8_t bank) {
+  if (mode == RFM_ALL_BANK) {
+    return (BankMask_t)~0;
+  }
+
+  BankMask_t targets = 0;
+  for (int bank_group = 0; bank_group < NUM_BANK_GROUPS; bank_group++) {
+    targets |= BANK_BIT(bank_group, bank);
+  }
+  return targets;
+}
+
+void rowhammer_rfm(RowHammer_t *rowhammer, uint8_t channel, uint8_t rank, RfmMode_t mode, uint8_t bank, bool forced) {
+  RankMitigation_t *mitigation = &rowhammer->ranks[channel][rank];
+  BankMask_t targets = rowhammer_targets(mode, bank);
+
+  for (int i = 0; i < NUM_BANKS; i++) {
+    if (!(targets & ((BankMask_t)1 << i))) {
+      continue;
+    }
+    mitigation->raa[i] = mitigation->raa[i] > rowhammer->raa_imt ? mitigation->raa[i] - rowhammer->raa_imt : 0;
+    if (rowhammer->prac_threshold > 0) {
+      prac_mitigate(&rowhammer->prac[channel][rank][i]);
+    }
+  }
+
+  if (mitigation->backoff_rfms > 0) {
+    mitigation->backoff_rfms--;
+    rowhammer->backoff_rfms++;
+  }
+  else if (mode == RFM_ALL_BANK) {
+    rowhammer->rfm_all_bank++;
+  }
+  else {
+    rowhammer->rfm_same_bank++;
+  }
+  rowhammer->forced_rfms += forced;
+}
+
+void rowhammer_print_stats(RowHammer_t *rowhammer, DIMM_t *dimm, uint64_t clock_cycle, FILE *stream) {
+  uint64_t dimm_cycles = time_base_dimm_cycle(&dimm->time_base, clock_cycle);
+  uint64_t bank_cycles = dimm_cycles * dimm->num_ranks * NUM_BANKS;
+  uint64_t completed = dimm->stats.completed_requests;
+  double seconds = time_base_seconds(&dimm->time_base, clock_cycle);
+  double bandwidth = stats_bandwidth_gbps(completed, seconds);
+
+  // the waiting is counted in DIMM cycles, latencies are in CPU cycles
+  double waiting = (double)rowhammer->waiting_cycles * dimm->time_base.cpu_per_tick / dimm->time_base.dimm_per_tick;
+
+  if (rowhammer->rfm_mode != RFM_OFF) {
+    fprintf(stream, "RowHammer Mitigation: RFM%s from RAA %u, forced at %u", rowhammer_mode_name(rowhammer->rfm_mode), rowhammer->raa_imt,
+            rowhammer->raa_mmt);
+  }
+  else {
+    fprintf(stream, "RowHammer Mitigation: no RAA RFM");
+  }
+  if (rowhammer->prac_threshold > 0) {
+    fprintf(stream, ", PRAC back-off at %u with %u RFMab", rowhammer->prac_threshold, rowhammer->prac_rfms);
+  }
+  fprintf(stream, "\n");
+  fprintf(stream, "RFM Commands: %" PRIu64 " RFMab, %" PRIu64 " RFMsb, %" PRIu64 " back-off RFMab for %" PRIu64 " ALERT(s); %" PRIu64
+          " forced, %" PRIu64 " PRE to close rows\n", rowhammer->rfm_all_bank, rowhammer->rfm_same_bank, rowhammer->backoff_rfms,
+          rowhammer->alerts, rowhammer->forced_rfms, rowhammer->precharges);
+  fprintf(stream, "RFM Blocking: %" PRIu64 " bank-cycles (%.2lf%% of the bank time)\n", rowhammer->blocked_bank_cycles,
+          bank_cycles ? 100.0 * rowhammer->blocked_bank_cycles / bank_cycles : 0.0);
+  fprintf(stream, "Mitigation Latency: %.2lf CPU cycles per request waiting for held or blocked banks (at most the latency added)\n", completed ? waiting / completed : 0.0);
+  fprintf(stream, "Mitigation Throughput: %" PRIu64 " DIMM cycles with every queued request waiting (%.2lf%% of the run, about %.3lf GB/s)\n",
+          rowhammer->stalled_cycles, dimm_cycles ? 100.0 * rowhammer->stalled_cycles / dimm_cycles : 0.0,
+          dimm_cycles > rowhammer->stalled_cycles ? bandwidth * rowhammer->stalled_cycles / (dimm_cycles - rowhammer->stalled_cycles) : 0.0);
+}
+
+int rowhammer_parse_mode(const char *name) {
+  for (int i = 0; i < NUM_RFM_MODES; i++) {
+    if (strcmp(name, mode_names[i]) == 0) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+const char *rowhammer_mode_name(RfmMode_t mode) {
+  return mode_names[mode];
+}
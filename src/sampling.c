@@ -0,0 +1,155 @@
+/**
+ * @file  sampling.c
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include <math.h>
+#include "sampling.h"
+
+/*** helper function(s) ***/
+static double t_value_95(uint64_t degrees_of_freedom) {
+  // two-sided 95% Student's t critical values; large samples use the normal value
+  static const double table[] = {
+    0.0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+  };
+
+  if (degrees_of_freedom < sizeof(table) / sizeof(table[0])) {
+    return table[degrees_of_freedom];
+  }
+
+  return 1.960;
+}
+
+static double confidence_interval(double sum, double square_sum, uint64_t n) {
+  if (n < 2) {
+    return 0.0;
+  }
+
+  double mean = sum / n;
+  double variance = (square_sum - n * mean * mean) / (n - 1);
+  if (variance < 0.0) {
+    variance = 0.0;  // rounding
+  }
+
+  return t_value_95(n - 1) * sqrt(variance / n);
+}
+
+static uint64_t fast_forward(Simulator_t *sim, uint64_t count) {
+  uint64_t skipped = 0;
+
+  while (skipped < count) {
+    MemoryRequest_t request;
+    if (!parser_next_request(sim->parser, UINT64_MAX, &request)) {  // ignore arrival time
+      break;
+    }
+
+    dimm_functional_access(sim->dimm, &request);
+    skipped++;
+  }
+
+  // the skipped stretch is long past every timer; resume at the next arrival
+  dimm_clear_timers(sim->dimm);
+  if (sim->parser->status == OK && sim->parser->next_request.time > sim->clock_cycle) {
+    sim->clock_cycle = sim->parser->next_request.time;
+  }
+
+  return skipped;
+}
+
+static bool run_detailed(Simulator_t *sim, uint64_t count) {
+  sim->admission_limit = sim->admitted_requests + count;
+
+  while (sim->admitted_requests < sim->admission_limit) {
+    if (!simulator_step(sim)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static void drain(Simulator_t *sim) {
+  while (!queue_is_empty(sim->queue) && simulator_step(sim)) {
+  }
+}
+
+static void print_report(SamplingResult_t *result, Config_t *config) {
+  uint64_t total_requests = result->detailed_requests + result->fast_forwarded_requests;
+  double detailed_percent = total_requests ? 100.0 * result->detailed_requests / total_requests : 0.0;
+  double latency = result->windows ? result->latency_sum / result->windows : 0.0;
+  double bandwidth = result->windows ? result->bandwidth_sum / result->windows : 0.0;
+
+  printf("--- Sampled Simulation ---\n");
+  printf("Sample Period/Warmup/Window: %" PRIu64 "/%" PRIu64 "/%" PRIu64 " requests\n", config->sample_period, config->sample_warmup, config->sample_window);
+  printf("Sample Windows: %" PRIu64 "\n", result->windows);
+  printf("Detailed Requests: %" PRIu64 " (%.2lf%% of trace)\n", result->detailed_requests, detailed_percent);
+  printf("Fast-Forwarded Requests: %" PRIu64 "\n", result->fast_forwarded_requests);
+  printf("Average Latency: %.2lf CPU cycles (+/- %.2lf, 95%% confidence)\n", latency,
+         confidence_interval(result->latency_sum, result->latency_square_sum, result->windows));
+  printf("Bandwidth: %.3lf GB/s (+/- %.3lf, 95%% confidence)\n", bandwidth,
+         confidence_interval(result->bandwidth_sum, result->bandwidth_square_sum, result->windows));
+  printf("--------------------------\n");
+}
+
+/*** function(s) ***/
+uint64_t run_sampled_simulation(Config_t *config) {
+  Simulator_t *sim = simulator_create(config);
+  SamplingResult_t result;
+  memset(&result, 0, sizeof(result));
+
+  uint64_t detailed = config->sample_warmup + config->sample_window;
+  uint64_t skip = config->sample_period > detailed ? config->sample_period - detailed : 0;
+  bool has_more = true;
+
+  while (has_more) {
+    result.fast_forwarded_requests += fast_forward(sim, skip);
+    if (sim->parser->status == END_OF_FILE) {
+      break;
+    }
+
+    uint64_t admitted_before = sim->admitted_requests;
+    has_more = run_detailed(sim, config->sample_warmup);
+
+    // measure from the end of warmup until the window's requests have drained
+    Stats_t before = sim->dimm->stats;
+    uint64_t window_start = sim->clock_cycle;
+
+    // bandwidth only counts the loaded part of the window, the drain would bias it low
+    uint64_t loaded_completions = 0;
+    uint64_t loaded_cycles = 0;
+
+    if (has_more) {
+      has_more = run_detailed(sim, config->sample_window);
+      loaded_completions = sim->dimm->stats.completed_requests - before.completed_requests;
+      loaded_cycles = sim->clock_cycle - window_start;
+      drain(sim);
+    }
+    result.detailed_requests += sim->admitted_requests - admitted_before;
+
+    uint64_t completed = sim->dimm->stats.completed_requests - before.completed_requests;
+    if (completed == 0 || loaded_cycles == 0) {
+      continue;
+    }
+
+    double latency = (double)(sim->dimm->stats.total_latency - before.total_latency) / completed;
+    double bandwidth = stats_bandwidth_gbps(loaded_completions, time_base_seconds(&sim->dimm->time_base, loaded_cycles));
+
+    result.windows++;
+    result.latency_sum += latency;
+    result.latency_square_sum += latency * latency;
+    result.bandwidth_sum += bandwidth;
+    result.bandwidth_square_sum += bandwidth * bandwidth;
+
+    has_more = has_more && sim->parser->status == OK;
+  }
+
+  print_report(&result, config);
+
+  uint64_t clock_cycle = sim->clock_cycle;
+  simulator_destroy(sim);
+  return clock_cycle;
+}
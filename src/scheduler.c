@@ -0,0 +1,271 @@
+/**
+ * @file  scheduler.c
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "scheduler.h"
+
+#define AGING_CYCLES 114  // DIMM cycles a request counts as young; tRC at DDR5-4800, a heuristic that stays fixed
+
+/*** helper function(s) ***/
+static void in_order(Queue_t **q, MemoryRequest_t *request) {
+  enqueue(q, *request);
+}
+
+static void check_requests_age(Queue_t *global_queue) {
+  if (global_queue == NULL || global_queue->list == NULL) {
+    return; 
+  }
+
+  int old_request_age =-1;
+  int young_request_age =-1;
+  for (int i = 0; i < global_queue->size; i++) {
+    MemoryRequest_t *request = queue_peek_at(global_queue, i);
+    if (request != NULL) {
+      if (request->aging >= AGING_CYCLES*8 && old_request_age == -1) {
+        old_request_age = i;
+      } 
+      else if (request->aging < AGING_CYCLES && young_request_age == -1) {
+        young_request_age = i;
+      }
+
+      if (old_request_age != -1 && young_request_age != -1) {
+        break;
+      }
+    }
+  }
+
+  if (old_request_age != -1 && young_request_age != -1) {
+    queue_insert_at(&global_queue, young_request_age,queue_delete_at(&global_queue,old_request_age));
+  }
+}
+
+// a PRE held by the requests still to use the open row, or a RD/WR held by the hazard table,
+// may be waiting for the request behind it
+static bool is_waiting_on_others(DIMM_t *dimm, MemoryRequest_t *request) {
+  DRAM_t *dram = &(dimm->channels[request->channel].ranks[request->rank]);
+
+  if (request->state == PRE) {
+    return dram->pins[request->bank_group][request->bank] > 0;
+  }
+  return is_column_command(request->state) && !hazard_is_clear(&dimm->hazards, request);
+}
+
+static bool is_same_bank(MemoryRequest_t *a, MemoryRequest_t *b) {
+  return a->channel == b->channel && a->rank == b->rank && a->bank_group == b->bank_group && a->bank == b->bank;
+}
+
+// the hazard table keeps the accesses to a line in order, so a request may go anywhere in the queue
+static void out_of_order(Queue_t **q, MemoryRequest_t *current_request) {
+  Queue_t *global_queue = *q;
+  check_requests_age(global_queue);
+
+  // a row hit goes right behind the last request to its row and follows it without a PRE/ACT
+  for (int i = global_queue->size - 1; i >= 0; i--) {
+    MemoryRequest_t *request = queue_peek_at(global_queue, i);
+    if (is_same_bank(request, current_request) && request->row == current_request->row) {
+      queue_insert_at(&global_queue, i + 1, *current_request);
+      return;
+    }
+  }
+
+  // otherwise reads go ahead of the writes that have not started
+  if (current_request->operation != DATA_WRITE) {
+    for (int i = 0; i < global_queue->size; i++) {
+      MemoryRequest_t *write_request = queue_peek_at(global_queue, i);
+      if (write_request->operation == DATA_WRITE && write_request->state == PENDING) {
+        queue_insert_at(&global_queue, i, *current_request);
+        return;
+      }
+    }
+  }
+
+  enqueue(&global_queue, *current_request);
+}
+
+static void level_zero_algorithm(DIMM_t **dimm, Queue_t **q, uint64_t clock) {
+  MemoryRequest_t *request = queue_peek(*q);
+
+  if ((*q)->size > 1) {  
+    MemoryRequest_t *next_request = queue_peek_at(*q, 1);
+    if (!request->is_finished) {
+      closed_page(dimm, request, clock);
+    }
+    else {
+      closed_page(dimm, request, clock);
+      closed_page(dimm, next_request, clock);
+    }
+  }
+  else {
+    if (request->state != COMPLETE) {
+      closed_page(dimm, request, clock);
+    }
+  }
+
+  if (request && request->state == COMPLETE) {
+    log_memory_request("Dequeued:", request, clock);
+    complete_request(*dimm, request, clock);
+    dequeue(q);
+  }
+}
+
+static void level_one_algorithm(DIMM_t **dimm, Queue_t **q, uint64_t clock) {
+  MemoryRequest_t *request = queue_peek(*q);
+
+  // if current request is not finish, finish it
+  if (!request->is_finished) {
+    open_page(dimm, request, clock);
+  }
+  // else if current request is finish, start next request
+  else {
+    for (int i = 0; i < (*q)->size; i++) {
+      MemoryRequest_t *next_request = queue_peek_at(*q, i);
+      open_page(dimm, next_request, clock);
+
+      if (!next_request->is_finished) {
+        break;
+      }
+    }
+  }
+
+  // if current request is ready to be dequeue, delete it
+  if (request && request->state == COMPLETE) {
+    log_memory_request("Dequeued:", request, clock);
+    complete_request(*dimm, request, clock);
+    dequeue(q);
+  }
+}
+
+static void bank_level_parallelism(DIMM_t **dimm, Queue_t **q, uint64_t clock) {
+  bool is_cmd_issued = false;
+
+  for (int index = 0; index < (*q)->size; index++) {
+    MemoryRequest_t *request = queue_peek_at(*q, index);
+
+    // delete once done
+    if (request->state == COMPLETE) {
+      complete_request(*dimm, request, clock);
+      queue_delete_at(q, index);
+      index--; // decrement index to account for the deleted element
+      continue;
+    }
+
+    if (request->is_finished) {
+      open_page(dimm, request, clock);
+      continue;
+    }
+
+    // a started two-cycle command owns the reserved bus slot, even if reordering put
+    // another request to the same bank ahead of it
+    if (index != 0 && !is_second_half(request->state)) {
+
+      MemoryRequest_t *last_request = queue_peek_at(*q, index - 1);
+      if (
+        !last_request->is_finished &&
+        last_request->rank == request->rank &&
+        last_request->bank_group == request->bank_group &&
+        last_request->bank == request->bank &&
+        !is_waiting_on_others(*dimm, last_request)
+      ) {
+        continue;
+      }
+
+    }
+
+    // a first command half or PRE whose bank timers are still running would change nothing
+    if (request->state == ACT0 || request->state == RD0 || request->state == WR0 || request->state == PRE) {
+      DRAM_t *dram = &((*dimm)->channels[request->channel].ranks[request->rank]);
+      if (!(dram_ready_banks(dram, request->state) & BANK_BIT(request->bank_group, request->bank))) {
+        continue;
+      }
+    }
+
+    is_cmd_issued = open_page(dimm, request, clock);
+
+    if (is_cmd_issued) {
+      break;
+    }
+  }
+}
+
+/*** built-in policies, indexed by their level ***/
+static const Scheduler_t level_zero_scheduler = {
+  .name = "fcfs-closed",
+  .description = "in order, closed page",
+  .open_page = false,
+  .on_enqueue = in_order,
+  .select_command = level_zero_algorithm,
+};
+
+static const Scheduler_t level_one_scheduler = {
+  .name = "fcfs-open",
+  .description = "in order, open page",
+  .open_page = true,
+  .on_enqueue = in_order,
+  .select_command = level_one_algorithm,
+};
+
+static const Scheduler_t level_two_scheduler = {
+  .name = "blp",
+  .description = "bank-level parallelism, open page",
+  .open_page = true,
+  .on_enqueue = in_order,
+  .select_command = bank_level_parallelism,
+};
+
+static const Scheduler_t level_three_scheduler = {
+  .name = "blp-ooo",
+  .description = "bank-level parallelism, open page, out-of-order insertion",
+  .open_page = true,
+  .on_enqueue = out_of_order,
+  .select_command = bank_level_parallelism,
+};
+
+// the built-in levels; scheduler_register() appends after them, and the index is the number -s accepts
+static const Scheduler_t *registry[MAX_SCHEDULERS] = {
+  &level_zero_scheduler,
+  &level_one_scheduler,
+  &level_two_scheduler,
+  &level_three_scheduler,
+};
+
+static int num_schedulers = 4;
+
+/*** function(s) ***/
+int scheduler_register(const Scheduler_t *scheduler) {
+  if (num_schedulers == MAX_SCHEDULERS || scheduler_find(scheduler->name) != -1) {
+    return -1;
+  }
+
+  registry[num_schedulers] = scheduler;
+  return num_schedulers++;
+}
+
+const Scheduler_t *scheduler_get(uint8_t id) {
+  return id < num_schedulers ? registry[id] : NULL;
+}
+
+int scheduler_find(const char *name) {
+  char *end;
+  long id = strtol(name, &end, 10);
+
+  if (*name != '\0' && *end == '\0') {
+    return id >= 0 && id < num_schedulers ? (int)id : -1;
+  }
+
+  for (int i = 0; i < num_schedulers; i++) {
+    if (strcmp(name, registry[i]->name) == 0) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+void scheduler_print_list(FILE *stream) {
+  for (int i = 0; i < num_schedulers; i++) {
+    fprintf(stream, "  %d  %-12s %s\n", i, registry[i]->name, registry[i]->description);
+  }
+}
@@ -0,0 +1,299 @@
+/**
+ * @file  simulator.c
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "simulator.h"
+
+Simulator_t *simulator_create(Config_t *config) {
+  Simulator_t *sim = malloc(sizeof(Simulator_t));
+
+  if (sim == NULL) {
+    fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  // the rank bits must be known before the first address is mapped
+  memory_request_set_rank_bits(config_rank_bits(config));
+  sim->parser = parser_init(config->input_file, config->trace_format, config->address_policy);
+  sim->dimm = NULL;
+  sim->queue = NULL;
+
+  dimm_create(&sim->dimm);                     // create DIMM
+  queue_create(&sim->queue, MAX_QUEUE_SIZE);  // create queue of size 16
+  dimm_set_command_rate(sim->dimm, config->command_rate);
+  dimm_set_burst_length(sim->dimm, config->burst_length, config->burst_chop);
+  dimm_set_ranks(sim->dimm, config->dimms_per_channel, config->ranks_per_dimm);
+  dimm_set_time_base(sim->dimm, config->cpu_mhz, config->data_rate);
+
+  // when restoring, the checkpoint decides where the output files continue from
+  if (config->restore_file == NULL) {
+    for (int i = 0; i < config->num_outputs; i++) {
+      output_add_sink(&sim->dimm->output, config->output_kinds[i], config->output_files[i]);
+    }
+  }
+
+  sim->num_pending = 0;
+  sim->admit_width = config->admit_width;
+  sim->clock_cycle = 0;
+  sim->admitted_requests = 0;
+  sim->admission_limit = UINT64_MAX;
+  sim->scheduling_policy = config->scheduling_policy;
+  sim->scheduler = scheduler_get(config->scheduling_policy);
+  dimm_set_scheduler(sim->dimm, sim->scheduler);
+
+  sim->prefetcher = NULL;
+  if (config->prefetch) {
+    sim->prefetcher = malloc(sizeof(Prefetcher_t));
+    if (sim->prefetcher == NULL) {
+      fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+      exit(EXIT_FAILURE);
+    }
+    prefetcher_init(sim->prefetcher, config->prefetch_degree);
+  }
+  sim->dimm->prefetcher = sim->prefetcher;
+
+  sim->cores = NULL;
+  if (config->closed_loop) {
+    sim->cores = malloc(sizeof(CoreModel_t));
+    if (sim->cores == NULL) {
+      fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+      exit(EXIT_FAILURE);
+    }
+    core_model_init(sim->cores, config->core_mlp, config->dependency);
+  }
+  sim->dimm->cores = sim->cores;
+
+  sim->timeline = NULL;
+  if (config->timeline_file != NULL) {
+    sim->timeline = malloc(sizeof(Timeline_t));
+    if (sim->timeline == NULL) {
+      fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+      exit(EXIT_FAILURE);
+    }
+    timeline_init(sim->timeline, config->timeline_file, config->timeline_start, config->timeline_end, sim->dimm);
+  }
+  sim->dimm->timeline = sim->timeline;
+
+  sim->intervals = NULL;
+  if (config->interval_cycles > 0) {
+    sim->intervals = malloc(sizeof(IntervalStats_t));
+    if (sim->intervals == NULL) {
+      fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+      exit(EXIT_FAILURE);
+    }
+    interval_stats_init(sim->intervals, config->interval_file, config->interval_format, config->interval_cycles, sim->dimm);
+  }
+  sim->dimm->intervals = sim->intervals;
+
+  sim->hot_rows = NULL;
+  if (config->hot_rows > 0) {
+    sim->hot_rows = malloc(sizeof(HotRows_t));
+    if (sim->hot_rows == NULL) {
+      fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+      exit(EXIT_FAILURE);
+    }
+    hot_rows_init(sim->hot_rows, config->hot_rows, config->hot_rows_file, config->hot_rows_interval);
+  }
+  sim->dimm->hot_rows = sim->hot_rows;
+
+  sim->rowhammer = NULL;
+  if (config->rfm_mode != RFM_OFF || config->prac_threshold > 0) {
+    sim->rowhammer = malloc(sizeof(RowHammer_t));
+    if (sim->rowhammer == NULL) {
+      fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+      exit(EXIT_FAILURE);
+    }
+    rowhammer_init(sim->rowhammer, config->rfm_mode, config->raa_imt, config->raa_mmt, config->prac_threshold, config->prac_rfms,
+                   &sim->dimm->time_base);
+  }
+  sim->dimm->rowhammer = sim->rowhammer;
+
+  sim->dueling = NULL;
+  if (config->num_duel_policies > 0) {
+    sim->dueling = malloc(sizeof(Dueling_t));
+    if (sim->dueling == NULL) {
+      fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+      exit(EXIT_FAILURE);
+    }
+    dueling_init(sim->dueling, config);
+  }
+  sim->dimm->dueling = sim->dueling;
+
+  return sim;
+}
+
+void simulator_destroy(Simulator_t *sim) {
+  if (sim != NULL) {
+    if (sim->timeline != NULL) {
+      timeline_close(sim->timeline, time_base_dimm_cycle(&sim->dimm->time_base, sim->clock_cycle));
+    }
+    free(sim->timeline);
+    if (sim->intervals != NULL) {
+      interval_stats_close(sim->intervals, time_base_dimm_cycle(&sim->dimm->time_base, sim->clock_cycle));
+    }
+    free(sim->intervals);
+    if (sim->hot_rows != NULL) {
+      hot_rows_close(sim->hot_rows);
+    }
+    free(sim->hot_rows);
+    free(sim->rowhammer);
+    if (sim->dueling != NULL) {
+      dueling_close(sim->dueling);
+    }
+    free(sim->dueling);
+    free(sim->prefetcher);
+    free(sim->cores);
+    parser_destroy(sim->parser);
+    queue_destroy(&sim->queue);
+    dimm_destroy(&sim->dimm);
+    free(sim);
+  }
+}
+
+static void take_requests(Simulator_t *sim) {
+  // every request due by now, as far as the admission width and limit allow
+  uint64_t room = sim->admit_width - sim->num_pending;
+  if (sim->admission_limit - sim->admitted_requests - sim->num_pending < room) {
+    room = sim->admission_limit - sim->admitted_requests - sim->num_pending;
+  }
+
+  uint8_t first = sim->num_pending;
+  if (sim->cores != NULL) {
+    while (room > 0 && core_model_next_request(sim->cores, sim->parser, sim->clock_cycle, &sim->pending[sim->num_pending])) {
+      sim->num_pending++;
+      room--;
+    }
+  } else {
+    sim->num_pending += parser_next_requests(sim->parser, sim->clock_cycle, &sim->pending[sim->num_pending], room);  // only returns requests if the current cycle >= request's time
+  }
+
+  if (sim->prefetcher == NULL) {
+    return;
+  }
+
+  // demand reads that hit the prefetch buffer never reach the queue
+  uint8_t kept = first;
+  for (uint8_t i = first; i < sim->num_pending; i++) {
+    MemoryRequest_t *request = &sim->pending[i];
+
+    if (prefetcher_demand(sim->prefetcher, request)) {
+      log_memory_request("Prefetch hit:", request, sim->clock_cycle);
+      stats_record_completion(&sim->dimm->stats, request, sim->clock_cycle);
+      if (sim->cores != NULL) {
+        core_model_complete(sim->cores, request, sim->clock_cycle);
+      }
+      sim->admitted_requests++;
+    } else {
+      sim->pending[kept++] = *request;
+    }
+  }
+  sim->num_pending = kept;
+}
+
+static void admit_requests(Simulator_t *sim) {
+  uint8_t admitted = 0;
+
+  while (admitted < sim->num_pending && !queue_is_full(sim->queue)) {
+    MemoryRequest_t *request = &sim->pending[admitted];
+
+    hazard_enqueue(&sim->dimm->hazards, request);
+    sim->scheduler->on_enqueue(&sim->queue, request);
+    if (sim->intervals != NULL) {
+      interval_stats_enqueue(sim->intervals, request, time_base_dimm_cycle(&sim->dimm->time_base, sim->clock_cycle));
+    }
+    log_memory_request("Enqueued:", request, sim->clock_cycle);
+    admitted++;
+  }
+
+  // the rest wait another cycle for a queue slot, held back by the controller
+  for (uint8_t i = admitted; i < sim->num_pending; i++) {
+    sim->dimm->stats.admission_stalls[sim->pending[i].core]++;
+  }
+
+  memmove(sim->pending, sim->pending + admitted, sizeof(MemoryRequest_t) * (sim->num_pending - admitted));
+  sim->num_pending -= admitted;
+  sim->admitted_requests += admitted;
+}
+
+bool simulator_step(Simulator_t *sim) {
+  if (sim->dueling != NULL) {
+    int level = dueling_advance(sim->dueling, sim->queue, sim->clock_cycle);
+    if (level >= 0) {
+      sim->scheduling_policy = level;
+      sim->scheduler = scheduler_get(level);
+      dimm_set_scheduler(sim->dimm, sim->scheduler);
+    }
+  }
+
+  if (sim->intervals != NULL) {
+    interval_stats_advance(sim->intervals, time_base_dimm_cycle(&sim->dimm->time_base, sim->clock_cycle));
+  }
+
+  if (sim->num_pending < sim->admit_width && sim->admitted_requests + sim->num_pending < sim->admission_limit) {
+    take_requests(sim);
+  }
+
+  // DIMM clock cycle - only process request if there is one in the queue
+  if (time_base_is_dimm_edge(&sim->dimm->time_base, sim->clock_cycle) && !queue_is_empty(sim->queue)) {
+    process_request(&sim->dimm, &sim->queue, sim->clock_cycle);
+    increment_aging_in_queue(sim->queue);
+  }
+
+  // CPU clock cycle - enqueue the requests taken so far while the queue is not full
+  if (sim->num_pending > 0) {
+    admit_requests(sim);
+  }
+
+  // prefetches only take slots that demand requests leave free
+  if (
+    sim->prefetcher != NULL &&
+    sim->num_pending == 0 &&
+    sim->parser->status != END_OF_FILE &&
+    sim->queue->size < MAX_QUEUE_SIZE / 2
+  ) {
+    MemoryRequest_t prefetch;
+    if (prefetcher_next(sim->prefetcher, sim->dimm, &prefetch, sim->clock_cycle)) {
+      hazard_enqueue(&sim->dimm->hazards, &prefetch);
+      enqueue(&sim->queue, prefetch);
+      if (sim->intervals != NULL) {
+        interval_stats_enqueue(sim->intervals, &prefetch, time_base_dimm_cycle(&sim->dimm->time_base, sim->clock_cycle));
+      }
+      log_memory_request("Prefetch:", &prefetch, sim->clock_cycle);
+    }
+  }
+
+  if (sim->timeline != NULL) {
+    timeline_queue(sim->timeline, time_base_dimm_cycle(&sim->dimm->time_base, sim->clock_cycle), sim->queue->size);
+  }
+
+  if (sim->parser->status == END_OF_FILE && queue_is_empty(sim->queue) && (sim->cores == NULL || core_model_is_drained(sim->cores))) {
+    LOG("END OF SIMULATION\n");
+    return false;
+  }
+
+  if (sim->cores != NULL) {
+    // nothing in flight: skip ahead to the first core that finishes its compute gap
+    uint64_t next_release = core_model_next_release(sim->cores);
+    if (queue_is_empty(sim->queue) && sim->num_pending == 0 && next_release != UINT64_MAX && next_release > sim->clock_cycle) {
+      sim->clock_cycle = next_release;
+    } else {
+      sim->clock_cycle += 1;
+    }
+    return true;
+  }
+
+  advance_clock(&sim->clock_cycle, sim->queue, sim->parser);
+  return true;
+}
+
+void advance_clock(uint64_t *clock_cycle, Queue_t *global_queue, Parser_t *parser) {
+  if (queue_is_empty(global_queue) && parser->status == OK && parser->next_request.time > *clock_cycle) {
+    LOG("No requests are processing. Advancing clock to next request time (%" PRIu64 ")\n", parser->next_request.time);
+    *clock_cycle = parser->next_request.time;
+  } else {
+    *clock_cycle += 1;
+  }
+}
@@ -0,0 +1,70 @@
+/**
+ * @file  stats.c
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "stats.h"
+
+void stats_init(Stats_t *stats) {
+  memset(stats, 0, sizeof(Stats_t));
+}
+
+void stats_record_completion(Stats_t *stats, MemoryRequest_t *request, uint64_t cycle) {
+  uint64_t latency = cycle - request->time;
+
+  stats->completed_requests++;
+  if (request->operation == DATA_WRITE) {
+    stats->writes++;
+  }
+  else {
+    stats->reads++;
+  }
+
+  stats->total_latency += latency;
+  if (latency > stats->max_latency) {
+    stats->max_latency = latency;
+  }
+}
+
+void stats_add(Stats_t *total, Stats_t *stats) {
+  total->completed_requests += stats->completed_requests;
+  total->reads += stats->reads;
+  total->writes += stats->writes;
+  total->total_latency += stats->total_latency;
+  if (stats->max_latency > total->max_latency) {
+    total->max_latency = stats->max_latency;
+  }
+  for (int i = 0; i < NUM_CORES; i++) {
+    total->admission_stalls[i] += stats->admission_stalls[i];
+  }
+}
+
+void stats_subtract(Stats_t *result, Stats_t *end, Stats_t *start) {
+  // counters between two snapshots; the maximum cannot be split, so it is the running maximum at end
+  result->completed_requests = end->completed_requests - start->completed_requests;
+  result->reads = end->reads - start->reads;
+  result->writes = end->writes - start->writes;
+  result->total_latency = end->total_latency - start->total_latency;
+  result->max_latency = end->max_latency;
+  for (int i = 0; i < NUM_CORES; i++) {
+    result->admission_stalls[i] = end->admission_stalls[i] - start->admission_stalls[i];
+  }
+}
+
+double stats_average_latency(Stats_t *stats) {
+  if (stats->completed_requests == 0) {
+    return 0.0;
+  }
+
+  return (double)stats->total_latency / stats->completed_requests;
+}
+
+double stats_bandwidth_gbps(uint64_t completed_requests, double seconds) {
+  if (seconds <= 0.0) {
+    return 0.0;
+  }
+
+  return (completed_requests * BYTES_PER_REQUEST) / seconds / 1e9;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file  time_base.c
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "time_base.h"
+
+/*** helper function(s) ***/
+static uint64_t gcd(uint64_t a, uint64_t b) {
+  while (b != 0) {
+    uint64_t r = a % b;
+    a = b;
+    b = r;
+  }
+
+  return a;
+}
+
+/*** function(s) ***/
+bool time_base_init(TimeBase_t *time_base, uint32_t cpu_mhz, uint32_t data_rate) {
+  // cpu_mhz : data_rate / 2, doubled to stay integral for odd data rates
+  uint64_t cpu = (uint64_t)cpu_mhz * 2;
+  uint64_t dimm = data_rate;
+
+  memset(time_base, 0, sizeof(TimeBase_t));
+  time_base->cpu_mhz = cpu_mhz;
+  time_base->data_rate = data_rate;
+
+  // every DIMM cycle has to start on a CPU cycle of its own
+  if (cpu_mhz == 0 || data_rate == 0 || cpu < dimm) {
+    return false;
+  }
+
+  uint64_t divisor = gcd(cpu, dimm);
+  time_base->cpu_per_tick = cpu / divisor;
+  time_base->dimm_per_tick = dimm / divisor;
+
+  if (time_base->dimm_per_tick != 1) {
+    time_base->kind = TIME_BASE_FRACTIONAL;
+  }
+  else if ((time_base->cpu_per_tick & (time_base->cpu_per_tick - 1)) == 0) {
+    time_base->kind = TIME_BASE_POWER_OF_TWO;
+    time_base->mask = time_base->cpu_per_tick - 1;
+    while (((uint64_t)1 << time_base->shift) < time_base->cpu_per_tick) {
+      time_base->shift++;
+    }
+  }
+  else {
+    time_base->kind = TIME_BASE_INTEGER;
+  }
+
+  return true;
+}
+
+uint64_t time_base_next_dimm_cycle(const TimeBase_t *time_base, uint64_t cpu_cycle) {
+  // one past the DIMM cycle the previous CPU cycle falls into
+  return cpu_cycle == 0 ? 0 : time_base_dimm_cycle(time_base, cpu_cycle - 1) + 1;
+}
+
+double time_base_seconds(const TimeBase_t *time_base, uint64_t cpu_cycle) {
+  return cpu_cycle / (time_base->cpu_mhz * 1e6);
+}
+
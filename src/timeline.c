@@ -0,0 +1,202 @@
+/**
+ * @file  timeline.c
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "timeline.h"
+
+// process ids of the track groups
+enum TimelineProcess {
+  TIMELINE_BANKS = 1,
+  TIMELINE_BUSES,
+  TIMELINE_CORES
+};
+
+enum TimelineBus {
+  TIMELINE_COMMAND_BUS,
+  TIMELINE_DATA_BUS
+};
+
+static const char *operation_names[] = {
+  [DATA_READ] = "RD",
+  [DATA_WRITE] = "WR",
+  [IFETCH] = "IFETCH",
+};
+
+/*** helper function(s) ***/
+static void next_event(Timeline_t *timeline) {
+  // the track names come first, so every event after them needs a separator
+  fputs(",\n", timeline->file);
+}
+
+static bool in_window(Timeline_t *timeline, uint64_t start, uint64_t duration) {
+  return start < timeline->window_end && start + (duration > 0 ? duration : 1) > timeline->window_start;
+}
+
+static void name_track(Timeline_t *timeline, int pid, int tid, const char *name) {
+  next_event(timeline);
+  fprintf(timeline->file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", pid, tid, name);
+  next_event(timeline);
+  fprintf(timeline->file, "{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"sort_index\":%d}}", pid, tid, tid);
+}
+
+static void name_process(Timeline_t *timeline, int pid, const char *name) {
+  next_event(timeline);
+  fprintf(timeline->file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"%s\"}}", pid, name);
+  next_event(timeline);
+  fprintf(timeline->file, "{\"name\":\"process_sort_index\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"sort_index\":%d}}", pid, pid);
+}
+
+// a complete ("X") event; the caller writes the args object and closes it
+static void begin_span(Timeline_t *timeline, int pid, int tid, const char *name, uint64_t start, uint64_t duration) {
+  next_event(timeline);
+  fprintf(timeline->file, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%" PRIu64 ",\"dur\":%" PRIu64 ",\"args\":",
+          name, pid, tid, start, duration);
+  timeline->num_events++;
+}
+
+static int bank_track(uint8_t rank, uint8_t bank_group, uint8_t bank) {
+  return rank * NUM_BANKS + bank_group * NUM_BANKS_PER_GROUP + bank;
+}
+
+static void write_bank_span(Timeline_t *timeline, uint8_t rank, uint8_t bank_index, uint64_t end) {
+  uint64_t start = timeline->open_since[rank][bank_index];
+  timeline->open_since[rank][bank_index] = TIMELINE_BANK_CLOSED;
+
+  if (start == TIMELINE_BANK_CLOSED || !in_window(timeline, start, end - start)) {
+    return;
+  }
+
+  char name[16];
+  snprintf(name, sizeof(name), "Row 0x%04X", timeline->open_row[rank][bank_index]);
+  begin_span(timeline, TIMELINE_BANKS, rank * NUM_BANKS + bank_index, name, start, end - start);
+  fputs("{}}", timeline->file);
+}
+
+/*** function(s) ***/
+void timeline_init(Timeline_t *timeline, char *file_name, uint64_t window_start, uint64_t window_end, DIMM_t *dimm) {
+  timeline->file = fopen(file_name, "w");
+  if (timeline->file == NULL) {
+    fprintf(stderr, "%s:%d: fopen failed\n", __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  timeline->window_start = window_start;
+  timeline->window_end = window_end;
+  timeline->num_events = 0;
+  timeline->num_requests = 0;
+  timeline->queue_size = -1;
+  timeline->command_rate = DIMM_COMMAND_RATE(dimm);
+  for (int rank = 0; rank < MAX_RANKS_PER_CHANNEL; rank++) {
+    for (int bank = 0; bank < NUM_BANKS; bank++) {
+      timeline->open_since[rank][bank] = TIMELINE_BANK_CLOSED;
+      timeline->open_row[rank][bank] = 0;
+    }
+  }
+
+  fprintf(timeline->file, "{\"displayTimeUnit\":\"ns\",\"otherData\":{\"time_unit\":\"DIMM cycle\",\"cpu_mhz\":%u,\"data_rate\":%u},\n",
+          dimm->time_base.cpu_mhz, dimm->time_base.data_rate);
+  fputs("\"traceEvents\":[\n", timeline->file);
+  fprintf(timeline->file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"Banks\"}}", TIMELINE_BANKS);
+
+  char name[32];
+  for (uint8_t rank = 0; rank < DIMM_NUM_RANKS(dimm); rank++) {
+    for (uint8_t bank_group = 0; bank_group < NUM_BANK_GROUPS; bank_group++) {
+      for (uint8_t bank = 0; bank < NUM_BANKS_PER_GROUP; bank++) {
+        snprintf(name, sizeof(name), "Rank %u BG %u Bank %u", rank, bank_group, bank);
+        name_track(timeline, TIMELINE_BANKS, bank_track(rank, bank_group, bank), name);
+      }
+    }
+  }
+
+  name_process(timeline, TIMELINE_BUSES, "Channel 0");
+  name_track(timeline, TIMELINE_BUSES, TIMELINE_COMMAND_BUS, "Command bus");
+  name_track(timeline, TIMELINE_BUSES, TIMELINE_DATA_BUS, "Data bus");
+
+  name_process(timeline, TIMELINE_CORES, "Cores");
+}
+
+void timeline_command(Timeline_t *timeline, const CommandRecord_t *record) {
+  uint8_t bank_index = record->bank_group * NUM_BANKS_PER_GROUP + record->bank;
+
+  if (record->command == COMMAND_ACT0) {
+    timeline->open_since[record->rank][bank_index] = record->cycle;
+    timeline->open_row[record->rank][bank_index] = record->address;
+  }
+  else if (record->command == COMMAND_PRE) {
+    write_bank_span(timeline, record->rank, bank_index, record->cycle);
+  }
+
+  if (!in_window(timeline, record->cycle, timeline->command_rate)) {
+    return;
+  }
+
+  begin_span(timeline, TIMELINE_BUSES, TIMELINE_COMMAND_BUS, output_command_name(record->command), record->cycle, timeline->command_rate);
+  fprintf(timeline->file, "{\"rank\":%u,\"bank_group\":%u,\"bank\":%u,\"address\":\"0x%04X\"}}",
+          (unsigned)record->rank, (unsigned)record->bank_group, (unsigned)record->bank, record->address);
+}
+
+void timeline_burst(Timeline_t *timeline, MemoryRequest_t *request, uint64_t start, uint64_t length) {
+  if (!in_window(timeline, start, length)) {
+    return;
+  }
+
+  begin_span(timeline, TIMELINE_BUSES, TIMELINE_DATA_BUS, request->operation == DATA_WRITE ? "WR" : "RD", start, length);
+  fprintf(timeline->file, "{\"rank\":%u,\"bank_group\":%u,\"bank\":%u,\"column\":\"0x%04X\"}}",
+          request->rank, request->bank_group, request->bank, get_column(request));
+}
+
+void timeline_request(Timeline_t *timeline, MemoryRequest_t *request, uint64_t arrival, uint64_t completion) {
+  if (!in_window(timeline, arrival, completion - arrival)) {
+    return;
+  }
+
+  // requests of a core overlap without nesting, so they are async slices, one id per request,
+  // which the viewers stack in as many rows as are in flight; the name groups them by core
+  char name[16];
+  if (request->is_prefetch) {
+    snprintf(name, sizeof(name), "Prefetcher");
+  }
+  else {
+    snprintf(name, sizeof(name), "Core %u", request->core);
+  }
+  const char *operation = request->is_prefetch ? "PREFETCH" : operation_names[request->operation];
+  uint64_t id = timeline->num_requests++;
+
+  next_event(timeline);
+  fprintf(timeline->file, "{\"name\":\"%s\",\"cat\":\"request\",\"ph\":\"b\",\"id\":%" PRIu64 ",\"pid\":%d,\"ts\":%" PRIu64 ",\"args\":",
+          name, id, TIMELINE_CORES, arrival);
+  fprintf(timeline->file, "{\"operation\":\"%s\",\"address\":\"0x%09" PRIX64 "\",\"rank\":%u,\"bank_group\":%u,\"bank\":%u,\"row\":\"0x%04X\"}}",
+          operation, memory_request_address(request), request->rank, request->bank_group, request->bank, request->row);
+  next_event(timeline);
+  fprintf(timeline->file, "{\"name\":\"%s\",\"cat\":\"request\",\"ph\":\"e\",\"id\":%" PRIu64 ",\"pid\":%d,\"ts\":%" PRIu64 "}",
+          name, id, TIMELINE_CORES, completion);
+  timeline->num_events++;
+}
+
+void timeline_queue(Timeline_t *timeline, uint64_t cycle, uint8_t size) {
+  if (size == timeline->queue_size || !in_window(timeline, cycle, 0)) {
+    return;
+  }
+
+  // the first sample in the window repeats the size the queue already had
+  timeline->queue_size = size;
+  next_event(timeline);
+  fprintf(timeline->file, "{\"name\":\"Queue\",\"ph\":\"C\",\"pid\":%d,\"ts\":%" PRIu64 ",\"args\":{\"requests\":%u}}",
+          TIMELINE_BUSES, cycle, size);
+  timeline->num_events++;
+}
+
+void timeline_close(Timeline_t *timeline, uint64_t cycle) {
+  for (uint8_t rank = 0; rank < MAX_RANKS_PER_CHANNEL; rank++) {
+    for (uint8_t bank = 0; bank < NUM_BANKS; bank++) {
+      write_bank_span(timeline, rank, bank, cycle);
+    }
+  }
+
+  fputs("\n]}\n", timeline->file);
+  fclose(timeline->file);
+  timeline->file = NULL;
+}
@@ -0,0 +1,341 @@
+/**
+ * @file  trace_format.c
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include <strings.h>
+#include "trace_format.h"
+
+#define MAX_FIELDS 16
+#define CHANNEL_BIT 6
+
+// perf mem data source, perf_event.h: the low five bits are the memory operation
+#define PERF_MEM_OP_LOAD 0x02
+#define PERF_MEM_OP_STORE 0x04
+#define PERF_MEM_OP_EXEC 0x10
+
+// perf mem report -D columns when the dump has no header: PID, TID, IP, ADDR, LOCAL WEIGHT, DSRC, SYMBOL
+#define PERF_DEFAULT_ADDRESS_COLUMN 3
+#define PERF_DEFAULT_SOURCE_COLUMN 5
+
+static const char *format_names[] = {
+  [TRACE_NATIVE] = "native",
+  [TRACE_RAMULATOR] = "ramulator",
+  [TRACE_DRAMSIM3] = "dramsim3",
+  [TRACE_CHAMPSIM] = "champsim",
+  [TRACE_PERF_MEM] = "perf-mem",
+};
+
+static const char *policy_names[] = {
+  [ADDRESS_REJECT] = "reject",
+  [ADDRESS_MASK] = "mask",
+  [ADDRESS_FOLD] = "fold",
+};
+
+/*** helper function(s) ***/
+static int split_fields(char *line, const char *separators, char **fields) {
+  int count = 0;
+  char *save = NULL;
+
+  for (char *field = strtok_r(line, separators, &save); field != NULL && count < MAX_FIELDS; field = strtok_r(NULL, separators, &save)) {
+    fields[count++] = field;
+  }
+
+  return count;
+}
+
+static bool parse_number(const char *text, int base, uint64_t *value) {
+  char *end = NULL;
+
+  if (text[0] == '-') {
+    return false;
+  }
+
+  *value = strtoull(text, &end, base);
+  return end != text && *end == '\0';
+}
+
+// hexadecimal with a 0x prefix, decimal otherwise; a leading 0 is not octal
+static bool parse_prefixed_number(const char *text, uint64_t *value) {
+  bool is_hex = text[0] == '0' && (text[1] == 'x' || text[1] == 'X');
+  return parse_number(text, is_hex ? 16 : 10, value);
+}
+
+static void malformed_line(TraceImporter_t *importer, char **fields, int num_fields) {
+  fprintf(stderr, "Error parsing %s line:", format_names[importer->format]);
+  for (int i = 0; i < num_fields; i++) {
+    fprintf(stderr, " %s", fields[i]);
+  }
+  fprintf(stderr, "\n");
+  exit(EXIT_FAILURE);
+}
+
+static void add_request(TraceImporter_t *importer, uint64_t time, uint8_t core, uint8_t operation, uint64_t address) {
+  if (importer->policy == ADDRESS_REJECT) {
+    trace_check_address(time, address);
+  }
+  else {
+    address = trace_remap_address(address, importer->policy);
+  }
+
+  // the same line twice in one record is one access as far as the DIMM is concerned
+  for (uint8_t i = 0; i < importer->num_pending; i++) {
+    MemoryRequest_t *pending = &importer->pending[i];
+    if (pending->operation == operation && memory_request_address(pending) / BYTES_PER_LINE == address / BYTES_PER_LINE) {
+      return;
+    }
+  }
+
+  memory_request_init(&importer->pending[importer->num_pending++], time, core, operation, address);
+}
+
+// <bubbles> <address> [<writeback address>], decimal unless 0x; or <hex address> <R|W>
+static void import_ramulator(TraceImporter_t *importer, char **fields, int num_fields) {
+  uint64_t address, bubbles, writeback;
+
+  if (num_fields == 2 && (strcmp(fields[1], "R") == 0 || strcmp(fields[1], "W") == 0)) {
+    if (!parse_number(fields[0], 16, &address)) {
+      malformed_line(importer, fields, num_fields);
+    }
+    add_request(importer, importer->clock++, 0, fields[1][0] == 'R' ? DATA_READ : DATA_WRITE, address);
+    return;
+  }
+
+  if (num_fields < 2 || num_fields > 3 || !parse_number(fields[0], 10, &bubbles) || !parse_prefixed_number(fields[1], &address) ||
+      (num_fields == 3 && !parse_prefixed_number(fields[2], &writeback))) {
+    malformed_line(importer, fields, num_fields);
+  }
+
+  // one instruction per cycle: the bubbles, then the memory instruction
+  uint64_t time = importer->clock + bubbles;
+  add_request(importer, time, 0, DATA_READ, address);
+  if (num_fields == 3) {
+    add_request(importer, time, 0, DATA_WRITE, writeback);
+  }
+  importer->clock = time + 1;
+}
+
+// <hex address> <READ|WRITE> <cycle>
+static void import_dramsim3(TraceImporter_t *importer, char **fields, int num_fields) {
+  uint64_t address, cycle;
+
+  if (num_fields != 3 || !parse_number(fields[0], 16, &address) || !parse_number(fields[2], 10, &cycle)) {
+    malformed_line(importer, fields, num_fields);
+  }
+
+  if (strcasecmp(fields[1], "READ") == 0 || strcasecmp(fields[1], "R") == 0) {
+    add_request(importer, cycle, 0, DATA_READ, address);
+  }
+  else if (strcasecmp(fields[1], "WRITE") == 0 || strcasecmp(fields[1], "W") == 0) {
+    add_request(importer, cycle, 0, DATA_WRITE, address);
+  }
+  else {
+    malformed_line(importer, fields, num_fields);
+  }
+}
+
+// "# PID, TID, IP, ADDR, [PHYS ADDR, ...] LOCAL WEIGHT, DSRC, SYMBOL" names the columns of the samples
+static void read_perf_header(TraceImporter_t *importer, char *line) {
+  char *columns[MAX_FIELDS];
+  int num_columns = split_fields(line + 1, ",\r\n", columns);
+  int address = -1, physical = -1, source = -1;
+
+  for (int i = 0; i < num_columns; i++) {
+    char *name = columns[i] + strspn(columns[i], " \t");
+    if (strcmp(name, "ADDR") == 0) {
+      address = i;
+    }
+    else if (strcmp(name, "PHYS ADDR") == 0) {
+      physical = i;
+    }
+    else if (strcmp(name, "DSRC") == 0) {
+      source = i;
+    }
+  }
+
+  // physical addresses are the ones the DIMM sees; they are only there with perf mem record --phys-data
+  if ((address >= 0 || physical >= 0) && source >= 0) {
+    importer->address_column = physical >= 0 ? physical : address;
+    importer->source_column = source;
+  }
+}
+
+// <pid> <tid> <ip> <address> ... <data source> <symbol>
+static void import_perf_mem(TraceImporter_t *importer, char **fields, int num_fields) {
+  uint64_t tid, address, source;
+
+  if (num_fields <= importer->address_column || num_fields <= importer->source_column || !parse_number(fields[1], 10, &tid) ||
+      !parse_number(fields[importer->address_column], 16, &address) || !parse_number(fields[importer->source_column], 16, &source)) {
+    malformed_line(importer, fields, num_fields);
+  }
+
+  uint8_t operation;
+  if (source & PERF_MEM_OP_LOAD) {
+    operation = DATA_READ;
+  }
+  else if (source & PERF_MEM_OP_STORE) {
+    operation = DATA_WRITE;
+  }
+  else if (source & PERF_MEM_OP_EXEC) {
+    operation = IFETCH;
+  }
+  else {
+    return;  // prefetches and samples without an operation
+  }
+
+  // samples without an address (perf prints 0) are not memory accesses the DIMM can see
+  if (address == 0) {
+    return;
+  }
+
+  add_request(importer, importer->clock++, tid % NUM_CORES, operation, address);
+}
+
+/*** function(s) ***/
+void trace_importer_init(TraceImporter_t *importer, TraceFormat_t format, AddressPolicy_t policy) {
+  memset(importer, 0, sizeof(TraceImporter_t));
+
+  importer->format = format;
+  if (policy == NUM_ADDRESS_POLICIES) {
+    policy = format == TRACE_NATIVE ? ADDRESS_REJECT : ADDRESS_FOLD;
+  }
+  importer->policy = policy;
+  importer->last_fetch_line = UINT64_MAX;
+  importer->address_column = PERF_DEFAULT_ADDRESS_COLUMN;
+  importer->source_column = PERF_DEFAULT_SOURCE_COLUMN;
+}
+
+void trace_import_line(TraceImporter_t *importer, char *line) {
+  char *fields[MAX_FIELDS];
+
+  importer->num_pending = 0;
+  importer->next_pending = 0;
+
+  if (line[0] == '#') {
+    if (importer->format == TRACE_PERF_MEM) {
+      read_perf_header(importer, line);
+    }
+    return;
+  }
+
+  int num_fields = split_fields(line, " \t\r\n", fields);
+  if (num_fields == 0) {
+    return;
+  }
+
+  switch (importer->format) {
+    case TRACE_RAMULATOR:
+      import_ramulator(importer, fields, num_fields);
+      break;
+    case TRACE_DRAMSIM3:
+      import_dramsim3(importer, fields, num_fields);
+      break;
+    case TRACE_PERF_MEM:
+      import_perf_mem(importer, fields, num_fields);
+      break;
+    default:
+      fprintf(stderr, "%s:%d: %s traces are not text\n", __FILE__, __LINE__, format_names[importer->format]);
+      exit(EXIT_FAILURE);
+  }
+}
+
+void trace_import_champsim(TraceImporter_t *importer, const ChampSimInstruction_t *instruction) {
+  uint64_t time = importer->clock++;
+
+  importer->num_pending = 0;
+  importer->next_pending = 0;
+
+  // straight-line code stays in the fetch buffer until it leaves the line
+  if (instruction->ip / BYTES_PER_LINE != importer->last_fetch_line) {
+    importer->last_fetch_line = instruction->ip / BYTES_PER_LINE;
+    add_request(importer, time, 0, IFETCH, instruction->ip);
+  }
+
+  for (int i = 0; i < 4; i++) {
+    if (instruction->source_memory[i] != 0) {
+      add_request(importer, time, 0, DATA_READ, instruction->source_memory[i]);
+    }
+  }
+
+  for (int i = 0; i < 2; i++) {
+    if (instruction->destination_memory[i] != 0) {
+      add_request(importer, time, 0, DATA_WRITE, instruction->destination_memory[i]);
+    }
+  }
+}
+
+bool trace_import_next(TraceImporter_t *importer, MemoryRequest_t *request) {
+  if (importer->next_pending == importer->num_pending) {
+    return false;
+  }
+
+  *request = importer->pending[importer->next_pending++];
+  return true;
+}
+
+uint64_t trace_remap_address(uint64_t address, AddressPolicy_t policy) {
+  if (policy == ADDRESS_REJECT) {
+    return address;
+  }
+
+  // squeeze the channel bit out, fit what is left into the DIMM, then put channel 0 back in
+  uint8_t bits = memory_request_address_bits() - 1;
+  uint64_t mask = ((uint64_t)1 << bits) - 1;
+  uint64_t low = address & (((uint64_t)1 << CHANNEL_BIT) - 1);
+  uint64_t compact = ((address >> (CHANNEL_BIT + 1)) << CHANNEL_BIT) | low;
+
+  if (policy == ADDRESS_FOLD) {
+    while (compact > mask) {
+      compact = (compact & mask) ^ (compact >> bits);
+    }
+  }
+  else {
+    compact &= mask;
+  }
+
+  return ((compact >> CHANNEL_BIT) << (CHANNEL_BIT + 1)) | (compact & (((uint64_t)1 << CHANNEL_BIT) - 1));
+}
+
+void trace_check_address(uint64_t time, uint64_t address) {
+  // Check if address is wider than the DIMM (34 bits for a single rank)
+  if (address > ((uint64_t)1 << memory_request_address_bits()) - 1) {
+    fprintf(stderr, "Error: address is more than %u bits: %" PRIx64 "\n", memory_request_address_bits(), address);
+    exit(EXIT_FAILURE);
+  }
+
+  // Check if channel is out of range
+  if ((address >> CHANNEL_BIT) & 1) {
+    fprintf(stderr, "Error: request at time %" PRIu64 " has channel %u != 0\n", time, (unsigned)((address >> CHANNEL_BIT) & 1));
+    exit(EXIT_FAILURE);
+  }
+}
+
+int trace_format_parse(const char *name) {
+  for (int i = 0; i < NUM_TRACE_FORMATS; i++) {
+    if (strcmp(name, format_names[i]) == 0) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+const char *trace_format_name(TraceFormat_t format) {
+  return format_names[format];
+}
+
+int address_policy_parse(const char *name) {
+  for (int i = 0; i < NUM_ADDRESS_POLICIES; i++) {
+    if (strcmp(name, policy_names[i]) == 0) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+const char *address_policy_name(AddressPolicy_t policy) {
+  return policy_names[policy];
+}
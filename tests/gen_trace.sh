@@ -0,0 +1,35 @@
+#!/bin/sh
+# Write a synthetic trace to standard output.
+#
+# usage: tests/gen_trace.sh requests [max_gap]
+#
+# A mix of streaming and random requests from all 12 cores, one every 0 to
+# max_gap - 1 CPU cycles (default 24). About 30% are writes and 7% instruction
+# fetches. The seed is fixed, so the same arguments always give the same trace.
+
+REQUESTS=$1
+MAX_GAP=${2:-24}
+
+if [ -z "$REQUESTS" ]; then
+  echo "usage: $0 requests [max_gap]" >&2
+  exit 1
+fi
+
+awk -v n="$REQUESTS" -v gap="$MAX_GAP" 'BEGIN {
+  srand(485);
+  time = 0;
+  line = 0;
+  for (i = 0; i < n; i++) {
+    time += int(rand() * gap);
+    core = int(rand() * 12);
+    op = rand() < 0.3 ? 1 : (rand() < 0.1 ? 2 : 0);
+    # only channel 0 is simulated, so address bit 6 stays clear
+    if (rand() < 0.5) {
+      line += 1;
+      address = line * 128;
+    } else {
+      address = int(rand() * 2^24) * 128 + int(rand() * 2^6);  # below 2 GB, printf %X is 32-bit in mawk
+    }
+    printf "%d %d %d %X\n", time, core, op, address;
+  }
+}'
@@ -0,0 +1,203 @@
+#!/bin/sh
+# Run the test cases against a build of the simulator.
+#
+# usage: tests/run_tests.sh [bin_dir]
+#
+# Every test_case_N.txt of a folder below is replayed at the folder's
+# scheduling level and its command output has to match test_case_N_results.txt
+# byte for byte. The scripted cases after them run the simulator more than once
+# and compare the runs with each other. The script prints one line per case
+# and exits with status 1 if any of them failed.
+
+BIN=${1:-bin}
+TESTS=$(dirname "$0")
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+status=0
+
+pass() {
+  echo "ok    $1"
+}
+
+fail() {
+  echo "FAIL  $1" >&2
+  status=1
+}
+
+# folder, the level its cases are written for and any other options
+SUITES="
+3_Queue_Requests 0
+4_Policy_Implemented_Correctly/4_1_1_CLOSED_PAGE_POLICY 0
+4_Policy_Implemented_Correctly/4_2_1_OPEN_PAGE_POLICY 1
+4_Policy_Implemented_Correctly/4_3_1_BANK_LEVEL_PARALLELISM 2
+4_Policy_Implemented_Correctly/4_4_1_OUT_OF_ORDER_SCHEDULING 3
+6_TIMING/6_1_LEVEL0 0
+6_TIMING/6_2_LEVEL1 1
+6_TIMING/6_3_LEVEL2 2
+6_TIMING/6_5_DDR5_6400 1 --cpu-mhz 6400 --data-rate 6400
+6_TIMING/6_6_COMMAND_RATE_2N 2 --command-rate 2
+6_TIMING/6_7_TWO_RANKS 2 --ranks 2
+6_TIMING/6_8_TWO_DIMMS 2 --dimms 2
+6_TIMING/6_9_BURST_LENGTH_32 2 --burst-length 32
+"
+
+# results recorded by hand before the simulator they describe, see Test_Plan_Outline.md
+STALE="6_TIMING/6_2_LEVEL1/test_case_1.txt"
+
+echo "$SUITES" | while read -r suite level options; do
+  [ -n "$suite" ] || continue
+  for trace in "$TESTS/$suite"/test_case_*.txt; do
+    case "$trace" in
+      *_results.txt) continue ;;
+    esac
+    name="$suite/$(basename "$trace")"
+    case " $STALE " in
+      *" $name "*) continue ;;
+    esac
+
+    # some folders spell the results Test_case_N_results.txt
+    results="${trace%.txt}_results.txt"
+    [ -f "$results" ] || results="$(dirname "$trace")/T$(basename "${trace%.txt}" | cut -c2-)_results.txt"
+
+    if "$BIN/main" -i "$trace" -o "$WORK/out.txt" -s "$level" $options >/dev/null 2>&1 && cmp -s "$WORK/out.txt" "$results"; then
+      pass "$name"
+    else
+      fail "$name"
+    fi
+  done
+done || status=1
+
+"$TESTS/gen_trace.sh" 3000 > "$WORK/trace.txt"
+"$TESTS/gen_trace.sh" 3000 4 > "$WORK/dense.txt"
+
+# keep the first three quarters of a file, as a run killed after its checkpoint leaves it
+cut_short() {
+  head -c $(($(wc -c < "$1") * 3 / 4)) "$1" > "$WORK/cut" && mv "$WORK/cut" "$1"
+}
+
+# checkpoint halfway, kill the run, restore it: the output is the uninterrupted run's
+for level in 0 1 2 3; do
+  name="checkpoint round trip, level $level"
+  cycles=$("$BIN/main" -i "$WORK/trace.txt" -s $level -o "$WORK/ref.txt" --output text --output binary:"$WORK/ref.bin" |
+    awk '/Total Clock Cycles/ { print $4 }')
+  rm -f "$WORK/run.ckpt"
+  "$BIN/main" -i "$WORK/trace.txt" -s $level -o "$WORK/run.txt" --output text --output binary:"$WORK/run.bin" \
+    --checkpoint "$WORK/run.ckpt" --checkpoint-interval $((cycles / 2 + 1)) >/dev/null
+  cut_short "$WORK/run.txt"
+  cut_short "$WORK/run.bin"
+  if "$BIN/main" -i "$WORK/trace.txt" -s $level -o "$WORK/run.txt" --output text --output binary:"$WORK/run.bin" \
+       --restore "$WORK/run.ckpt" | grep -q "Restored From" && cmp -s "$WORK/ref.txt" "$WORK/run.txt"; then
+    pass "$name, text"
+  else
+    fail "$name, text"
+  fi
+
+  if cmp -s "$WORK/ref.bin" "$WORK/run.bin" && "$BIN/decode_commands" "$WORK/run.bin" "$WORK/decoded.txt" &&
+     cmp -s "$WORK/ref.txt" "$WORK/decoded.txt"; then
+    pass "$name, binary"
+  else
+    fail "$name, binary"
+  fi
+done
+
+# a checkpoint only restores under the bus timing and topology it was taken with
+rm -f "$WORK/run.ckpt"
+"$BIN/main" -i "$WORK/trace.txt" -o "$WORK/run.txt" --dimms 2 --checkpoint "$WORK/run.ckpt" --checkpoint-interval 20000 >/dev/null
+if "$BIN/main" -i "$WORK/trace.txt" -o "$WORK/run.txt" --restore "$WORK/run.ckpt" --dimms 2 | grep -q "Restored From"; then
+  pass "checkpoint restore accepts --dimms 2"
+else
+  fail "checkpoint restore accepts --dimms 2"
+fi
+for options in "--dimms 2 --command-rate 2" "--dimms 2 --burst-chop" "--dimms 2 --burst-length 32" "--ranks 2"; do
+  name="checkpoint restore rejects $options"
+  if "$BIN/main" -i "$WORK/trace.txt" -o "$WORK/run.txt" --restore "$WORK/run.ckpt" $options >/dev/null 2>&1; then
+    fail "$name"
+  else
+    pass "$name"
+  fi
+done
+
+# reordering levels must keep every line's reads and writes in arrival order
+for level in 0 1 2 3; do
+  name="same-line order, level $level"
+  if "$BIN/main" -i "$WORK/trace.txt" -s $level -o "$WORK/run.txt" >/dev/null &&
+     "$BIN/check_order" -i "$WORK/trace.txt" -c "$WORK/run.txt" >/dev/null; then
+    pass "$name"
+  else
+    fail "$name"
+  fi
+done
+
+# at high data rates more bursts are scheduled ahead than at DDR5-4800; none of them may overlap
+# on the data bus track (pid 2, tid 1) of the timeline
+for options in "-s 3 --ranks 2 --data-rate 8800" "-s 2 --dimms 2 --data-rate 7200"; do
+  name="data bus bursts, $options"
+  if "$BIN/main" -i "$WORK/dense.txt" $options --cpu-mhz 5000 -o "$WORK/run.txt" --timeline "$WORK/timeline.json" >/dev/null &&
+     grep '"pid":2,"tid":1,' "$WORK/timeline.json" | sed 's/.*"ts":\([0-9]*\),"dur":\([0-9]*\).*/\1 \2/' | sort -n |
+       awk '$1 < end { overlaps++ } $1 + $2 > end { end = $1 + $2 } END { exit overlaps > 0 }'; then
+    pass "$name"
+  else
+    fail "$name"
+  fi
+done
+
+# the checker reads its trace once, so it can come from a pipe
+name="same-line order, trace on stdin"
+if "$BIN/main" -i "$WORK/trace.txt" -s 3 -o "$WORK/run.txt" >/dev/null &&
+   cat "$WORK/trace.txt" | "$BIN/check_order" -i - -c "$WORK/run.txt" >/dev/null; then
+  pass "$name"
+else
+  fail "$name"
+fi
+
+# requests of a core overlap, so they are async begin/end pairs rather than complete slices on a thread
+name="timeline request slices"
+if "$BIN/main" -i "$WORK/trace.txt" -s 3 -o "$WORK/run.txt" --timeline "$WORK/timeline.json" >/dev/null &&
+   [ "$(grep -c '"ph":"b"' "$WORK/timeline.json")" -eq 3000 ] && [ "$(grep -c '"ph":"e"' "$WORK/timeline.json")" -eq 3000 ] &&
+   ! grep -q '"ph":"X","pid":3,' "$WORK/timeline.json"; then
+  pass "$name"
+else
+  fail "$name"
+fi
+
+# ramulator addresses are decimal unless they start with 0x, zero padding included
+name="ramulator zero-padded decimal addresses"
+printf '0 0123\n2 089 0x40\n' > "$WORK/padded.txt"
+printf '0 123\n2 89 64\n' > "$WORK/plain.txt"
+if "$BIN/main" -i "$WORK/padded.txt" --trace-format ramulator -o "$WORK/run.txt" >/dev/null &&
+   "$BIN/main" -i "$WORK/plain.txt" --trace-format ramulator -o "$WORK/ref.txt" >/dev/null &&
+   cmp -s "$WORK/ref.txt" "$WORK/run.txt"; then
+  pass "$name"
+else
+  fail "$name"
+fi
+
+# the trace queues up faster than it is served, so every boundary falls into a backlog older than the warmup
+for level in 0 1 2 3; do
+  name="epoch-parallel run, level $level"
+  "$BIN/main" -i "$WORK/trace.txt" -s $level -o "$WORK/ref.txt" >/dev/null
+  if "$BIN/main" -i "$WORK/trace.txt" -s $level -o "$WORK/run.txt" --epochs 4 --epoch-warmup 2000 >/dev/null &&
+     cmp -s "$WORK/ref.txt" "$WORK/run.txt"; then
+    pass "$name"
+  else
+    fail "$name"
+  fi
+done
+
+# a run that keeps its preset's settings re-executes the preset's build with the same arguments
+name="specialized build, --output kind:file"
+rm -f "$WORK/run.txt"
+if [ ! -x "$BIN/main-pc5-38400" ]; then
+  fail "$name: $BIN/main-pc5-38400 is missing, run make fast"
+elif "$BIN/main" -i "$WORK/trace.txt" --preset pc5-38400 --output text:"$WORK/run.txt" > "$WORK/stdout.txt" &&
+     grep -q "specialized build" "$WORK/stdout.txt" &&
+     "$BIN/main" -i "$WORK/trace.txt" --preset pc5-38400 --generic-engine --output text:"$WORK/ref.txt" >/dev/null &&
+     cmp -s "$WORK/ref.txt" "$WORK/run.txt"; then
+  pass "$name"
+else
+  fail "$name"
+fi
+
+exit $status
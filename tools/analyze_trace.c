@@ -0,0 +1,912 @@
+/**
+ * @file  analyze_trace.c
+ *
+ * @brief Profiles a trace before it is simulated: operation mix, per-core
+ *        intensity and burstiness, bank and bank group distribution and
+ *        row-buffer locality under the simulator's address mapping, the row
+ *        hits a 16-entry queue could reorder into, reuse distance and
+ *        footprint. From those it predicts which scheduling level is likely
+ *        to pay off.
+ *
+ *        usage: analyze_trace [-i trace] [-j threads] [--trace-format format]
+ *                             [--address-map policy] [--ranks 1|2|4]
+ *                             [--cpu-mhz mhz] [--data-rate mts]
+ *
+ *        A plain native trace is mapped and split into 64 MB chunks that the
+ *        threads profile in parallel; the chunk profiles are stitched in trace
+ *        order, so rows, gaps and reuses across chunk boundaries are counted
+ *        exactly as in one pass. Memory stays bounded whatever the trace size:
+ *        reuse distances are measured on a hash-sampled set of lines whose
+ *        sampling rate halves whenever its table fills up, and the footprint
+ *        is a HyperLogLog estimate. stdin, pipes, compressed files and
+ *        imported formats are read through the simulator's parser on one
+ *        thread.
+ *
+ *        Every address is decoded by memory_request_init(), the simulator's
+ *        own mapping.
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <math.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "common.h"
+#include "config.h"
+#include "dimm.h"
+#include "parser.h"
+#include "time_base.h"
+
+/*** macro(s), enum(s), struct(s) ***/
+#define CHUNK_SIZE ((uint64_t)64 << 20)
+#define NUM_TRACE_BANKS (MAX_RANKS_PER_CHANNEL * NUM_BANKS)
+#define WINDOW_SIZE MAX_QUEUE_SIZE  // what a scheduler can reorder is what its queue holds
+#define LOG_BUCKETS 65               // bucket b holds values in [2^(b-1), 2^b), bucket 0 holds 0
+#define NO_ROW UINT32_MAX
+
+// reuse sampling: a line is sampled when the low bits of its hash fall under the threshold
+#define SAMPLE_SPACE ((uint32_t)1 << 24)
+#define INITIAL_SAMPLE_THRESHOLD (SAMPLE_SPACE / 16)
+#define CHUNK_LINES (1 << 16)    // sampled lines tracked per chunk
+#define GLOBAL_LINES (1 << 20)   // sampled lines tracked across the trace
+
+#define HLL_BITS 12
+#define HLL_REGISTERS (1 << HLL_BITS)
+
+// thresholds of the prediction
+#define REORDER_GAIN 0.10        // extra hit rate the queue must expose for out-of-order scheduling to pay
+#define MIN_BANK_PARALLELISM 2.0 // distinct banks per queue window for bank-level parallelism to pay
+
+enum LongOptions {
+  OPT_TRACE_FORMAT = 256,
+  OPT_ADDRESS_MAP,
+  OPT_RANKS,
+  OPT_CPU_MHZ,
+  OPT_DATA_RATE
+};
+
+typedef struct LineEntry {
+  uint64_t line;   // line number + 1, 0 = empty slot
+  uint64_t first;  // request index of the first and last access in the chunk
+  uint64_t last;
+} LineEntry_t;
+
+typedef struct LineTable {
+  LineEntry_t *entries;
+  uint32_t capacity;
+  uint32_t count;
+  uint32_t threshold;  // out of SAMPLE_SPACE
+} LineTable_t;
+
+typedef struct BankProfile {
+  uint64_t accesses;
+  uint64_t hits;       // same row as the previous access to the bank
+  uint64_t conflicts;  // another row
+  uint32_t first_row;
+  uint32_t last_row;
+} BankProfile_t;
+
+typedef struct Gaps {
+  uint64_t count;
+  double sum;
+  double squares;
+} Gaps_t;
+
+typedef struct CoreProfile {
+  uint64_t requests;
+  uint64_t operations[3];
+  uint64_t first_time;
+  uint64_t last_time;
+  Gaps_t gaps;
+} CoreProfile_t;
+
+typedef struct Profile {
+  uint64_t requests;
+  uint64_t operations[3];
+  uint64_t out_of_order;  // requests with an earlier time than the one before them
+  uint64_t first_time;
+  uint64_t last_time;
+  Gaps_t gaps;
+  uint64_t gap_histogram[LOG_BUCKETS];
+  CoreProfile_t cores[NUM_CORES];
+  BankProfile_t banks[NUM_TRACE_BANKS];
+
+  // the last WINDOW_SIZE requests, as a scheduler's queue would hold them
+  uint16_t window_bank[WINDOW_SIZE];
+  uint32_t window_row[WINDOW_SIZE];
+  uint8_t window_count[NUM_TRACE_BANKS];
+  uint8_t window_fill;
+  uint8_t window_next;
+  uint16_t window_distinct;
+  uint64_t window_hits;    // requests that hit in trace order or share a row with an older request in the window
+  uint64_t window_banks;   // sum of the distinct banks in the window, one sample per request
+
+  double reuse_histogram[LOG_BUCKETS];  // estimated reuses per distance, in requests
+  double cold_lines;                    // estimated first touches
+  LineTable_t lines;
+  uint8_t hll[HLL_REGISTERS];
+} Profile_t;
+
+typedef struct Analysis {
+  const char *data;  // the mapped trace
+  uint64_t size;
+  uint64_t num_chunks;
+  uint64_t next_chunk;    // claimed atomically by the workers
+  AddressPolicy_t policy;
+
+  pthread_mutex_t lock;   // guards the stitching below
+  Profile_t **finished;   // chunk profiles waiting for their turn
+  uint64_t next_merge;
+  uint64_t merged_requests;
+  Profile_t total;
+} Analysis_t;
+
+static const char *level_names[] = {"fcfs-closed", "fcfs-open", "blp", "blp-ooo"};
+
+/*** helper function(s) ***/
+static uint64_t mix64(uint64_t value) {
+  value ^= value >> 33;
+  value *= 0xFF51AFD7ED558CCDULL;
+  value ^= value >> 33;
+  value *= 0xC4CEB9FE1A85EC53ULL;
+  value ^= value >> 33;
+  return value;
+}
+
+static uint8_t log_bucket(uint64_t value) {
+  return value == 0 ? 0 : 64 - __builtin_clzll(value);
+}
+
+static void add_gap(Gaps_t *gaps, uint64_t gap) {
+  gaps->count++;
+  gaps->sum += gap;
+  gaps->squares += (double)gap * gap;
+}
+
+static double gap_mean(Gaps_t *gaps) {
+  return gaps->count ? gaps->sum / gaps->count : 0.0;
+}
+
+static double gap_cv(Gaps_t *gaps) {
+  double mean = gap_mean(gaps);
+  if (gaps->count < 2 || mean == 0.0) {
+    return 0.0;
+  }
+
+  double variance = gaps->squares / gaps->count - mean * mean;
+  return variance > 0.0 ? sqrt(variance) / mean : 0.0;
+}
+
+static void *allocate(size_t size) {
+  void *memory = calloc(1, size);
+  if (memory == NULL) {
+    fprintf(stderr, "%s:%d: calloc failed\n", __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  return memory;
+}
+
+/*** sampled line table ***/
+static void table_init(LineTable_t *table, uint32_t capacity, uint32_t threshold) {
+  table->entries = allocate(sizeof(LineEntry_t) * capacity);
+  table->capacity = capacity;
+  table->count = 0;
+  table->threshold = threshold;
+}
+
+static LineEntry_t *table_find(LineTable_t *table, uint64_t line, uint64_t hash) {
+  uint32_t slot = (hash >> 32) & (table->capacity - 1);
+
+  while (table->entries[slot].line != 0 && table->entries[slot].line != line + 1) {
+    slot = (slot + 1) & (table->capacity - 1);
+  }
+
+  return &table->entries[slot];
+}
+
+// keeps the lines under the new threshold, so the table holds a consistent sample
+static void table_lower_threshold(LineTable_t *table, uint32_t threshold) {
+  LineEntry_t *old = table->entries;
+
+  table->entries = allocate(sizeof(LineEntry_t) * table->capacity);
+  table->count = 0;
+  table->threshold = threshold;
+
+  for (uint32_t i = 0; i < table->capacity; i++) {
+    uint64_t hash = mix64(old[i].line - 1);
+    if (old[i].line != 0 && (hash & (SAMPLE_SPACE - 1)) < threshold) {
+      *table_find(table, old[i].line - 1, hash) = old[i];
+      table->count++;
+    }
+  }
+
+  free(old);
+}
+
+static LineEntry_t *table_insert(LineTable_t *table, LineEntry_t *slot, uint64_t line, uint64_t hash) {
+  slot->line = line + 1;
+  table->count++;
+
+  // at three quarters full, halve the sample
+  if (table->count * 4 >= table->capacity * 3) {
+    table_lower_threshold(table, table->threshold / 2);
+    if ((hash & (SAMPLE_SPACE - 1)) >= table->threshold) {
+      return NULL;
+    }
+    return table_find(table, line, hash);
+  }
+
+  return slot;
+}
+
+/*** profiling ***/
+static Profile_t *profile_create(void) {
+  Profile_t *profile = allocate(sizeof(Profile_t));
+
+  for (int i = 0; i < NUM_TRACE_BANKS; i++) {
+    profile->banks[i].first_row = NO_ROW;
+    profile->banks[i].last_row = NO_ROW;
+  }
+  table_init(&profile->lines, CHUNK_LINES, INITIAL_SAMPLE_THRESHOLD);
+
+  return profile;
+}
+
+static void profile_destroy(Profile_t *profile) {
+  free(profile->lines.entries);
+  free(profile);
+}
+
+static void profile_window(Profile_t *profile, uint16_t bank, uint32_t row, bool hit) {
+  // a hit in trace order stays a hit; otherwise an older request in the queue may open the row first
+  for (uint8_t i = 0; !hit && i < profile->window_fill; i++) {
+    hit = profile->window_bank[i] == bank && profile->window_row[i] == row;
+  }
+  profile->window_hits += hit;
+
+  if (profile->window_fill == WINDOW_SIZE) {
+    uint16_t oldest = profile->window_bank[profile->window_next];
+    if (--profile->window_count[oldest] == 0) {
+      profile->window_distinct--;
+    }
+  }
+  else {
+    profile->window_fill++;
+  }
+
+  profile->window_bank[profile->window_next] = bank;
+  profile->window_row[profile->window_next] = row;
+  profile->window_next = (profile->window_next + 1) % WINDOW_SIZE;
+  if (profile->window_count[bank]++ == 0) {
+    profile->window_distinct++;
+  }
+  profile->window_banks += profile->window_distinct;
+}
+
+static void profile_reuse(Profile_t *profile, uint64_t line, uint64_t index) {
+  uint64_t hash = mix64(line);
+
+  // the footprint sketch sees every line
+  uint32_t hll_register = hash >> (64 - HLL_BITS);
+  uint8_t rank = __builtin_clzll((hash << HLL_BITS) | ((uint64_t)1 << (HLL_BITS - 1))) + 1;
+  if (rank > profile->hll[hll_register]) {
+    profile->hll[hll_register] = rank;
+  }
+
+  LineTable_t *table = &profile->lines;
+  if ((hash & (SAMPLE_SPACE - 1)) >= table->threshold) {
+    return;
+  }
+
+  LineEntry_t *entry = table_find(table, line, hash);
+  if (entry->line != 0) {
+    profile->reuse_histogram[log_bucket(index - entry->last)] += (double)SAMPLE_SPACE / table->threshold;
+    entry->last = index;
+    return;
+  }
+
+  entry = table_insert(table, entry, line, hash);
+  if (entry != NULL) {
+    entry->first = index;
+    entry->last = index;
+  }
+}
+
+static void profile_add(Profile_t *profile, MemoryRequest_t *request) {
+  uint64_t index = profile->requests++;
+  CoreProfile_t *core = &profile->cores[request->core];
+
+  profile->operations[request->operation]++;
+  if (index == 0) {
+    profile->first_time = request->time;
+  }
+  else if (request->time < profile->last_time) {
+    profile->out_of_order++;
+  }
+  else {
+    add_gap(&profile->gaps, request->time - profile->last_time);
+    profile->gap_histogram[log_bucket(request->time - profile->last_time)]++;
+  }
+  profile->last_time = request->time;
+
+  if (core->requests == 0) {
+    core->first_time = request->time;
+  }
+  else if (request->time >= core->last_time) {
+    add_gap(&core->gaps, request->time - core->last_time);
+  }
+  core->requests++;
+  core->operations[request->operation]++;
+  core->last_time = request->time;
+
+  uint16_t bank_index = (request->rank * NUM_BANK_GROUPS + request->bank_group) * NUM_BANKS_PER_GROUP + request->bank;
+  BankProfile_t *bank = &profile->banks[bank_index];
+  bool hit = bank->last_row == request->row;
+  if (bank->last_row == NO_ROW) {
+    bank->first_row = request->row;
+  }
+  else if (bank->last_row == request->row) {
+    bank->hits++;
+  }
+  else {
+    bank->conflicts++;
+  }
+  bank->accesses++;
+  bank->last_row = request->row;
+
+  profile_window(profile, bank_index, request->row, hit);
+  profile_reuse(profile, memory_request_address(request) / BYTES_PER_LINE, index);
+}
+
+// stitches a chunk onto everything before it, as if both had been profiled in one pass
+static void profile_merge(Profile_t *total, Profile_t *chunk, uint64_t base) {
+  if (chunk->requests == 0) {
+    return;
+  }
+
+  if (total->requests == 0) {
+    total->first_time = chunk->first_time;
+  }
+  else if (chunk->first_time < total->last_time) {
+    total->out_of_order++;
+  }
+  else {
+    add_gap(&total->gaps, chunk->first_time - total->last_time);
+    total->gap_histogram[log_bucket(chunk->first_time - total->last_time)]++;
+  }
+  total->last_time = chunk->last_time;
+
+  total->requests += chunk->requests;
+  total->out_of_order += chunk->out_of_order;
+  total->gaps.count += chunk->gaps.count;
+  total->gaps.sum += chunk->gaps.sum;
+  total->gaps.squares += chunk->gaps.squares;
+  for (int i = 0; i < 3; i++) {
+    total->operations[i] += chunk->operations[i];
+  }
+  for (int i = 0; i < LOG_BUCKETS; i++) {
+    total->gap_histogram[i] += chunk->gap_histogram[i];
+    total->reuse_histogram[i] += chunk->reuse_histogram[i];
+  }
+
+  for (int i = 0; i < NUM_CORES; i++) {
+    CoreProfile_t *into = &total->cores[i], *from = &chunk->cores[i];
+    if (from->requests == 0) {
+      continue;
+    }
+    if (into->requests == 0) {
+      into->first_time = from->first_time;
+    }
+    else if (from->first_time >= into->last_time) {
+      add_gap(&into->gaps, from->first_time - into->last_time);
+    }
+    into->last_time = from->last_time;
+    into->requests += from->requests;
+    for (int j = 0; j < 3; j++) {
+      into->operations[j] += from->operations[j];
+    }
+    into->gaps.count += from->gaps.count;
+    into->gaps.sum += from->gaps.sum;
+    into->gaps.squares += from->gaps.squares;
+  }
+
+  for (int i = 0; i < NUM_TRACE_BANKS; i++) {
+    BankProfile_t *into = &total->banks[i], *from = &chunk->banks[i];
+    if (from->accesses == 0) {
+      continue;
+    }
+    if (into->last_row == NO_ROW) {
+      into->first_row = from->first_row;
+    }
+    else if (into->last_row == from->first_row) {
+      into->hits++;
+    }
+    else {
+      into->conflicts++;
+    }
+    into->accesses += from->accesses;
+    into->hits += from->hits;
+    into->conflicts += from->conflicts;
+    into->last_row = from->last_row;
+  }
+
+  total->window_hits += chunk->window_hits;
+  total->window_banks += chunk->window_banks;
+
+  for (int i = 0; i < HLL_REGISTERS; i++) {
+    if (chunk->hll[i] > total->hll[i]) {
+      total->hll[i] = chunk->hll[i];
+    }
+  }
+
+  // a chunk's first access to a line is a reuse of the last access before the chunk, or a first touch
+  LineTable_t *lines = &total->lines;
+  if (chunk->lines.threshold < lines->threshold) {
+    table_lower_threshold(lines, chunk->lines.threshold);
+  }
+  for (uint32_t i = 0; i < chunk->lines.capacity; i++) {
+    LineEntry_t *from = &chunk->lines.entries[i];
+    uint64_t hash = mix64(from->line - 1);
+    if (from->line == 0 || (hash & (SAMPLE_SPACE - 1)) >= lines->threshold) {
+      continue;
+    }
+
+    double weight = (double)SAMPLE_SPACE / lines->threshold;
+    LineEntry_t *into = table_find(lines, from->line - 1, hash);
+    if (into->line != 0) {
+      total->reuse_histogram[log_bucket(base + from->first - into->last)] += weight;
+      into->last = base + from->last;
+      continue;
+    }
+
+    total->cold_lines += weight;
+    into = table_insert(lines, into, from->line - 1, hash);
+    if (into != NULL) {
+      into->last = base + from->last;
+    }
+  }
+}
+
+static double hll_estimate(uint8_t *hll) {
+  double sum = 0.0;
+  int zeros = 0;
+
+  for (int i = 0; i < HLL_REGISTERS; i++) {
+    sum += ldexp(1.0, -hll[i]);
+    zeros += hll[i] == 0;
+  }
+
+  double estimate = 0.7213 / (1.0 + 1.079 / HLL_REGISTERS) * HLL_REGISTERS * HLL_REGISTERS / sum;
+  if (estimate <= 2.5 * HLL_REGISTERS && zeros > 0) {
+    estimate = HLL_REGISTERS * log((double)HLL_REGISTERS / zeros);  // linear counting for small sets
+  }
+
+  return estimate;
+}
+
+/*** native trace chunks ***/
+static void malformed(const char *line, const char *end) {
+  const char *newline = memchr(line, '\n', end - line);
+  fprintf(stderr, "Error parsing line: %.*s\n", (int)((newline ? newline : end) - line), line);
+  exit(EXIT_FAILURE);
+}
+
+static const char *parse_field(const char *cursor, const char *end, int base, uint64_t *value, bool *ok) {
+  while (cursor < end && (*cursor == ' ' || *cursor == '\t')) {
+    cursor++;
+  }
+
+  if (base == 16 && end - cursor > 2 && cursor[0] == '0' && (cursor[1] == 'x' || cursor[1] == 'X')) {
+    cursor += 2;
+  }
+
+  const char *start = cursor;
+  uint64_t result = 0;
+  for (; cursor < end; cursor++) {
+    char c = *cursor;
+    if (c >= '0' && c <= '9') {
+      result = result * base + (c - '0');
+    }
+    else if (base == 16 && (c | 0x20) >= 'a' && (c | 0x20) <= 'f') {
+      result = result * 16 + ((c | 0x20) - 'a' + 10);
+    }
+    else {
+      break;
+    }
+  }
+
+  *value = result;
+  *ok = *ok && cursor != start;
+  return cursor;
+}
+
+// the checks of parse_line() in src/parser.c, on the mapped text
+static void profile_chunk(Analysis_t *analysis, Profile_t *profile, uint64_t chunk) {
+  const char *data = analysis->data;
+  const char *end = data + analysis->size;
+  const char *cursor = data + chunk * CHUNK_SIZE;
+  const char *stop = data + ((chunk + 1) * CHUNK_SIZE < analysis->size ? (chunk + 1) * CHUNK_SIZE : analysis->size);
+
+  // a line belongs to the chunk it starts in
+  if (chunk > 0 && cursor[-1] != '\n') {
+    const char *newline = memchr(cursor, '\n', end - cursor);
+    cursor = newline ? newline + 1 : end;
+  }
+
+  while (cursor < stop) {
+    const char *line = cursor;
+    const char *newline = memchr(cursor, '\n', end - cursor);
+    const char *line_end = newline ? newline : end;
+    cursor = newline ? newline + 1 : end;
+
+    const char *blank = line;
+    while (blank < line_end && (*blank == ' ' || *blank == '\t' || *blank == '\r')) {
+      blank++;
+    }
+    if (blank == line_end) {
+      continue;
+    }
+
+    uint64_t time, core, operation, address;
+    bool ok = true;
+    const char *field = parse_field(line, line_end, 10, &time, &ok);
+    field = parse_field(field, line_end, 10, &core, &ok);
+    field = parse_field(field, line_end, 10, &operation, &ok);
+    parse_field(field, line_end, 16, &address, &ok);
+    if (!ok) {
+      malformed(line, end);
+    }
+
+    if (core >= NUM_CORES) {
+      fprintf(stderr, "Error: core value out of range (0-11): %" PRIu64 "\n", core);
+      exit(EXIT_FAILURE);
+    }
+    if (operation > 2) {
+      fprintf(stderr, "Error: operation value out of range (0-2): %" PRIu64 "\n", operation);
+      exit(EXIT_FAILURE);
+    }
+
+    if (analysis->policy == ADDRESS_REJECT) {
+      trace_check_address(time, address);
+    }
+    else {
+      address = trace_remap_address(address, analysis->policy);
+    }
+
+    MemoryRequest_t request;
+    memory_request_init(&request, time, core, operation, address);
+    profile_add(profile, &request);
+  }
+}
+
+static void finish_chunk(Analysis_t *analysis, uint64_t chunk, Profile_t *profile) {
+  pthread_mutex_lock(&analysis->lock);
+
+  analysis->finished[chunk] = profile;
+  while (analysis->next_merge < analysis->num_chunks && analysis->finished[analysis->next_merge] != NULL) {
+    Profile_t *next = analysis->finished[analysis->next_merge];
+    profile_merge(&analysis->total, next, analysis->merged_requests);
+    analysis->merged_requests += next->requests;
+    profile_destroy(next);
+    analysis->finished[analysis->next_merge++] = NULL;
+  }
+
+  pthread_mutex_unlock(&analysis->lock);
+}
+
+static void *worker(void *arg) {
+  Analysis_t *analysis = arg;
+  uint64_t chunk;
+
+  while ((chunk = __atomic_fetch_add(&analysis->next_chunk, 1, __ATOMIC_RELAXED)) < analysis->num_chunks) {
+    Profile_t *profile = profile_create();
+    profile_chunk(analysis, profile, chunk);
+    finish_chunk(analysis, chunk, profile);
+  }
+
+  return NULL;
+}
+
+static void analyze_mapped(Analysis_t *analysis, char *file_name, int num_threads) {
+  int fd = open(file_name, O_RDONLY);
+  struct stat status;
+  if (fd < 0 || fstat(fd, &status) != 0) {
+    perror("Error opening file");
+    exit(EXIT_FAILURE);
+  }
+
+  analysis->size = status.st_size;
+  if (analysis->size == 0) {
+    close(fd);
+    return;
+  }
+
+  analysis->data = mmap(NULL, analysis->size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (analysis->data == MAP_FAILED) {
+    perror("Error mapping file");
+    exit(EXIT_FAILURE);
+  }
+  madvise((void *)analysis->data, analysis->size, MADV_SEQUENTIAL);
+  close(fd);
+
+  analysis->num_chunks = (analysis->size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  analysis->finished = allocate(sizeof(Profile_t *) * analysis->num_chunks);
+  if ((uint64_t)num_threads > analysis->num_chunks) {
+    num_threads = analysis->num_chunks;
+  }
+
+  pthread_t threads[num_threads];
+  for (int i = 0; i < num_threads; i++) {
+    if (pthread_create(&threads[i], NULL, worker, analysis) != 0) {
+      fprintf(stderr, "%s:%d: pthread_create failed\n", __FILE__, __LINE__);
+      exit(EXIT_FAILURE);
+    }
+  }
+  for (int i = 0; i < num_threads; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  munmap((void *)analysis->data, analysis->size);
+  free(analysis->finished);
+}
+
+// stdin, pipes, compressed and imported traces: one pass through the simulator's parser
+static void analyze_parsed(Analysis_t *analysis, char *file_name, TraceFormat_t format) {
+  Parser_t *parser = parser_init(file_name, format, analysis->policy);
+  Profile_t *profile = profile_create();
+  MemoryRequest_t request;
+
+  while (parser_next_request(parser, UINT64_MAX, &request)) {
+    profile_add(profile, &request);
+  }
+
+  profile_merge(&analysis->total, profile, 0);
+  profile_destroy(profile);
+  parser_destroy(parser);
+}
+
+/*** report ***/
+static double percent(double part, double whole) {
+  return whole > 0.0 ? 100.0 * part / whole : 0.0;
+}
+
+static void print_histogram(const char *unit, double *histogram, double total) {
+  for (int i = 0; i < LOG_BUCKETS; i++) {
+    if (histogram[i] < 0.5) {
+      continue;
+    }
+    if (i == 0) {
+      printf("  %-26s %6.2lf%%\n", "0", percent(histogram[i], total));
+    }
+    else if (i == 1) {
+      char value[32];
+      snprintf(value, sizeof(value), "1 %s", unit);
+      printf("  %-26s %6.2lf%%\n", value, percent(histogram[i], total));
+    }
+    else {
+      char range[64];
+      snprintf(range, sizeof(range), "%" PRIu64 "-%" PRIu64 " %s", (uint64_t)1 << (i - 1), i == 64 ? UINT64_MAX : ((uint64_t)1 << i) - 1, unit);
+      printf("  %-26s %6.2lf%%\n", range, percent(histogram[i], total));
+    }
+  }
+}
+
+static void print_profile(Profile_t *profile, uint8_t num_ranks, TimeBase_t *time_base) {
+  uint64_t requests = profile->requests;
+  uint64_t hits = 0, conflicts = 0;
+  for (int i = 0; i < NUM_TRACE_BANKS; i++) {
+    hits += profile->banks[i].hits;
+    conflicts += profile->banks[i].conflicts;
+  }
+  uint64_t first_touches = requests - hits - conflicts;
+
+  printf("--- Trace ---\n");
+  printf("Requests: %" PRIu64 "\n", requests);
+  if (requests == 0) {
+    return;
+  }
+  printf("Time: CPU cycles %" PRIu64 " to %" PRIu64 "\n", profile->first_time, profile->last_time);
+  if (profile->out_of_order) {
+    printf("Out of order: %" PRIu64 " requests earlier than the one before them\n", profile->out_of_order);
+  }
+  printf("Reads: %.2lf%%  Writes: %.2lf%%  Instruction fetches: %.2lf%%  (read/write %.2lf)\n",
+         percent(profile->operations[DATA_READ], requests), percent(profile->operations[DATA_WRITE], requests),
+         percent(profile->operations[IFETCH], requests),
+         profile->operations[DATA_WRITE] ? (double)(profile->operations[DATA_READ] + profile->operations[IFETCH]) / profile->operations[DATA_WRITE] : 0.0);
+  printf("Footprint: ~%.0lf lines (%.1lf MB)\n", hll_estimate(profile->hll), hll_estimate(profile->hll) * BYTES_PER_LINE / (1 << 20));
+
+  printf("\n--- Cores ---\n");
+  printf("core  requests   share  reads%%  writes%%  fetch%%  req/kcycle  mean gap  gap CV\n");
+  for (int i = 0; i < NUM_CORES; i++) {
+    CoreProfile_t *core = &profile->cores[i];
+    if (core->requests == 0) {
+      continue;
+    }
+    uint64_t span = core->last_time - core->first_time + 1;
+    printf("%4d %9" PRIu64 " %6.2lf%% %6.2lf %7.2lf %7.2lf %11.3lf %9.1lf %7.2lf\n", i, core->requests, percent(core->requests, requests),
+           percent(core->operations[DATA_READ], core->requests), percent(core->operations[DATA_WRITE], core->requests),
+           percent(core->operations[IFETCH], core->requests), 1000.0 * core->requests / span, gap_mean(&core->gaps), gap_cv(&core->gaps));
+  }
+
+  printf("\n--- Arrivals ---\n");
+  printf("Mean gap: %.1lf CPU cycles, coefficient of variation %.2lf%s\n", gap_mean(&profile->gaps), gap_cv(&profile->gaps),
+         gap_cv(&profile->gaps) > 1.0 ? " (bursty)" : "");
+  double gap_histogram[LOG_BUCKETS];
+  for (int i = 0; i < LOG_BUCKETS; i++) {
+    gap_histogram[i] = profile->gap_histogram[i];
+  }
+  print_histogram("cycles", gap_histogram, profile->gaps.count);
+
+  printf("\n--- Banks (%u rank%s) ---\n", num_ranks, num_ranks > 1 ? "s" : "");
+  uint64_t max_bank = 0;
+  int used_banks = 0;
+  for (int rank = 0; rank < num_ranks; rank++) {
+    printf("rank %d bank groups:", rank);
+    for (int group = 0; group < NUM_BANK_GROUPS; group++) {
+      uint64_t accesses = 0;
+      for (int bank = 0; bank < NUM_BANKS_PER_GROUP; bank++) {
+        BankProfile_t *profile_bank = &profile->banks[(rank * NUM_BANK_GROUPS + group) * NUM_BANKS_PER_GROUP + bank];
+        accesses += profile_bank->accesses;
+        used_banks += profile_bank->accesses > 0;
+        if (profile_bank->accesses > max_bank) {
+          max_bank = profile_bank->accesses;
+        }
+      }
+      printf(" %5.2lf%%", percent(accesses, requests));
+    }
+    printf("\n");
+  }
+  double mean_bank = (double)requests / (num_ranks * NUM_BANKS);
+  printf("Banks used: %d of %d, busiest bank %.2lfx the mean\n", used_banks, num_ranks * NUM_BANKS, max_bank / mean_bank);
+
+  printf("\n--- Row Buffer (trace order) ---\n");
+  printf("Row hits: %.2lf%%  Row conflicts: %.2lf%%  First touches: %.2lf%%\n", percent(hits, requests), percent(conflicts, requests),
+         percent(first_touches, requests));
+  printf("Row hits within a %d-request queue: %.2lf%%\n", WINDOW_SIZE, percent(profile->window_hits, requests));
+  printf("Distinct banks in a %d-request queue: %.2lf\n", WINDOW_SIZE, (double)profile->window_banks / requests);
+
+  printf("\n--- Reuse Distance (sampled) ---\n");
+  double reuses = 0.0;
+  for (int i = 0; i < LOG_BUCKETS; i++) {
+    reuses += profile->reuse_histogram[i];
+  }
+  printf("Sample: 1 line in %u\n", SAMPLE_SPACE / profile->lines.threshold);
+  print_histogram("requests", profile->reuse_histogram, reuses + profile->cold_lines);
+  printf("  %-26s %6.2lf%%\n", "first touch", percent(profile->cold_lines, reuses + profile->cold_lines));
+
+  // a closed-page access keeps its bank busy for tRC; requests arriving faster than that queue up
+  double hit_rate = (double)hits / requests;
+  double conflict_rate = (double)conflicts / requests;
+  double window_hit_rate = (double)profile->window_hits / requests;
+  double bank_parallelism = (double)profile->window_banks / requests;
+  double service = (double)time_base_ps_to_dimm(time_base, TRC_PS) * time_base->cpu_per_tick / time_base->dimm_per_tick;
+  double mean_gap = gap_mean(&profile->gaps);
+  double in_flight = mean_gap > 0.0 ? service / mean_gap : WINDOW_SIZE;
+  bool queues_up = in_flight >= 1.0 || gap_cv(&profile->gaps) > 1.0;
+
+  bool open_page = hit_rate > conflict_rate;
+  bool bank_level = queues_up && bank_parallelism >= MIN_BANK_PARALLELISM;
+  bool reorder = queues_up && window_hit_rate >= hit_rate + REORDER_GAIN;
+  int level = reorder ? 3 : bank_level ? 2 : open_page ? 1 : 0;
+
+  printf("\n--- Prediction ---\n");
+  printf("%s: %.1lf%% row hits against %.1lf%% conflicts in trace order\n", open_page ? "Open page helps" : "Closed page is enough",
+         100.0 * hit_rate, 100.0 * conflict_rate);
+  printf("%s: ~%.1lf requests arrive per tRC (%.0lf CPU cycles), gap CV %.2lf\n", queues_up ? "Requests queue up" : "The queue stays short",
+         in_flight, service, gap_cv(&profile->gaps));
+  if (queues_up) {
+    printf("%s: %.2lf distinct banks per queue\n", bank_level ? "Bank-level parallelism helps" : "Few banks to overlap", bank_parallelism);
+    printf("%s: %.1lf%% row hits in the queue against %.1lf%% in order\n", reorder ? "Out-of-order scheduling helps" : "Reordering gains little",
+           100.0 * window_hit_rate, 100.0 * hit_rate);
+  }
+  printf("Suggested scheduling level: %d (%s)\n", level, level_names[level]);
+}
+
+/*** main ***/
+int main(int argc, char *argv[]) {
+  char *input_file = DEFAULT_INPUT_FILE;
+  int num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+  TraceFormat_t format = TRACE_NATIVE;
+  int policy = NUM_ADDRESS_POLICIES;
+  int num_ranks = 1;
+  uint32_t cpu_mhz = DEFAULT_CPU_MHZ;
+  uint32_t data_rate = DEFAULT_DATA_RATE;
+  int opt;
+
+  static struct option long_options[] = {
+    {"trace-format", required_argument, NULL, OPT_TRACE_FORMAT},
+    {"address-map", required_argument, NULL, OPT_ADDRESS_MAP},
+    {"ranks", required_argument, NULL, OPT_RANKS},
+    {"cpu-mhz", required_argument, NULL, OPT_CPU_MHZ},
+    {"data-rate", required_argument, NULL, OPT_DATA_RATE},
+    {"help", no_argument, NULL, 'h'},
+    {NULL, 0, NULL, 0}
+  };
+
+  while ((opt = getopt_long(argc, argv, "i:j:h", long_options, NULL)) != -1) {
+    switch (opt) {
+      case 'i':
+        input_file = optarg;
+        break;
+      case 'j':  // Worker threads
+        num_threads = atoi(optarg);
+        if (num_threads < 1) {
+          fprintf(stderr, "Invalid number of threads: %s.\n", optarg);
+          return EXIT_FAILURE;
+        }
+        break;
+      case OPT_TRACE_FORMAT:
+        if (trace_format_parse(optarg) < 0) {
+          fprintf(stderr, "Invalid trace format: %s. Must be native, ramulator, dramsim3, champsim or perf-mem.\n", optarg);
+          return EXIT_FAILURE;
+        }
+        format = trace_format_parse(optarg);
+        break;
+      case OPT_ADDRESS_MAP:
+        policy = address_policy_parse(optarg);
+        if (policy < 0) {
+          fprintf(stderr, "Invalid address map: %s. Must be reject, mask or fold.\n", optarg);
+          return EXIT_FAILURE;
+        }
+        break;
+      case OPT_RANKS:  // Ranks per channel, as --dimms x --ranks of the simulator
+        num_ranks = atoi(optarg);
+        if (num_ranks != 1 && num_ranks != 2 && num_ranks != 4) {
+          fprintf(stderr, "Invalid number of ranks: %s. Must be 1, 2 or 4.\n", optarg);
+          return EXIT_FAILURE;
+        }
+        break;
+      case OPT_CPU_MHZ:
+        cpu_mhz = strtoul(optarg, NULL, 10);
+        break;
+      case OPT_DATA_RATE:
+        data_rate = strtoul(optarg, NULL, 10);
+        break;
+      case 'h':
+      case '?':
+        fprintf(stderr, "Usage: %s [-i trace] [-j threads] [--trace-format native|ramulator|dramsim3|champsim|perf-mem]\n", argv[0]);
+        fprintf(stderr, "          [--address-map reject|mask|fold] [--ranks 1|2|4] [--cpu-mhz mhz] [--data-rate mts]\n");
+        return EXIT_FAILURE;
+    }
+  }
+
+  TimeBase_t time_base;
+  if (!time_base_init(&time_base, cpu_mhz, data_rate)) {
+    fprintf(stderr, "Invalid clocks: %u MHz CPU, DDR5-%u.\n", cpu_mhz, data_rate);
+    return EXIT_FAILURE;
+  }
+
+  Analysis_t analysis;
+  memset(&analysis, 0, sizeof(analysis));
+  if (policy == NUM_ADDRESS_POLICIES) {
+    policy = format == TRACE_NATIVE ? ADDRESS_REJECT : ADDRESS_FOLD;
+  }
+  analysis.policy = policy;
+  pthread_mutex_init(&analysis.lock, NULL);
+  for (int i = 0; i < NUM_TRACE_BANKS; i++) {
+    analysis.total.banks[i].first_row = NO_ROW;
+    analysis.total.banks[i].last_row = NO_ROW;
+  }
+  table_init(&analysis.total.lines, GLOBAL_LINES, INITIAL_SAMPLE_THRESHOLD);
+
+  memory_request_set_rank_bits(num_ranks == 4 ? 2 : num_ranks - 1);
+  if (format == TRACE_NATIVE && !input_stream_needed(input_file)) {
+    analyze_mapped(&analysis, input_file, num_threads);
+  }
+  else {
+    analyze_parsed(&analysis, input_file, format);
+  }
+
+  printf("Input File: %s\n", input_file);
+  print_profile(&analysis.total, num_ranks, &time_base);
+
+  free(analysis.total.lines.entries);
+  pthread_mutex_destroy(&analysis.lock);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,49 @@
+#!/bin/sh
+# Compare the generic build with the specialized build of one preset.
+#
+# usage: tools/bench.sh generic_binary specialized_binary preset [requests]
+#
+# Both binaries replay the same synthetic trace (tests/gen_trace.sh) under every
+# scheduling policy. The command output
+# has to be identical; the script reports the best of three run times of each
+# and the speedup.
+
+GENERIC=$1
+FAST=$2
+PRESET=$3
+REQUESTS=${4:-200000}
+
+if [ -z "$GENERIC" ] || [ -z "$FAST" ] || [ -z "$PRESET" ]; then
+  echo "usage: $0 generic_binary specialized_binary preset [requests]" >&2
+  exit 1
+fi
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+"$(dirname "$0")/../tests/gen_trace.sh" "$REQUESTS" > "$WORK/trace.txt"
+
+# best of three runs, in the seconds the program reports itself
+run() {
+  for i in 1 2 3; do
+    "$@" | awk '/Program Execution Time/ { print $4 }'
+  done | sort -n | head -n 1
+}
+
+echo "preset $PRESET, $REQUESTS requests"
+printf "%-14s %10s %10s %8s\n" "policy" "generic" "$PRESET" "speedup"
+
+status=0
+for policy in 0 1 2 3; do
+  generic=$(run "$GENERIC" --preset "$PRESET" --generic-engine -s $policy -i "$WORK/trace.txt" -o "$WORK/generic.txt")
+  fast=$(run "$FAST" -s $policy -i "$WORK/trace.txt" -o "$WORK/fast.txt")
+
+  if ! cmp -s "$WORK/generic.txt" "$WORK/fast.txt"; then
+    echo "policy $policy: the builds disagree" >&2
+    status=1
+  fi
+
+  printf "%-14s %9.3fs %9.3fs %7.2fx\n" "$policy" "$generic" "$fast" "$(awk -v g="$generic" -v f="$fast" 'BEGIN { print (f > 0 ? g / f : 0) }')"
+done
+
+exit $status
@@ -0,0 +1,400 @@
+/**
+ * @file  check_order.c
+ *
+ * @brief Checks a command trace against the trace it was simulated from: the
+ *        RD and WR commands to every 64-byte line have to come in the order
+ *        the line's reads and writes arrived, up to reads passing reads. A
+ *        read issued before an older write to its line (RAW) or a write
+ *        before an older read (WAR) is a violation, and so is a command with
+ *        no request left to serve or a request without a command.
+ *
+ *        usage: check_order [-i trace] [-c commands] [--trace-format format]
+ *                           [--address-map policy] [--ranks 1|2|4]
+ *
+ *        The commands are the text trace (-o, --output text) or a binary log
+ *        (--output binary), told apart by the binary header, which also gives
+ *        the ranks. A column command names the bank and column; the row is the
+ *        one its bank last activated. Two writes to a line carry no data in
+ *        the command trace, so their order (WAW) cannot be checked.
+ *
+ *        The run has to have issued exactly the trace's requests: prefetches,
+ *        sampled runs, epochs and restored runs do not check.
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include <getopt.h>
+#include "common.h"
+#include "config.h"
+#include "dimm.h"
+#include "output.h"
+#include "parser.h"
+
+/*** macro(s), enum(s), struct(s) ***/
+#define MAX_REPORTED_VIOLATIONS 10
+#define NO_ACCESS UINT32_MAX
+#define NO_ROW UINT32_MAX
+
+enum LongOptions {
+  OPT_TRACE_FORMAT = 256,
+  OPT_ADDRESS_MAP,
+  OPT_RANKS
+};
+
+typedef struct Access {
+  uint64_t time;   // arrival, CPU cycle
+  uint32_t next;   // next access to the same line, NO_ACCESS at the end
+  bool is_write;
+  bool is_matched;
+} Access_t;
+
+typedef struct LineOrder {
+  uint64_t line;   // line number + 1, 0 = empty slot
+  uint32_t first;  // oldest access without a command, NO_ACCESS when all are matched
+  uint32_t last;
+} LineOrder_t;
+
+typedef struct Checker {
+  Access_t *accesses;
+  uint32_t num_accesses;
+  uint32_t max_accesses;
+  LineOrder_t *lines;
+  uint64_t line_mask;  // slots - 1
+  uint64_t num_lines;
+  uint32_t open_rows[NUM_CHANNELS][MAX_RANKS_PER_CHANNEL][NUM_BANKS];
+
+  // report
+  uint64_t reads;
+  uint64_t writes;
+  uint64_t raw;
+  uint64_t war;
+  uint64_t unexpected;  // commands no request was left for
+  uint64_t reported;
+} Checker_t;
+
+/*** helper function(s) ***/
+static LineOrder_t *find_line(Checker_t *checker, uint64_t line) {
+  uint64_t slot = (line * 0x9E3779B97F4A7C15ULL) >> 20 & checker->line_mask;
+
+  while (checker->lines[slot].line != 0 && checker->lines[slot].line != line + 1) {
+    slot = (slot + 1) & checker->line_mask;
+  }
+
+  return &checker->lines[slot];
+}
+
+static void allocate_lines(Checker_t *checker, uint64_t slots) {
+  checker->line_mask = slots - 1;
+  checker->lines = calloc(slots, sizeof(LineOrder_t));
+  if (checker->lines == NULL) {
+    fprintf(stderr, "%s:%d: calloc failed\n", __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+}
+
+// keep the table at most half full, so probes stay short
+static void grow_lines(Checker_t *checker) {
+  LineOrder_t *old_lines = checker->lines;
+  uint64_t old_slots = checker->line_mask + 1;
+
+  allocate_lines(checker, old_slots * 2);
+  for (uint64_t i = 0; i < old_slots; i++) {
+    if (old_lines[i].line != 0) {
+      *find_line(checker, old_lines[i].line - 1) = old_lines[i];
+    }
+  }
+
+  free(old_lines);
+}
+
+static void add_access(Checker_t *checker, MemoryRequest_t *request) {
+  if (checker->num_accesses == checker->max_accesses) {
+    checker->max_accesses *= 2;
+    checker->accesses = realloc(checker->accesses, sizeof(Access_t) * checker->max_accesses);
+    if (checker->accesses == NULL) {
+      fprintf(stderr, "%s:%d: realloc failed\n", __FILE__, __LINE__);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  uint32_t index = checker->num_accesses++;
+  Access_t *access = &checker->accesses[index];
+  access->time = request->time;
+  access->next = NO_ACCESS;
+  access->is_write = request->operation == DATA_WRITE;
+  access->is_matched = false;
+
+  LineOrder_t *order = find_line(checker, memory_request_address(request) / BYTES_PER_LINE);
+  if (order->line == 0) {
+    if (2 * (checker->num_lines + 1) > checker->line_mask + 1) {
+      grow_lines(checker);
+      order = find_line(checker, memory_request_address(request) / BYTES_PER_LINE);
+    }
+    checker->num_lines++;
+    order->line = memory_request_address(request) / BYTES_PER_LINE + 1;
+    order->first = index;
+  }
+  else {
+    checker->accesses[order->last].next = index;
+  }
+  order->last = index;
+}
+
+static void read_trace(Checker_t *checker, char *input_file, TraceFormat_t format, AddressPolicy_t policy) {
+  Parser_t *parser = parser_init(input_file, format, policy);
+  MemoryRequest_t request;
+
+  checker->max_accesses = 1 << 16;
+  checker->accesses = malloc(sizeof(Access_t) * checker->max_accesses);
+  if (checker->accesses == NULL) {
+    fprintf(stderr, "%s:%d: malloc failed\n", __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  // read once, so stdin, pipes and compressed traces work; the line table grows as it fills
+  allocate_lines(checker, 1024);
+  checker->num_lines = 0;
+
+  while (parser_next_request(parser, UINT64_MAX, &request)) {
+    add_access(checker, &request);
+  }
+  parser_destroy(parser);
+}
+
+static void report(Checker_t *checker, const CommandRecord_t *record, uint64_t line, Access_t *older, const char *kind) {
+  if (checker->reported++ < MAX_REPORTED_VIOLATIONS) {
+    printf("%s: %s at DIMM cycle %" PRIu64 " to line 0x%" PRIx64 " before the %s that arrived at CPU cycle %" PRIu64 "\n", kind,
+           record->command == COMMAND_WR0 ? "WR" : "RD", (uint64_t)record->cycle, line, older->is_write ? "write" : "read", older->time);
+  }
+}
+
+static void check_command(Checker_t *checker, const CommandRecord_t *record) {
+  uint32_t *open_row = &checker->open_rows[record->channel][record->rank][record->bank_group * NUM_BANKS_PER_GROUP + record->bank];
+
+  if (record->command == COMMAND_ACT0) {
+    *open_row = record->address;
+    return;
+  }
+  if (record->command != COMMAND_RD0 && record->command != COMMAND_WR0) {
+    return;
+  }
+
+  bool is_write = record->command == COMMAND_WR0;
+  if (is_write) {
+    checker->writes++;
+  }
+  else {
+    checker->reads++;
+  }
+
+  // the line the command reads or writes, by the simulator's own mapping
+  MemoryRequest_t request;
+  memset(&request, 0, sizeof(MemoryRequest_t));
+  request.channel = record->channel;
+  request.rank = record->rank;
+  request.bank_group = record->bank_group;
+  request.bank = record->bank;
+  request.row = *open_row;
+  request.column_high = record->address >> 4;
+  request.column_low = record->address & 0xF;
+  uint64_t line = memory_request_address(&request) / BYTES_PER_LINE;
+
+  LineOrder_t *order = find_line(checker, line);
+  if (*open_row == NO_ROW || order->line == 0 || order->first == NO_ACCESS) {  // nothing left to serve on the line
+    checker->unexpected++;
+    return;
+  }
+
+  // the oldest unmatched access has to be of the same kind, any read may stand for another
+  Access_t *oldest = &checker->accesses[order->first];
+  if (oldest->is_write != is_write) {
+    if (is_write) {
+      checker->war++;
+      report(checker, record, line, oldest, "WAR");
+    }
+    else {
+      checker->raw++;
+      report(checker, record, line, oldest, "RAW");
+    }
+  }
+
+  // match the oldest access of the command's kind and go on from there
+  uint32_t index = order->first;
+  while (index != NO_ACCESS && (checker->accesses[index].is_matched || checker->accesses[index].is_write != is_write)) {
+    index = checker->accesses[index].next;
+  }
+  if (index == NO_ACCESS) {
+    checker->unexpected++;
+    return;
+  }
+  checker->accesses[index].is_matched = true;
+
+  while (order->first != NO_ACCESS && checker->accesses[order->first].is_matched) {
+    order->first = checker->accesses[order->first].next;
+  }
+}
+
+// returns whether the trace has a rank column
+static bool read_text(Checker_t *checker, FILE *file) {
+  char line[LINE_LENGTH];
+  bool shows_rank = false;
+
+  while (fgets(line, sizeof(line), file) != NULL) {
+    char fields[7][16];
+    int count = sscanf(line, "%15s %15s %15s %15s %15s %15s %15s", fields[0], fields[1], fields[2], fields[3], fields[4], fields[5],
+                       fields[6]);
+    if (count < 3) {
+      continue;
+    }
+
+    // with several ranks, the rank follows the channel
+    int name = 2;
+    if (fields[2][0] >= '0' && fields[2][0] <= '9') {
+      name = 3;
+      shows_rank = true;
+    }
+
+    // only the ACTs and the column commands matter
+    int command = -1;
+    for (int i = 0; i < NUM_COMMAND_CODES; i++) {
+      if (strcmp(fields[name], output_command_name(i)) == 0) {
+        command = i;
+      }
+    }
+    if (command != COMMAND_ACT0 && command != COMMAND_RD0 && command != COMMAND_WR0) {
+      continue;
+    }
+    if (count < name + 4) {
+      fprintf(stderr, "Error: malformed command: %s", line);
+      exit(EXIT_FAILURE);
+    }
+
+    CommandRecord_t record;
+    memset(&record, 0, sizeof(CommandRecord_t));
+    record.command = command;
+    record.cycle = strtoull(fields[0], NULL, 10);
+    record.channel = atoi(fields[1]);
+    record.rank = name == 3 ? atoi(fields[2]) : 0;
+    record.bank_group = atoi(fields[name + 1]);
+    record.bank = atoi(fields[name + 2]);
+    record.address = strtoul(fields[name + 3], NULL, 16);
+    check_command(checker, &record);
+  }
+
+  return shows_rank;
+}
+
+/*** main ***/
+int main(int argc, char *argv[]) {
+  char *input_file = DEFAULT_INPUT_FILE;
+  char *commands_file = DEFAULT_OUTPUT_FILE;
+  TraceFormat_t format = TRACE_NATIVE;
+  int policy = NUM_ADDRESS_POLICIES;
+  int num_ranks = 0;
+  int opt;
+
+  static struct option long_options[] = {
+    {"trace-format", required_argument, NULL, OPT_TRACE_FORMAT},
+    {"address-map", required_argument, NULL, OPT_ADDRESS_MAP},
+    {"ranks", required_argument, NULL, OPT_RANKS},
+    {"help", no_argument, NULL, 'h'},
+    {NULL, 0, NULL, 0}
+  };
+
+  while ((opt = getopt_long(argc, argv, "i:c:h", long_options, NULL)) != -1) {
+    switch (opt) {
+      case 'i':
+        input_file = optarg;
+        break;
+      case 'c':
+        commands_file = optarg;
+        break;
+      case OPT_TRACE_FORMAT:
+        if (trace_format_parse(optarg) < 0) {
+          fprintf(stderr, "Invalid trace format: %s. Must be native, ramulator, dramsim3, champsim or perf-mem.\n", optarg);
+          return EXIT_FAILURE;
+        }
+        format = trace_format_parse(optarg);
+        break;
+      case OPT_ADDRESS_MAP:
+        policy = address_policy_parse(optarg);
+        if (policy < 0) {
+          fprintf(stderr, "Invalid address map: %s. Must be reject, mask or fold.\n", optarg);
+          return EXIT_FAILURE;
+        }
+        break;
+      case OPT_RANKS:  // Ranks per channel, as --dimms x --ranks of the simulator
+        num_ranks = atoi(optarg);
+        if (num_ranks != 1 && num_ranks != 2 && num_ranks != 4) {
+          fprintf(stderr, "Invalid number of ranks: %s. Must be 1, 2 or 4.\n", optarg);
+          return EXIT_FAILURE;
+        }
+        break;
+      case 'h':
+      case '?':
+        fprintf(stderr, "Usage: %s [-i trace] [-c commands] [--trace-format native|ramulator|dramsim3|champsim|perf-mem]\n", argv[0]);
+        fprintf(stderr, "          [--address-map reject|mask|fold] [--ranks 1|2|4]\n");
+        return EXIT_FAILURE;
+    }
+  }
+
+  FILE *commands = fopen(commands_file, "rb");
+  if (commands == NULL) {
+    fprintf(stderr, "Error: cannot open %s\n", commands_file);
+    return EXIT_FAILURE;
+  }
+
+  // a binary log knows its ranks, the text trace only shows whether there is more than one
+  BinaryOutputHeader_t header;
+  bool is_binary = output_read_binary_header(commands, &header);
+  if (is_binary && num_ranks == 0) {
+    num_ranks = header.num_ranks;
+  }
+  if (!is_binary) {
+    rewind(commands);
+  }
+  if (num_ranks == 0) {
+    num_ranks = 1;
+  }
+
+  if (policy == NUM_ADDRESS_POLICIES) {
+    policy = format == TRACE_NATIVE ? ADDRESS_REJECT : ADDRESS_FOLD;
+  }
+  memory_request_set_rank_bits(num_ranks == 4 ? 2 : num_ranks - 1);
+
+  static Checker_t checker;
+  memset(checker.open_rows, 0xFF, sizeof(checker.open_rows));
+  read_trace(&checker, input_file, format, policy);
+
+  if (is_binary) {
+    CommandRecord_t record;
+    while (fread(&record, sizeof(CommandRecord_t), 1, commands) == 1) {
+      check_command(&checker, &record);
+    }
+  }
+  else if (read_text(&checker, commands) && num_ranks == 1) {
+    fprintf(stderr, "Error: %s has a rank column, pass --ranks\n", commands_file);
+    return EXIT_FAILURE;
+  }
+  fclose(commands);
+
+  uint64_t missing = 0;
+  for (uint32_t i = 0; i < checker.num_accesses; i++) {
+    missing += !checker.accesses[i].is_matched;
+  }
+
+  printf("Input File: %s\n", input_file);
+  printf("Commands File: %s (%s)\n", commands_file, is_binary ? "binary" : "text");
+  printf("Column Commands: %" PRIu64 " (%" PRIu64 " RD, %" PRIu64 " WR) for %u requests\n", checker.reads + checker.writes, checker.reads,
+         checker.writes, checker.num_accesses);
+  printf("Order Violations: %" PRIu64 " (RAW %" PRIu64 ", WAR %" PRIu64 ")\n", checker.raw + checker.war, checker.raw, checker.war);
+  printf("Unmatched: %" PRIu64 " commands without a request, %" PRIu64 " requests without a command\n", checker.unexpected, missing);
+
+  bool is_ok = checker.raw + checker.war + checker.unexpected + missing == 0;
+  printf("Result: %s\n", is_ok ? "OK" : "FAILED");
+
+  free(checker.accesses);
+  free(checker.lines);
+  return is_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
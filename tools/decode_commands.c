@@ -0,0 +1,69 @@
+/**
+ * @file  decode_commands.c
+ *
+ * @brief Turns a binary command log (--output binary) back into the text
+ *        command trace, line for line what --output text writes.
+ *
+ *        usage: decode_commands [binary_log [text_file]]
+ *
+ *        Either file defaults to stdin/stdout.
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "common.h"
+#include "output.h"
+
+#define RECORDS_PER_READ 4096
+
+int main(int argc, char *argv[]) {
+  FILE *input = stdin;
+  FILE *output = stdout;
+
+  if (argc > 3 || (argc > 1 && strcmp(argv[1], "-h") == 0)) {
+    fprintf(stderr, "Usage: %s [binary_log [text_file]]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  if (argc > 1 && strcmp(argv[1], "-") != 0) {
+    input = fopen(argv[1], "rb");
+    if (input == NULL) {
+      fprintf(stderr, "Error: cannot open %s\n", argv[1]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (argc > 2) {
+    output = fopen(argv[2], "w");
+    if (output == NULL) {
+      fprintf(stderr, "Error: cannot open %s\n", argv[2]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  BinaryOutputHeader_t header;
+  if (!output_read_binary_header(input, &header)) {
+    fprintf(stderr, "Error: not a version %d command log\n", BINARY_OUTPUT_VERSION);
+    return EXIT_FAILURE;
+  }
+
+  static CommandRecord_t records[RECORDS_PER_READ];
+  size_t count;
+
+  while ((count = fread(records, sizeof(CommandRecord_t), RECORDS_PER_READ, input)) > 0) {
+    for (size_t i = 0; i < count; i++) {
+      output_format_text(output, &records[i], header.num_ranks > 1);
+      fputc('\n', output);
+    }
+  }
+
+  if (ferror(input)) {
+    fprintf(stderr, "Error: reading the command log failed\n");
+    return EXIT_FAILURE;
+  }
+
+  fclose(input);
+  fclose(output);
+  return EXIT_SUCCESS;
+}